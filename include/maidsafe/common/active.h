@@ -19,31 +19,57 @@
 #ifndef MAIDSAFE_COMMON_ACTIVE_H_
 #define MAIDSAFE_COMMON_ACTIVE_H_
 
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
-#include <queue>
+#include <memory>
 #include <thread>
 
 #include "boost/thread/thread.hpp"
 
+#include "maidsafe/common/executor_stats.h"
+
 namespace maidsafe {
 
+// Runs the functors passed to Send, one at a time and in the order sent, on a single background
+// thread.  The destructor runs all functors sent before it was called and then joins the thread.
+//
+// Send is lock-free: functors are pushed onto an intrusive multi-producer, single-consumer queue
+// (after Dmitry Vyukov's design), which the background thread drains without locking.  A mutex and
+// condition variable are only used to wake the background thread once it has found the queue
+// empty and gone to sleep.
 class Active {
  public:
   typedef std::function<void()> Functor;
-  Active();
+  // If 'stats' is non-null, every functor sent is recorded in it (see executor_stats.h).
+  explicit Active(std::shared_ptr<ExecutorStats> stats = nullptr);
   ~Active();
   void Send(Functor functor);
+  // Returns nullptr if not instrumented.
+  std::shared_ptr<const ExecutorStats> Stats() const { return stats_; }
 
  private:
+  struct Node {
+    Node() : functor(), next(nullptr), queued_time() {}
+    explicit Node(Functor functor_in)
+        : functor(std::move(functor_in)), next(nullptr), queued_time() {}
+    Functor functor;
+    std::atomic<Node*> next;
+    ExecutorStats::Clock::time_point queued_time;  // Only set if instrumented.
+  };
+
   Active(const Active&);
   Active& operator=(const Active&);
   void Run();
-  // FIXME this should be atomic<bool> but clang is violently complaining !!
-  bool running_;
-  std::queue<Functor> functors_;
-  std::mutex flags_mutex_, mutex_;
+  bool Pop(Functor& functor, ExecutorStats::Clock::time_point& queued_time);
+  void Wait();
+
+  const std::shared_ptr<ExecutorStats> stats_;
+  std::atomic<bool> running_, waiting_;
+  std::atomic<Node*> tail_;  // The most recently pushed node; shared by all producers.
+  Node* head_;  // A dummy node preceding the next to be popped; only used by the consumer.
+  std::mutex mutex_;
   std::condition_variable condition_;
   boost::thread thread_;
 };
@@ -22,6 +22,7 @@
 #include <atomic>
 #include <cassert>
 #include <cstdint>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -31,21 +32,33 @@
 #include "boost/asio/io_service.hpp"
 
 #include "maidsafe/common/error.h"
+#include "maidsafe/common/executor_stats.h"
 #include "maidsafe/common/make_unique.h"
 #include "maidsafe/common/log.h"
+#include "maidsafe/common/thread_affinity.h"
 
 namespace maidsafe {
 
 template <typename IoServiceType>
 class IoService {
  public:
-  explicit IoService(size_t thread_count);
+  // If 'stats' is non-null, handlers passed to Post are recorded in it (see executor_stats.h).
+  explicit IoService(size_t thread_count, std::shared_ptr<ExecutorStats> stats = nullptr);
   ~IoService() { Stop(); }
   void Stop();
   IoServiceType& service() { return service_; }
   size_t ThreadCount() const { return thread_count_; }
 
+  // Equivalent to service().post(handler), other than for the instrumentation.  Handlers posted
+  // directly to service(), and the completion handlers of asynchronous operations, aren't
+  // recorded.
+  template <typename Handler>
+  void Post(Handler handler);
+  // Returns nullptr if not instrumented.
+  std::shared_ptr<const ExecutorStats> Stats() const { return stats_; }
+
  private:
+  const std::shared_ptr<ExecutorStats> stats_;
   std::atomic<size_t> thread_count_;
   IoServiceType service_;
   std::unique_ptr<typename IoServiceType::work> work_;
@@ -56,11 +69,39 @@ class IoService {
 using AsioService = IoService<asio::io_service>;
 using BoostAsioService = IoService<boost::asio::io_service>;
 
+// An alternative to a single IoService with many threads: 'thread_count' independent io_services,
+// each run by a single thread.  Handlers of objects created on one of these services (e.g. a
+// tcp::Connection) always run on the same thread, so don't contend with handlers on the others for
+// a shared queue and keep their data in that thread's cache.  Such an object doesn't need a strand
+// unless it is also used from outside its service.  If 'pin_threads' is true, the thread of
+// service i is pinned to CPU i (modulo the CPU count) where the platform supports it.
+template <typename IoServiceType>
+class IoServicePool {
+ public:
+  explicit IoServicePool(size_t thread_count, bool pin_threads = false);
+  void Stop();
+  size_t ThreadCount() const { return services_.size(); }
+  IoServiceType& service(size_t index) { return services_.at(index)->service(); }
+  // Returns each of the services in turn.
+  IoServiceType& NextService() { return service(next_service_++ % services_.size()); }
+  // Returns the same service for a given 'hash', e.g. to keep all objects relating to one peer on
+  // the same thread.
+  IoServiceType& ServiceFor(size_t hash) { return service(hash % services_.size()); }
+
+ private:
+  std::vector<std::unique_ptr<IoService<IoServiceType>>> services_;
+  std::atomic<size_t> next_service_;
+};
+
+using AsioServicePool = IoServicePool<asio::io_service>;
+using BoostAsioServicePool = IoServicePool<boost::asio::io_service>;
+
 
 
 template <typename IoServiceType>
-IoService<IoServiceType>::IoService(size_t thread_count)
-    : thread_count_(thread_count),
+IoService<IoServiceType>::IoService(size_t thread_count, std::shared_ptr<ExecutorStats> stats)
+    : stats_(std::move(stats)),
+      thread_count_(thread_count),
       service_(),
       work_(make_unique<typename IoServiceType::work>(service_)),
       threads_(),
@@ -81,6 +122,15 @@ IoService<IoServiceType>::IoService(size_t thread_count)
     });
 }
 
+template <typename IoServiceType>
+template <typename Handler>
+void IoService<IoServiceType>::Post(Handler handler) {
+  if (stats_)
+    service_.post(detail::InstrumentedHandler<Handler>(*stats_, std::move(handler)));
+  else
+    service_.post(std::move(handler));
+}
+
 template <typename IoServiceType>
 void IoService<IoServiceType>::Stop() {
   thread_count_ = 0U;
@@ -106,6 +156,32 @@ void IoService<IoServiceType>::Stop() {
   threads_.clear();
 }
 
+template <typename IoServiceType>
+IoServicePool<IoServiceType>::IoServicePool(size_t thread_count, bool pin_threads)
+    : services_(), next_service_(0) {
+  if (thread_count == 0)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  for (size_t i(0); i != thread_count; ++i)
+    services_.emplace_back(new IoService<IoServiceType>(1));
+  if (!pin_threads)
+    return;
+  std::vector<std::future<bool>> pinned;
+  for (size_t i(0); i != thread_count; ++i) {
+    auto pin(std::make_shared<std::packaged_task<bool()>>(
+        [i] { return PinCurrentThreadToCpu(static_cast<unsigned int>(i)); }));
+    pinned.push_back(pin->get_future());
+    service(i).post([pin] { (*pin)(); });
+  }
+  for (auto& result : pinned)
+    result.get();
+}
+
+template <typename IoServiceType>
+void IoServicePool<IoServiceType>::Stop() {
+  for (auto& service : services_)
+    service->Stop();
+}
+
 }  // namespace maidsafe
 
 #endif  // MAIDSAFE_COMMON_ASIO_SERVICE_H_
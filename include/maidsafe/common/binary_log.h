@@ -0,0 +1,293 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  An optional backend for LOG (enabled with the 'log_binary' option) which moves formatting off the
+  logging thread.  Instead of formatting each message into a string and posting it to an Active,
+  the logging thread copies the streamed values in a compact binary form, along with the level,
+  call site and time, into a ring buffer of its own.  A single background thread takes records
+  from every thread's ring, formats them and passes them on for output.
+
+  Values of arithmetic types, C strings, std::strings and manipulators like std::hex are copied as
+  they are and formatted later.  If a LOG statement streams a value of any other type, its whole
+  message is formatted immediately instead, and copied as a single string.  Either way the output
+  is the same as from the default backend.
+
+  Writing to a ring is lock-free, and when formatting is deferred, allocates nothing once the
+  thread's first few records have been written.  A record larger than a quarter of a ring is copied
+  to the heap and only a pointer to it is written to the ring.  If a ring is full, the record is
+  either dropped (and the number dropped is reported by the background thread in a warning) or the
+  writing thread waits for space, according to the OverflowPolicy.  Records from one thread are
+  output in the order written, but records from different threads may be interleaved differently.
+
+  The background thread sleeps while every ring is empty.  A writer only takes the lock to wake it
+  when writing into a ring which the background thread had emptied and it is asleep.
+*/
+
+#ifndef MAIDSAFE_COMMON_BINARY_LOG_H_
+#define MAIDSAFE_COMMON_BINARY_LOG_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <ios>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "boost/thread/tss.hpp"
+
+namespace maidsafe {
+
+namespace log {
+
+namespace detail {
+
+class CallSiteFile;
+
+enum class ArgumentType : unsigned char {
+  kBool,
+  kChar,
+  kInt16,
+  kUint16,
+  kInt32,
+  kUint32,
+  kInt64,
+  kUint64,
+  kDouble,
+  kString,
+  kManipulator
+};
+
+using Manipulator = std::ios_base& (*)(std::ios_base&);
+
+// Appends streamed values in binary form to a buffer.
+class ArgumentWriter {
+ public:
+  explicit ArgumentWriter(std::vector<char>& buffer) : buffer_(buffer) {}
+
+  void Write(bool value) { Append(ArgumentType::kBool, value); }
+  void Write(char value) { Append(ArgumentType::kChar, value); }
+  void Write(std::int16_t value) { Append(ArgumentType::kInt16, value); }
+  void Write(std::uint16_t value) { Append(ArgumentType::kUint16, value); }
+  void Write(std::int32_t value) { Append(ArgumentType::kInt32, value); }
+  void Write(std::uint32_t value) { Append(ArgumentType::kUint32, value); }
+  void Write(std::int64_t value) { Append(ArgumentType::kInt64, value); }
+  void Write(std::uint64_t value) { Append(ArgumentType::kUint64, value); }
+  void Write(double value) { Append(ArgumentType::kDouble, value); }
+  void Write(Manipulator value) { Append(ArgumentType::kManipulator, value); }
+  void Write(const char* data, std::size_t size) {
+    Append(ArgumentType::kString, static_cast<std::uint32_t>(size));
+    buffer_.insert(buffer_.end(), data, data + static_cast<std::uint32_t>(size));
+  }
+
+ private:
+  template <typename T>
+  void Append(ArgumentType type, T value) {
+    buffer_.push_back(static_cast<char>(type));
+    const char* const bytes(reinterpret_cast<const char*>(&value));
+    buffer_.insert(buffer_.end(), bytes, bytes + sizeof(value));
+  }
+
+  std::vector<char>& buffer_;
+};
+
+// Streams the values written by an ArgumentWriter to 'out'.
+void DecodeArguments(const char* data, std::size_t size, std::ostream& out);
+
+// Whether a value of type T can be copied for formatting later: arithmetic types (other than long
+// double, which a double can't hold), strings and std::ios_base manipulators such as std::hex.
+template <typename T>
+struct IsDeferrable
+    : std::integral_constant<bool, std::is_arithmetic<T>::value &&
+                                       !std::is_same<T, long double>::value> {};
+template <>
+struct IsDeferrable<const char*> : std::true_type {};
+template <>
+struct IsDeferrable<char*> : std::true_type {};
+template <std::size_t Size>
+struct IsDeferrable<char[Size]> : std::true_type {};
+template <>
+struct IsDeferrable<std::string> : std::true_type {};
+template <>
+struct IsDeferrable<std::ios_base&(std::ios_base&)> : std::true_type {};
+
+// Integers are copied at their own width, since that affects how negative values are formatted
+// in hex or octal.
+template <typename T>
+struct FixedWidthInteger {
+  using Signed = typename std::conditional<
+      sizeof(T) <= 2, std::int16_t,
+      typename std::conditional<sizeof(T) <= 4, std::int32_t, std::int64_t>::type>::type;
+  using type = typename std::conditional<std::is_signed<T>::value, Signed,
+                                         typename std::make_unsigned<Signed>::type>::type;
+};
+
+template <typename T>
+void EncodeArithmetic(ArgumentWriter& writer, T value, std::true_type /*integral*/) {
+  writer.Write(static_cast<typename FixedWidthInteger<T>::type>(value));
+}
+
+template <typename T>
+void EncodeArithmetic(ArgumentWriter& writer, T value, std::false_type /*integral*/) {
+  writer.Write(static_cast<double>(value));
+}
+
+template <typename T>
+void EncodeArgument(ArgumentWriter& writer, const T& value) {
+  static_assert(IsDeferrable<T>::value, "Only deferrable values can be encoded.");
+  EncodeArithmetic(writer, value, std::is_integral<T>());
+}
+
+inline void EncodeArgument(ArgumentWriter& writer, bool value) { writer.Write(value); }
+
+// As for std::ostream, signed and unsigned chars are written as characters.
+inline void EncodeArgument(ArgumentWriter& writer, char value) { writer.Write(value); }
+inline void EncodeArgument(ArgumentWriter& writer, signed char value) {
+  writer.Write(static_cast<char>(value));
+}
+inline void EncodeArgument(ArgumentWriter& writer, unsigned char value) {
+  writer.Write(static_cast<char>(value));
+}
+
+inline void EncodeArgument(ArgumentWriter& writer, const char* value) {
+  writer.Write(value, std::strlen(value));
+}
+
+inline void EncodeArgument(ArgumentWriter& writer, char* value) {
+  writer.Write(value, std::strlen(value));
+}
+
+inline void EncodeArgument(ArgumentWriter& writer, const std::string& value) {
+  writer.Write(value.data(), value.size());
+}
+
+inline void EncodeArgument(ArgumentWriter& writer, Manipulator value) { writer.Write(value); }
+
+// A record as passed to the output functor.
+struct BinaryLogEntry {
+  int level;
+  std::thread::id thread_id;
+  std::chrono::system_clock::time_point time;
+  std::string project;
+  // As for the string passed to LogMessage::Log: the file, the streamed values and a newline.
+  std::string message;
+};
+
+class BinaryLog {
+ public:
+  enum class OverflowPolicy { kDrop, kBlock };
+  using Output = std::function<void(const BinaryLogEntry&)>;
+
+  // 'output' is called on the background thread for each record in turn.  'ring_capacity' is the
+  // size in bytes of each thread's ring, rounded up to a power of two.
+  BinaryLog(Output output, std::size_t ring_capacity, OverflowPolicy overflow_policy);
+  // Outputs every record already written, then stops the background thread.  No thread may write
+  // concurrently with or after destruction.
+  ~BinaryLog();
+  BinaryLog(const BinaryLog&) = delete;
+  BinaryLog& operator=(const BinaryLog&) = delete;
+
+  // 'call_site_file' and 'file' must remain valid until the record has been output.
+  template <typename Binder>
+  void Write(int level, CallSiteFile& call_site_file, const char* file, const Binder& binder);
+
+  // Blocks until every record written by this thread before the call has been output.  Does
+  // nothing if called from the background thread.
+  void Flush();
+
+  // The number of records dropped since construction because a ring was full.
+  std::uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  class Ring;
+  struct RecordHeader;
+
+  // Owned by a thread which has written to this log, and destroyed when the thread exits.
+  struct Producer {
+    Producer(std::uint64_t instance_in, std::shared_ptr<Ring> ring_in);
+    ~Producer();
+    const std::uint64_t instance;
+    const std::shared_ptr<Ring> ring;
+    std::vector<char> payload;
+  };
+
+  template <typename Binder>
+  static void Encode(ArgumentWriter& writer, const Binder& binder, std::true_type /*deferrable*/) {
+    binder.Encode(writer);
+  }
+  template <typename Binder>
+  static void Encode(ArgumentWriter& writer, const Binder& binder, std::false_type /*deferrable*/) {
+    // Format everything now, so that any manipulators apply to the values following them.
+    std::ostringstream out;
+    out << binder;
+    const std::string formatted(out.str());
+    writer.Write(formatted.data(), formatted.size());
+  }
+
+  Producer& GetProducer();
+  void WriteRecord(Producer& producer, int level, CallSiteFile& call_site_file, const char* file);
+  // Wakes the background thread if it's waiting for records.
+  void Wake();
+  void Run();
+  // Outputs every record in 'rings', returning false if there were none.
+  bool Drain(const std::vector<std::shared_ptr<Ring>>& rings, bool& closed_ring_drained);
+  bool AllEmpty(const std::vector<std::shared_ptr<Ring>>& rings) const;
+  void ReportDropped(std::uint64_t& reported) const;
+
+  const Output kOutput_;
+  const std::size_t kRingCapacity_;
+  const OverflowPolicy kOverflowPolicy_;
+  // Distinguishes this instance's Producers from those of a destroyed instance at the same address.
+  const std::uint64_t kInstance_;
+  boost::thread_specific_ptr<Producer> producer_;
+  std::atomic<std::uint64_t> dropped_;
+  // Set by the background thread while it's waiting, or about to wait, on 'condition_'.
+  std::atomic<bool> idle_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+  bool rings_changed_, stopping_;
+  std::uint64_t flush_requests_, flushes_completed_;
+  std::mutex mutex_;
+  std::condition_variable condition_, flushed_condition_;
+  std::thread thread_;
+};
+
+template <typename Binder>
+void BinaryLog::Write(int level, CallSiteFile& call_site_file, const char* file,
+                      const Binder& binder) {
+  Producer& producer(GetProducer());
+  producer.payload.clear();
+  ArgumentWriter writer(producer.payload);
+  Encode(writer, binder, IsDeferrable<Binder>());
+  WriteRecord(producer, level, call_site_file, file);
+}
+
+}  // namespace detail
+
+}  // namespace log
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_BINARY_LOG_H_
@@ -48,6 +48,21 @@ struct Clock {
   static time_point from_time_t(std::time_t);
 };
 
+// Steady clock which is cheaper to read than std::chrono::steady_clock, at the cost of resolution:
+// on Linux it uses CLOCK_MONOTONIC_COARSE, which is typically only updated every 1 to 10
+// milliseconds.  Elsewhere it is just std::chrono::steady_clock.  Its time_points are
+// interchangeable with std::chrono::steady_clock's.
+struct CoarseSteadyClock {
+  typedef std::chrono::steady_clock::duration duration;
+  typedef duration::rep rep;
+  typedef duration::period period;
+  typedef std::chrono::steady_clock::time_point time_point;
+
+  static const bool is_steady = true;
+
+  static time_point now() MAIDSAFE_NOEXCEPT;
+};
+
 namespace common {
 using Clock = maidsafe::Clock;
 }  // namespace common
@@ -0,0 +1,89 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_CACHE_EXPIRY_TIMER_H_
+#define MAIDSAFE_COMMON_CONTAINERS_CACHE_EXPIRY_TIMER_H_
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+#include "asio/steady_timer.hpp"
+
+#include "maidsafe/common/asio_service.h"
+
+namespace maidsafe {
+
+// Calls 'cache.RemoveExpired()' every 'interval' on one of the AsioService's threads, so that a
+// cache which is no longer being added to or read from still releases its expired entries.
+//
+// LruCache isn't thread-safe, so if the cache is an LruCache, all other uses of it must also run
+// on the AsioService's single thread (or be otherwise serialised with the timer).  A
+// ConcurrentLruCache may be used from any thread.  The destructor waits for any call to
+// RemoveExpired in progress, after which the cache is no longer touched.
+template <typename Cache>
+class CacheExpiryTimer {
+ public:
+  CacheExpiryTimer(AsioService& asio_service, Cache& cache,
+                   std::chrono::steady_clock::duration interval)
+      : state_(std::make_shared<State>(asio_service, cache, interval)) {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    Schedule(state_);
+  }
+
+  ~CacheExpiryTimer() {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->cache = nullptr;
+    state_->timer.cancel();
+  }
+
+  CacheExpiryTimer(const CacheExpiryTimer&) = delete;
+  CacheExpiryTimer(CacheExpiryTimer&&) = delete;
+  CacheExpiryTimer& operator=(const CacheExpiryTimer&) = delete;
+  CacheExpiryTimer& operator=(CacheExpiryTimer&&) = delete;
+
+ private:
+  // Shared with the pending handler, which may outlive this object.
+  struct State {
+    State(AsioService& asio_service, Cache& cache_in,
+          std::chrono::steady_clock::duration interval_in)
+        : mutex(), cache(&cache_in), timer(asio_service.service()), interval(interval_in) {}
+    std::mutex mutex;
+    Cache* cache;
+    asio::steady_timer timer;
+    const std::chrono::steady_clock::duration interval;
+  };
+
+  // Must be called with 'state->mutex' locked.
+  static void Schedule(const std::shared_ptr<State>& state) {
+    state->timer.expires_from_now(state->interval);
+    state->timer.async_wait([state](const std::error_code& error) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (error || !state->cache)
+        return;
+      state->cache->RemoveExpired();
+      Schedule(state);
+    });
+  }
+
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_CACHE_EXPIRY_TIMER_H_
@@ -0,0 +1,293 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  A thread-safe LruCache.  The key space is split into a number of shards, each of which is an
+  LruCache protected by its own mutex, so threads working on different keys rarely contend.
+
+  The capacity (or maximum weight) is divided evenly between the shards and each shard evicts its
+  own least recently used entries, so eviction order is only approximately LRU across the whole
+  cache: an entry may be evicted while an older entry in a less busy shard survives.  Similarly, an
+  entry heavier than its shard's share of the maximum weight is not added.  The time_to_live applies
+  exactly as for LruCache; RemoveExpired may be called from any thread.
+
+  By default there are four shards per hardware thread, but never more shards than the capacity.
+  A weight-limited cache is given a 'max_entry_weight' (by default half the maximum weight) and by
+  default has no more shards than leave each shard's share at least that heavy, so any entry up to
+  max_entry_weight can be cached.  Passing a realistic max_entry_weight (e.g. the maximum chunk
+  size) allows more shards and so less contention.
+
+  Keys are assigned to shards by hash, so if no Hash is given and std::hash doesn't support
+  KeyType (see LruCache), there is only a single shard.
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_CONCURRENT_LRU_CACHE_H_
+#define MAIDSAFE_COMMON_CONTAINERS_CONCURRENT_LRU_CACHE_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "boost/expected/expected.hpp"
+
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/containers/lru_cache.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename Policy>
+class ConcurrentLruCacheBase {
+ public:
+  virtual ~ConcurrentLruCacheBase() = default;
+  ConcurrentLruCacheBase(const ConcurrentLruCacheBase&) = delete;
+  ConcurrentLruCacheBase(ConcurrentLruCacheBase&&) = delete;
+  ConcurrentLruCacheBase& operator=(const ConcurrentLruCacheBase&) = delete;
+  ConcurrentLruCacheBase& operator=(ConcurrentLruCacheBase&&) = delete;
+
+  bool Check(const KeyType& key) const {
+    Shard& shard(ShardFor(key));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.cache.Check(key);
+  }
+
+  // Sum of the shards' sizes; only a snapshot if other threads are modifying the cache.
+  size_t size() const {
+    size_t total(0);
+    for (const auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      total += shard->cache.size();
+    }
+    return total;
+  }
+
+  // Sum of the shards' weights; only a snapshot if other threads are modifying the cache.
+  MemoryUsage weight() const {
+    std::uint64_t total(0);
+    for (const auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      total += shard->cache.weight();
+    }
+    return MemoryUsage(total);
+  }
+
+  size_t shard_count() const { return shards_.size(); }
+
+  void RemoveExpired() {
+    for (const auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      shard->cache.RemoveExpired();
+    }
+  }
+
+ protected:
+  struct Shard {
+    template <typename... Args>
+    explicit Shard(Args&&... args) : mutex(), cache(std::forward<Args>(args)...) {}
+    mutable std::mutex mutex;
+    LruCache<KeyType, ValueType, Hash, KeyEqual, Policy> cache;
+  };
+
+  // Shares 'limit' (the capacity or maximum weight) between the shards, passing each share to
+  // 'make_shard'.  A limit of std::numeric_limits<std::uint64_t>::max() means unlimited.  A
+  // 'shard_count' of zero selects DefaultShardCount(); either way there are never more than
+  // 'max_shard_count' shards, nor more than one if keys aren't hashed.
+  template <typename MakeShard>
+  ConcurrentLruCacheBase(std::uint64_t limit, size_t shard_count, std::uint64_t max_shard_count,
+                         MakeShard make_shard)
+      : hash_(), shards_() {
+    if (shard_count == 0)
+      shard_count = DefaultShardCount();
+    if (std::is_same<Hash, OrderedKeys>::value)
+      max_shard_count = 1;
+    shard_count = static_cast<size_t>(
+        std::max<std::uint64_t>(std::min<std::uint64_t>(shard_count, max_shard_count), 1));
+    shards_.reserve(shard_count);
+    for (size_t i(0); i != shard_count; ++i) {
+      // Give any remainder to the first shards.
+      shards_.emplace_back(make_shard(limit == std::numeric_limits<std::uint64_t>::max()
+                                          ? limit
+                                          : limit / shard_count + (i < limit % shard_count)));
+    }
+  }
+
+  static size_t DefaultShardCount() {
+    return kShardsPerThread_ * std::max(std::thread::hardware_concurrency(), 2U);
+  }
+
+  Shard& ShardFor(const KeyType& key) const {
+    // Each shard's hash table indexes on the top bits of the same multiplicative mix, so pick the
+    // shard using the middle bits.
+    const std::uint64_t mixed(static_cast<std::uint64_t>(hash_(key)) * 0x9e3779b97f4a7c15ULL);
+    return *shards_[static_cast<size_t>((mixed >> 32) % shards_.size())];
+  }
+
+ private:
+  static const unsigned kShardsPerThread_ = 4;
+
+  const Hash hash_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}  // namespace detail
+
+// Thread-safe, sharded, fixed-size (by number of records or total weight) and / or time_to_live
+// LRU-replacement cache.  A 'shard_count' of zero selects the default.
+template <typename KeyType, typename ValueType,
+          typename Hash = typename detail::DefaultLruHash<KeyType>::type,
+          typename KeyEqual = std::equal_to<KeyType>, typename Policy = LruPolicy>
+class ConcurrentLruCache
+    : public detail::ConcurrentLruCacheBase<KeyType, ValueType, Hash, KeyEqual, Policy> {
+  using Base = detail::ConcurrentLruCacheBase<KeyType, ValueType, Hash, KeyEqual, Policy>;
+  using Shard = typename Base::Shard;
+
+ public:
+  using Weigher = typename LruCache<KeyType, ValueType, Hash, KeyEqual, Policy>::Weigher;
+
+  explicit ConcurrentLruCache(size_t capacity, size_t shard_count = 0)
+      : ConcurrentLruCache(capacity, std::chrono::steady_clock::duration::zero(), shard_count) {}
+
+  explicit ConcurrentLruCache(std::chrono::steady_clock::duration time_to_live,
+                              size_t shard_count = 0)
+      : Base(std::numeric_limits<std::uint64_t>::max(), shard_count,
+             std::numeric_limits<std::uint64_t>::max(),
+             [&](std::uint64_t) { return new Shard(time_to_live); }) {}
+
+  ConcurrentLruCache(size_t capacity, std::chrono::steady_clock::duration time_to_live,
+                     size_t shard_count = 0)
+      : Base(capacity, shard_count, capacity, [&](std::uint64_t share) {
+          return new Shard(static_cast<size_t>(share), time_to_live);
+        }) {}
+
+  ConcurrentLruCache(MemoryUsage max_weight, Weigher weigher, size_t shard_count = 0)
+      : ConcurrentLruCache(max_weight, std::move(weigher),
+                           std::chrono::steady_clock::duration::zero(), shard_count) {}
+
+  ConcurrentLruCache(MemoryUsage max_weight, Weigher weigher,
+                     std::chrono::steady_clock::duration time_to_live, size_t shard_count = 0)
+      : ConcurrentLruCache(max_weight, MemoryUsage(max_weight.data / 2), std::move(weigher),
+                           time_to_live, shard_count) {}
+
+  ConcurrentLruCache(MemoryUsage max_weight, MemoryUsage max_entry_weight, Weigher weigher,
+                     size_t shard_count = 0)
+      : ConcurrentLruCache(max_weight, max_entry_weight, std::move(weigher),
+                           std::chrono::steady_clock::duration::zero(), shard_count) {}
+
+  ConcurrentLruCache(MemoryUsage max_weight, MemoryUsage max_entry_weight, Weigher weigher,
+                     std::chrono::steady_clock::duration time_to_live, size_t shard_count = 0)
+      : Base(max_weight,
+             shard_count != 0 ? shard_count
+                              : static_cast<size_t>(std::min<std::uint64_t>(
+                                    Base::DefaultShardCount(),
+                                    max_weight.data / std::max<std::uint64_t>(
+                                                          max_entry_weight.data, 1))),
+             max_weight, [&](std::uint64_t share) {
+               return new Shard(MemoryUsage(share), weigher, time_to_live);
+             }) {}
+
+  virtual ~ConcurrentLruCache() = default;
+  ConcurrentLruCache(const ConcurrentLruCache&) = delete;
+  ConcurrentLruCache(ConcurrentLruCache&&) = delete;
+  ConcurrentLruCache& operator=(const ConcurrentLruCache&) = delete;
+  ConcurrentLruCache& operator=(ConcurrentLruCache&&) = delete;
+
+  boost::expected<ValueType, maidsafe_error> Get(const KeyType& key) {
+    auto& shard(this->ShardFor(key));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.cache.Get(key);
+  }
+
+  // As LruCache::Visit; 'functor' is called with the shard's lock held, so should be brief and
+  // must not use this cache.  There is no GetPtr, as the value may be evicted by another thread as
+  // soon as the lock is released; to share large values without copying them, use a ValueType of
+  // std::shared_ptr<const T>.
+  template <typename Functor>
+  bool Visit(const KeyType& key, Functor functor) {
+    auto& shard(this->ShardFor(key));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.cache.Visit(key, std::move(functor));
+  }
+
+  bool TryGet(const KeyType& key, ValueType& value) {
+    auto& shard(this->ShardFor(key));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.cache.TryGet(key, value);
+  }
+
+  void Add(KeyType key, ValueType value) {
+    auto& shard(this->ShardFor(key));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.cache.Add(std::move(key), std::move(value));
+  }
+
+  void Delete(const KeyType& key) {
+    auto& shard(this->ShardFor(key));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.cache.Delete(key);
+  }
+};
+
+// Thread-safe, sharded, fixed-size (by number of records) and / or time_to_live LRU-replacement
+// filter
+template <typename KeyType, typename Hash, typename KeyEqual, typename Policy>
+class ConcurrentLruCache<KeyType, void, Hash, KeyEqual, Policy>
+    : public detail::ConcurrentLruCacheBase<KeyType, void, Hash, KeyEqual, Policy> {
+  using Base = detail::ConcurrentLruCacheBase<KeyType, void, Hash, KeyEqual, Policy>;
+  using Shard = typename Base::Shard;
+
+ public:
+  explicit ConcurrentLruCache(size_t capacity, size_t shard_count = 0)
+      : ConcurrentLruCache(capacity, std::chrono::steady_clock::duration::zero(), shard_count) {}
+
+  explicit ConcurrentLruCache(std::chrono::steady_clock::duration time_to_live,
+                              size_t shard_count = 0)
+      : Base(std::numeric_limits<std::uint64_t>::max(), shard_count,
+             std::numeric_limits<std::uint64_t>::max(),
+             [&](std::uint64_t) { return new Shard(time_to_live); }) {}
+
+  ConcurrentLruCache(size_t capacity, std::chrono::steady_clock::duration time_to_live,
+                     size_t shard_count = 0)
+      : Base(capacity, shard_count, capacity, [&](std::uint64_t share) {
+          return new Shard(static_cast<size_t>(share), time_to_live);
+        }) {}
+
+  virtual ~ConcurrentLruCache() = default;
+  ConcurrentLruCache(const ConcurrentLruCache&) = delete;
+  ConcurrentLruCache(ConcurrentLruCache&&) = delete;
+  ConcurrentLruCache& operator=(const ConcurrentLruCache&) = delete;
+  ConcurrentLruCache& operator=(ConcurrentLruCache&&) = delete;
+
+  void Add(KeyType key) {
+    auto& shard(this->ShardFor(key));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.cache.Add(std::move(key));
+  }
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_CONCURRENT_LRU_CACHE_H_
@@ -0,0 +1,111 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  A Bloom filter which supports removal by holding an 8-bit counter rather than a single bit per
+  slot.  MightContain never returns false for a key which has been added more times than removed,
+  and returns false for most other keys.  With 8 counters per expected key and 4 hash functions, the
+  false positive rate is around 2.5% when the expected number of keys are held.
+
+  A counter which reaches 255 is never decremented again, since its true count is then unknown; this
+  can only cause extra false positives.  Removing a key which isn't held corrupts the filter, so
+  the caller must only remove keys it has previously added.
+
+  All functions are lock-free and may be called concurrently.  A call to MightContain racing with
+  Add or Remove for the same key may return either result.
+
+  Research links
+  http://pages.cs.wisc.edu/~jussara/papers/00ton.pdf (Summary Cache, introducing counting filters)
+  https://www.eecs.harvard.edu/~michaelm/postscripts/rsa2008.pdf (Less Hashing, Same Performance)
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_COUNTING_BLOOM_FILTER_H_
+#define MAIDSAFE_COMMON_CONTAINERS_COUNTING_BLOOM_FILTER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace maidsafe {
+
+template <typename Key, typename Hash = std::hash<Key>>
+class CountingBloomFilter {
+ public:
+  explicit CountingBloomFilter(std::size_t expected_keys, Hash hash = Hash())
+      : hash_(std::move(hash)),
+        counter_count_(std::max<std::size_t>(expected_keys, 8) * kCountersPerKey_),
+        counters_(new std::atomic<std::uint8_t>[counter_count_]) {
+    for (std::size_t i(0); i != counter_count_; ++i)
+      counters_[i].store(0, std::memory_order_relaxed);
+  }
+
+  CountingBloomFilter(const CountingBloomFilter&) = delete;
+  CountingBloomFilter& operator=(const CountingBloomFilter&) = delete;
+
+  void Add(const Key& key) {
+    const std::uint64_t hash(hash_(key));
+    for (unsigned i(0); i != kHashCount_; ++i) {
+      std::atomic<std::uint8_t>& counter(counters_[Slot(hash, i)]);
+      std::uint8_t count(counter.load(std::memory_order_relaxed));
+      while (count != kSaturated_ && !counter.compare_exchange_weak(count, count + 1)) {
+      }
+    }
+  }
+
+  void Remove(const Key& key) {
+    const std::uint64_t hash(hash_(key));
+    for (unsigned i(0); i != kHashCount_; ++i) {
+      std::atomic<std::uint8_t>& counter(counters_[Slot(hash, i)]);
+      std::uint8_t count(counter.load(std::memory_order_relaxed));
+      while (count != kSaturated_ && count != 0 &&
+             !counter.compare_exchange_weak(count, count - 1)) {
+      }
+    }
+  }
+
+  bool MightContain(const Key& key) const {
+    const std::uint64_t hash(hash_(key));
+    for (unsigned i(0); i != kHashCount_; ++i) {
+      if (counters_[Slot(hash, i)].load(std::memory_order_acquire) == 0)
+        return false;
+    }
+    return true;
+  }
+
+ private:
+  static const unsigned kHashCount_ = 4;
+  static const std::size_t kCountersPerKey_ = 8;
+  static const std::uint8_t kSaturated_ = 255;
+
+  // Derives each slot from two halves of a single hash (Kirsch & Mitzenmacher).
+  std::size_t Slot(std::uint64_t hash, unsigned i) const {
+    const std::uint64_t first(hash), second((hash >> 32) | 1);
+    return static_cast<std::size_t>((first + i * second) % counter_count_);
+  }
+
+  const Hash hash_;
+  const std::size_t counter_count_;
+  std::unique_ptr<std::atomic<std::uint8_t>[]> counters_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_COUNTING_BLOOM_FILTER_H_
@@ -0,0 +1,375 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  Eviction policies for LruCache.  A policy orders the cache's entries and chooses which to evict
+  when the cache is full.  Each is constructed with the cache's limit (its capacity, or maximum
+  weight for a weighted cache) and provides:
+
+    void Insert(detail::PolicyHook* entry);  // 'entry' has just been added
+    void Access(detail::PolicyHook* entry);  // 'entry' has just been read
+    void Remove(detail::PolicyHook* entry);  // 'entry' is being deleted or has expired
+    detail::PolicyHook* Victim();            // returns the entry to evict next (cache not empty)
+    void Evict(detail::PolicyHook* entry);   // 'entry', the last Victim, is being evicted
+
+  LruPolicy evicts the least recently used entry.  The others resist a scan of once-used keys
+  flushing the frequently used ones from the cache:
+
+  TwoQueuePolicy (2Q) holds new entries in a FIFO queue using a quarter of the limit.  Entries
+  evicted from that queue are remembered by hash; if re-added soon after, they go straight to the
+  main LRU queue.
+
+  ArcPolicy (Adaptive Replacement Cache) splits the cache between entries seen once and entries
+  seen more than once, and adapts the split using the hashes of recently evicted entries.
+
+  TinyLfuPolicy (W-TinyLFU) admits new entries to a small LRU window using 1% of the limit.  An
+  entry leaving the window only displaces the main cache's victim if it is estimated (using a
+  FrequencySketch) to have been used more often.  The main cache is a segmented LRU, with 80% of
+  its space for entries used more than once.
+
+  The policies only hold the hashes of evicted keys, so two keys with equal hashes may be confused;
+  this only affects the hit ratio, not correctness.
+
+  Research links
+  http://www.vldb.org/conf/1994/P439.PDF (2Q: A Low Overhead High Performance Buffer Management
+                                          Replacement Algorithm)
+  https://www.usenix.org/legacy/events/fast03/tech/full_papers/megiddo/megiddo.pdf (ARC)
+  http://arxiv.org/abs/1512.00727 (TinyLFU: A Highly Efficient Cache Admission Policy)
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_EVICTION_POLICIES_H_
+#define MAIDSAFE_COMMON_CONTAINERS_EVICTION_POLICIES_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+
+#include "maidsafe/common/containers/frequency_sketch.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+// The part of a cache entry owned by the eviction policy.
+struct PolicyHook {
+  PolicyHook() : prev(nullptr), next(nullptr), hash(0), weight(0), segment(0) {}
+  PolicyHook* prev;
+  PolicyHook* next;
+  std::size_t hash;
+  std::uint64_t weight;
+  unsigned segment;  // Which of the policy's lists holds this entry.
+};
+
+// Intrusive doubly-linked list of entries, the most recently pushed at the front.
+class PolicyList {
+ public:
+  PolicyList() : front_(nullptr), back_(nullptr), size_(0), weight_(0) {}
+  PolicyList(const PolicyList&) = delete;
+  PolicyList& operator=(const PolicyList&) = delete;
+
+  void PushFront(PolicyHook* hook) {
+    hook->prev = nullptr;
+    hook->next = front_;
+    if (front_)
+      front_->prev = hook;
+    else
+      back_ = hook;
+    front_ = hook;
+    ++size_;
+    weight_ += hook->weight;
+  }
+
+  void Erase(PolicyHook* hook) {
+    if (hook->prev)
+      hook->prev->next = hook->next;
+    else
+      front_ = hook->next;
+    if (hook->next)
+      hook->next->prev = hook->prev;
+    else
+      back_ = hook->prev;
+    --size_;
+    weight_ -= hook->weight;
+  }
+
+  void MoveToFront(PolicyHook* hook) {
+    if (hook == front_)
+      return;
+    Erase(hook);
+    PushFront(hook);
+  }
+
+  PolicyHook* front() const { return front_; }
+  PolicyHook* back() const { return back_; }
+  bool empty() const { return size_ == 0; }
+  std::size_t size() const { return size_; }
+  std::uint64_t weight() const { return weight_; }
+
+ private:
+  PolicyHook* front_;
+  PolicyHook* back_;
+  std::size_t size_;
+  std::uint64_t weight_;
+};
+
+// The hashes of recently evicted entries, oldest first.
+class GhostList {
+ public:
+  GhostList() : order_(), members_(), next_sequence_(0) {}
+  GhostList(const GhostList&) = delete;
+  GhostList& operator=(const GhostList&) = delete;
+
+  // Adds 'hash', then forgets the oldest hashes until at most 'capacity' remain.
+  void Add(std::size_t hash, std::size_t capacity) {
+    members_[hash] = next_sequence_;
+    order_.emplace_back(hash, next_sequence_++);
+    while (members_.size() > capacity || order_.size() > 2 * capacity + 16)
+      PopOldest();
+  }
+
+  // Returns true, and forgets 'hash', if it is held.
+  bool Erase(std::size_t hash) { return members_.erase(hash) != 0; }
+
+  std::size_t size() const { return members_.size(); }
+
+ private:
+  void PopOldest() {
+    // Entries in 'order_' which were since erased or re-added are stale, and are just dropped.
+    const auto itr(members_.find(order_.front().first));
+    if (itr != members_.end() && itr->second == order_.front().second)
+      members_.erase(itr);
+    order_.pop_front();
+  }
+
+  std::deque<std::pair<std::size_t, std::uint64_t>> order_;
+  std::unordered_map<std::size_t, std::uint64_t> members_;
+  std::uint64_t next_sequence_;
+};
+
+}  // namespace detail
+
+class LruPolicy {
+ public:
+  explicit LruPolicy(std::uint64_t /*limit*/) : entries_() {}
+  LruPolicy(const LruPolicy&) = delete;
+  LruPolicy& operator=(const LruPolicy&) = delete;
+
+  void Insert(detail::PolicyHook* entry) { entries_.PushFront(entry); }
+  void Access(detail::PolicyHook* entry) { entries_.MoveToFront(entry); }
+  void Remove(detail::PolicyHook* entry) { entries_.Erase(entry); }
+  detail::PolicyHook* Victim() { return entries_.back(); }
+  void Evict(detail::PolicyHook* entry) { entries_.Erase(entry); }
+
+ private:
+  detail::PolicyList entries_;
+};
+
+class TwoQueuePolicy {
+ public:
+  explicit TwoQueuePolicy(std::uint64_t limit)
+      : in_limit_(std::max<std::uint64_t>(limit / 4, 1)), in_(), main_(), out_() {}
+  TwoQueuePolicy(const TwoQueuePolicy&) = delete;
+  TwoQueuePolicy& operator=(const TwoQueuePolicy&) = delete;
+
+  void Insert(detail::PolicyHook* entry) {
+    entry->segment = out_.Erase(entry->hash) ? kMain_ : kIn_;
+    List(entry).PushFront(entry);
+  }
+
+  void Access(detail::PolicyHook* entry) {
+    // Entries in the FIFO queue are not reordered by use.
+    if (entry->segment == kMain_)
+      main_.MoveToFront(entry);
+  }
+
+  void Remove(detail::PolicyHook* entry) { List(entry).Erase(entry); }
+
+  detail::PolicyHook* Victim() {
+    if (!in_.empty() && (in_.weight() > in_limit_ || main_.empty()))
+      return in_.back();
+    return main_.back();
+  }
+
+  void Evict(detail::PolicyHook* entry) {
+    // Remember entries evicted from the FIFO queue for half as many entries as the cache holds.
+    if (entry->segment == kIn_)
+      out_.Add(entry->hash, std::max<std::size_t>((in_.size() + main_.size()) / 2, 1));
+    Remove(entry);
+  }
+
+ private:
+  static const unsigned kIn_ = 0, kMain_ = 1;
+
+  detail::PolicyList& List(detail::PolicyHook* entry) {
+    return entry->segment == kIn_ ? in_ : main_;
+  }
+
+  const std::uint64_t in_limit_;
+  detail::PolicyList in_, main_;
+  detail::GhostList out_;
+};
+
+class ArcPolicy {
+ public:
+  explicit ArcPolicy(std::uint64_t limit)
+      : limit_(limit), target_(0), recent_(), frequent_(), recent_ghosts_(), frequent_ghosts_() {}
+  ArcPolicy(const ArcPolicy&) = delete;
+  ArcPolicy& operator=(const ArcPolicy&) = delete;
+
+  void Insert(detail::PolicyHook* entry) {
+    const std::uint64_t recent_ghosts(recent_ghosts_.size()),
+        frequent_ghosts(frequent_ghosts_.size());
+    if (recent_ghosts_.Erase(entry->hash)) {
+      // Recently evicted after a single use, so favour entries seen once.
+      const std::uint64_t step(std::max<std::uint64_t>(frequent_ghosts / recent_ghosts, 1));
+      target_ = std::min(limit_, target_ + step * entry->weight);
+      entry->segment = kFrequent_;
+    } else if (frequent_ghosts_.Erase(entry->hash)) {
+      const std::uint64_t step(std::max<std::uint64_t>(recent_ghosts / frequent_ghosts, 1));
+      target_ -= std::min(target_, step * entry->weight);
+      entry->segment = kFrequent_;
+    } else {
+      entry->segment = kRecent_;
+    }
+    List(entry).PushFront(entry);
+  }
+
+  void Access(detail::PolicyHook* entry) {
+    List(entry).Erase(entry);
+    entry->segment = kFrequent_;
+    frequent_.PushFront(entry);
+  }
+
+  void Remove(detail::PolicyHook* entry) { List(entry).Erase(entry); }
+
+  detail::PolicyHook* Victim() {
+    if (!recent_.empty() && (recent_.weight() > target_ || frequent_.empty()))
+      return recent_.back();
+    return frequent_.back();
+  }
+
+  void Evict(detail::PolicyHook* entry) {
+    // Each ghost list is bounded so that, with its resident list, it covers about one cache's
+    // worth of entries.
+    if (entry->segment == kRecent_)
+      recent_ghosts_.Add(entry->hash, std::max<std::size_t>(frequent_.size(), 1));
+    else
+      frequent_ghosts_.Add(entry->hash, std::max<std::size_t>(recent_.size(), 1));
+    Remove(entry);
+  }
+
+ private:
+  static const unsigned kRecent_ = 0, kFrequent_ = 1;
+
+  detail::PolicyList& List(detail::PolicyHook* entry) {
+    return entry->segment == kRecent_ ? recent_ : frequent_;
+  }
+
+  const std::uint64_t limit_;
+  std::uint64_t target_;  // Target weight of 'recent_'.
+  detail::PolicyList recent_, frequent_;
+  detail::GhostList recent_ghosts_, frequent_ghosts_;
+};
+
+class TinyLfuPolicy {
+ public:
+  explicit TinyLfuPolicy(std::uint64_t limit)
+      : window_limit_(std::max<std::uint64_t>(limit / 100, 1)),
+        main_limit_(limit - std::min(limit, window_limit_)),
+        protected_limit_(main_limit_ - main_limit_ / 5),
+        sketch_(static_cast<std::size_t>(std::min<std::uint64_t>(limit, kMaxSketchEntries_))),
+        window_(),
+        probation_(),
+        protected_() {}
+  TinyLfuPolicy(const TinyLfuPolicy&) = delete;
+  TinyLfuPolicy& operator=(const TinyLfuPolicy&) = delete;
+
+  void Insert(detail::PolicyHook* entry) {
+    sketch_.Increment(entry->hash);
+    entry->segment = kWindow_;
+    window_.PushFront(entry);
+  }
+
+  void Access(detail::PolicyHook* entry) {
+    sketch_.Increment(entry->hash);
+    if (entry->segment == kProbation_) {
+      probation_.Erase(entry);
+      entry->segment = kProtected_;
+      protected_.PushFront(entry);
+      while (protected_.weight() > protected_limit_ && protected_.size() > 1) {
+        detail::PolicyHook* demoted(protected_.back());
+        protected_.Erase(demoted);
+        demoted->segment = kProbation_;
+        probation_.PushFront(demoted);
+      }
+    } else {
+      List(entry).MoveToFront(entry);
+    }
+  }
+
+  void Remove(detail::PolicyHook* entry) { List(entry).Erase(entry); }
+
+  detail::PolicyHook* Victim() {
+    while (window_.weight() > window_limit_) {
+      detail::PolicyHook* candidate(window_.back());
+      detail::PolicyHook* victim(MainVictim());
+      if (victim && probation_.weight() + protected_.weight() >= main_limit_) {
+        // The main cache is full: admit the candidate only if it's more popular than the victim.
+        if (sketch_.Estimate(candidate->hash) <= sketch_.Estimate(victim->hash))
+          return candidate;
+        MoveToProbation(candidate);
+        return victim;
+      }
+      MoveToProbation(candidate);
+    }
+    detail::PolicyHook* victim(MainVictim());
+    return victim ? victim : window_.back();
+  }
+
+  void Evict(detail::PolicyHook* entry) { Remove(entry); }
+
+ private:
+  static const unsigned kWindow_ = 0, kProbation_ = 1, kProtected_ = 2;
+  // Bounds the sketch's size for caches with a large (or no) limit.
+  static const std::uint64_t kMaxSketchEntries_ = 1 << 20;
+
+  detail::PolicyList& List(detail::PolicyHook* entry) {
+    return entry->segment == kWindow_ ? window_
+                                      : (entry->segment == kProbation_ ? probation_ : protected_);
+  }
+
+  detail::PolicyHook* MainVictim() const {
+    return probation_.empty() ? protected_.back() : probation_.back();
+  }
+
+  void MoveToProbation(detail::PolicyHook* entry) {
+    window_.Erase(entry);
+    entry->segment = kProbation_;
+    probation_.PushFront(entry);
+  }
+
+  const std::uint64_t window_limit_, main_limit_, protected_limit_;
+  FrequencySketch sketch_;
+  detail::PolicyList window_, probation_, protected_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_EVICTION_POLICIES_H_
@@ -0,0 +1,112 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  An approximate, aging frequency counter as used by TinyLFU cache admission policies.  It is a
+  count-min sketch of depth 4 using 4-bit counters, so estimates saturate at 15.  After a number of
+  increments proportional to the expected number of distinct entries, all counters are halved so
+  that the sketch favours recent popularity.
+
+  Keys are passed as already-hashed values; the caller should use a well-distributed hash.
+
+  Research links
+  http://arxiv.org/abs/1512.00727 (TinyLFU: A Highly Efficient Cache Admission Policy)
+  https://github.com/ben-manes/caffeine/wiki/Efficiency
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_FREQUENCY_SKETCH_H_
+#define MAIDSAFE_COMMON_CONTAINERS_FREQUENCY_SKETCH_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace maidsafe {
+
+class FrequencySketch {
+ public:
+  explicit FrequencySketch(std::size_t expected_entries)
+      : table_(RoundUpToPowerOfTwo(std::max<std::size_t>(expected_entries, 16) / 4)),
+        sample_size_(10 * std::max<std::size_t>(expected_entries, 16)),
+        additions_(0) {}
+
+  // Increments the estimated frequency of 'hash', halving all counters if the sample size has been
+  // reached.
+  void Increment(std::uint64_t hash) {
+    bool added(false);
+    for (unsigned depth(0); depth != kDepth_; ++depth) {
+      std::uint64_t& word(table_[WordIndex(hash, depth)]);
+      const unsigned shift(NibbleShift(hash, depth));
+      if (((word >> shift) & 0xf) != 0xf) {
+        word += std::uint64_t(1) << shift;
+        added = true;
+      }
+    }
+    if (added && ++additions_ == sample_size_)
+      Reset();
+  }
+
+  // Returns the estimated number of times 'hash' has been seen, capped at 15.
+  unsigned Estimate(std::uint64_t hash) const {
+    unsigned frequency(0xf);
+    for (unsigned depth(0); depth != kDepth_; ++depth) {
+      frequency = std::min(frequency, static_cast<unsigned>(
+          (table_[WordIndex(hash, depth)] >> NibbleShift(hash, depth)) & 0xf));
+    }
+    return frequency;
+  }
+
+ private:
+  static const unsigned kDepth_ = 4;
+
+  static std::size_t RoundUpToPowerOfTwo(std::size_t value) {
+    std::size_t result(1);
+    while (result < value)
+      result <<= 1;
+    return result;
+  }
+
+  static std::uint64_t Mix(std::uint64_t hash, unsigned depth) {
+    static const std::uint64_t kSeeds[kDepth_] = {0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL,
+                                                  0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL};
+    hash = (hash + kSeeds[depth]) * 0x9e3779b97f4a7c15ULL;
+    return hash ^ (hash >> 32);
+  }
+
+  std::size_t WordIndex(std::uint64_t hash, unsigned depth) const {
+    return static_cast<std::size_t>(Mix(hash, depth) >> 4) & (table_.size() - 1);
+  }
+
+  static unsigned NibbleShift(std::uint64_t hash, unsigned depth) {
+    return static_cast<unsigned>(Mix(hash, depth) & 0xf) * 4;
+  }
+
+  void Reset() {
+    for (auto& word : table_)
+      word = (word >> 1) & 0x7777777777777777ULL;
+    additions_ /= 2;
+  }
+
+  std::vector<std::uint64_t> table_;
+  const std::size_t sample_size_;
+  std::size_t additions_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_FREQUENCY_SKETCH_H_
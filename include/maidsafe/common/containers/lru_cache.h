@@ -20,9 +20,29 @@
   A least recently used cache that has a capacity and time to live setting. Passing a void ValueType
   allows this object to be used as a firewall / filter type device that can hold and check
   for keys already seen. Users can set the capacity, time_to_live or both allowing a cache that will
-  not hold data too long or stay full if it's not being accessed frequently. This should allow the
-  cache to not hold stale information at the cost of a check every time we add that looks
-  at the timestamp of the last entry in the list and compares this to the maps timestamp.
+  not hold data too long or stay full if it's not being accessed frequently. Expired entries are
+  never returned by Get or Check; they are removed in order of expiry whenever Add or Get is
+  called, or by RemoveExpired (see CacheExpiryTimer to call this periodically on an AsioService).
+  Timestamps come from CoarseSteadyClock, so entries may expire up to a few milliseconds early.
+
+  Alternatively, a cache with a non-void ValueType can be given a maximum total weight and a
+  Weigher functor which returns the weight (e.g. the size in bytes) of an entry.  Entries are then
+  evicted until a new entry fits, and an entry heavier than the maximum on its own is not added.
+  Without a Weigher, each entry weighs 1.
+
+  The Policy chooses which entry to evict when the cache is full.  By default this is the least
+  recently used entry; see eviction_policies.h for scan-resistant alternatives.  Expiry is
+  independent of the Policy: entries expire time_to_live after being added.
+
+  Entries are held in nodes which form a chained hash table (keyed by Hash, which may be e.g.
+  SeededHash<SipHash>), an intrusive doubly-linked list in order of addition and the Policy's own
+  intrusive lists, so Add, Get, Check and Delete are O(1).  Nodes are allocated in blocks and
+  recycled via a free list, so once the cache has reached its capacity, no further allocations are
+  made by the cache itself (the scan-resistant policies allocate a little to remember evicted keys).
+
+  If no Hash is given and std::hash doesn't support KeyType (e.g. Identity or std::pair), nodes are
+  instead indexed by KeyType's operator< in a std::map, making Add, Get, Check and Delete
+  O(log n).  The scan-resistant policies remember evicted keys by hash, so need a Hash.
 
   Research links
   http://en.wikipedia.org/wiki/Cache_algorithms
@@ -34,54 +54,202 @@
 #ifndef MAIDSAFE_COMMON_CONTAINERS_LRU_CACHE_H_
 #define MAIDSAFE_COMMON_CONTAINERS_LRU_CACHE_H_
 
-#include <cassert>
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
+#include <functional>
 #include <limits>
-#include <list>
 #include <map>
-#include <tuple>
+#include <memory>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "boost/expected/expected.hpp"
+#include "boost/optional/optional.hpp"
 
+#include "maidsafe/common/clock.h"
 #include "maidsafe/common/types.h"
+#include "maidsafe/common/containers/eviction_policies.h"
 
 namespace maidsafe {
 
 namespace detail {
 
 // Helper classes
+template <typename KeyType, typename ValueType>
+struct LruEntry {
+  template <typename Key, typename Value>
+  LruEntry(Key&& key_in, Value&& value_in)
+      : key(std::forward<Key>(key_in)), value(std::forward<Value>(value_in)) {}
+  KeyType key;
+  ValueType value;
+};
+
 template <typename KeyType>
-using KeyOrder = std::list<KeyType>;
+struct LruEntry<KeyType, void> {
+  template <typename Key>
+  explicit LruEntry(Key&& key_in) : key(std::forward<Key>(key_in)) {}
+  KeyType key;
+};
+
+template <typename KeyType, typename ValueType>
+struct LruNode : PolicyHook {
+  LruNode() : older(nullptr), newer(nullptr), next_in_bucket(nullptr), timestamp(), entry() {}
+  LruNode* older;
+  LruNode* newer;  // Also links the free list.
+  LruNode* next_in_bucket;
+  std::chrono::steady_clock::time_point timestamp;
+  boost::optional<LruEntry<KeyType, ValueType>> entry;
+};
 
-template <typename T>
-struct TypeHelper {
-  using type = T;
+// The default Hash for a KeyType which std::hash doesn't support.  It selects an LruOrderedIndex,
+// and hashes every key to 0.
+struct OrderedKeys {
+  template <typename KeyType>
+  std::size_t operator()(const KeyType&) const {
+    return 0;
+  }
 };
 
-template <typename KeyType, typename T>
-struct StorageType
-    : TypeHelper<std::map<KeyType, std::tuple<typename KeyOrder<KeyType>::iterator,
-                                              std::chrono::steady_clock::time_point, T>>> {};
+template <typename KeyType, typename Enable = void>
+struct DefaultLruHash {
+  using type = OrderedKeys;
+};
 
 template <typename KeyType>
-struct StorageType<KeyType, void>
-    : TypeHelper<std::map<KeyType, std::tuple<typename KeyOrder<KeyType>::iterator,
-                                              std::chrono::steady_clock::time_point>>> {};
+struct DefaultLruHash<KeyType, decltype(static_cast<void>(
+                                   std::hash<KeyType>()(std::declval<const KeyType&>())))> {
+  using type = std::hash<KeyType>;
+};
+
+// Indexes nodes by hash in a chained hash table with a power-of-two number of buckets.  A bucket is
+// chosen by the top bits of a multiplicative mix of the hash, since e.g. std::hash of integers and
+// pointers is the identity, and keys sharing their low bits would otherwise share buckets.
+template <typename KeyType, typename Node, typename Hash, typename KeyEqual>
+class LruHashIndex {
+ public:
+  LruHashIndex()
+      : hash_(),
+        key_equal_(),
+        buckets_(std::size_t(1) << kInitialBucketBits_, nullptr),
+        bucket_bits_(kInitialBucketBits_),
+        size_(0) {}
+
+  std::size_t HashOf(const KeyType& key) const { return static_cast<std::size_t>(hash_(key)); }
+
+  Node* Find(const KeyType& key, std::size_t hash) const {
+    for (Node* node(buckets_[BucketIndex(hash)]); node; node = node->next_in_bucket) {
+      if (node->hash == hash && key_equal_(node->entry->key, key))
+        return node;
+    }
+    return nullptr;
+  }
+
+  // 'node' must hold an entry and its hash.
+  void Insert(Node* node) {
+    if (size_ == buckets_.size())
+      Rehash(bucket_bits_ + 1);
+    Link(node);
+    ++size_;
+  }
+
+  void Erase(Node* node) {
+    Node** link(&buckets_[BucketIndex(node->hash)]);
+    while (*link != node)
+      link = &(*link)->next_in_bucket;
+    *link = node->next_in_bucket;
+    --size_;
+  }
 
-// Base class providing fixed-size (by number of records) and / or time_to_live LRU-replacement
+ private:
+  static const unsigned kInitialBucketBits_ = 4;
+
+  std::size_t BucketIndex(std::size_t hash) const {
+    return static_cast<std::size_t>((static_cast<std::uint64_t>(hash) * 0x9e3779b97f4a7c15ULL) >>
+                                    (64 - bucket_bits_));
+  }
+
+  void Link(Node* node) {
+    Node*& bucket(buckets_[BucketIndex(node->hash)]);
+    node->next_in_bucket = bucket;
+    bucket = node;
+  }
+
+  void Rehash(unsigned bucket_bits) {
+    std::vector<Node*> old_buckets(std::size_t(1) << bucket_bits, nullptr);
+    old_buckets.swap(buckets_);
+    bucket_bits_ = bucket_bits;
+    for (Node* node : old_buckets) {
+      while (node) {
+        Node* const next(node->next_in_bucket);
+        Link(node);
+        node = next;
+      }
+    }
+  }
+
+  const Hash hash_;
+  const KeyEqual key_equal_;
+  std::vector<Node*> buckets_;
+  unsigned bucket_bits_;
+  std::size_t size_;
+};
+
+// Indexes nodes by KeyType's operator<, for keys without a Hash.  The map's keys refer to the keys
+// held in the nodes.
+template <typename KeyType, typename Node>
+class LruOrderedIndex {
+ public:
+  LruOrderedIndex() : nodes_() {}
+
+  std::size_t HashOf(const KeyType&) const { return 0; }
+
+  Node* Find(const KeyType& key, std::size_t /*hash*/) const {
+    const auto itr(nodes_.find(std::cref(key)));
+    return itr == nodes_.end() ? nullptr : itr->second;
+  }
+
+  void Insert(Node* node) { nodes_.emplace(std::cref(node->entry->key), node); }
+
+  void Erase(Node* node) { nodes_.erase(std::cref(node->entry->key)); }
+
+ private:
+  std::map<std::reference_wrapper<const KeyType>, Node*, std::less<KeyType>> nodes_;
+};
+
+// Base class providing fixed-size (by number of records or total weight) and / or time_to_live
 // cache
-template <typename KeyType, typename ValueType>
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename Policy>
 class LruCacheBase {
+  static_assert(!std::is_same<Hash, OrderedKeys>::value || std::is_same<Policy, LruPolicy>::value,
+                "The scan-resistant policies need a Hash for KeyType.");
+
  public:
   explicit LruCacheBase(size_t capacity)
-      : capacity_(capacity), time_to_live_(std::chrono::steady_clock::duration::zero()) {}
+      : LruCacheBase(capacity, std::chrono::steady_clock::duration::zero()) {}
 
   explicit LruCacheBase(std::chrono::steady_clock::duration time_to_live)
-      : capacity_(std::numeric_limits<size_t>::max()), time_to_live_(time_to_live) {}
+      : LruCacheBase(std::numeric_limits<size_t>::max(), time_to_live) {}
 
   LruCacheBase(size_t capacity, std::chrono::steady_clock::duration time_to_live)
-      : capacity_(capacity), time_to_live_(time_to_live) {}
+      : LruCacheBase(capacity, MemoryUsage(std::numeric_limits<std::uint64_t>::max()),
+                     time_to_live) {}
+
+  LruCacheBase(size_t capacity, MemoryUsage max_weight,
+               std::chrono::steady_clock::duration time_to_live)
+      : capacity_(capacity),
+        max_weight_(max_weight),
+        time_to_live_(time_to_live),
+        weight_(0),
+        policy_(std::min<std::uint64_t>(capacity, max_weight.data)),
+        index_(),
+        blocks_(),
+        allocated_(0),
+        free_(nullptr),
+        oldest_(nullptr),
+        newest_(nullptr),
+        size_(0) {}
 
   virtual ~LruCacheBase() = default;
   LruCacheBase(const LruCacheBase&) = delete;
@@ -89,65 +257,184 @@ class LruCacheBase {
   LruCacheBase& operator=(const LruCacheBase&) = delete;
   LruCacheBase& operator=(LruCacheBase&&) = delete;
 
-  bool Check(const KeyType& key) const { return storage_.find(key) != storage_.end(); }
+  bool Check(const KeyType& key) const {
+    const Node* node(Find(key));
+    return node && !IsExpired(*node, Now());
+  }
+
+  // Number of entries held, which may include expired entries not yet removed.
+  size_t size() const { return size_; }
+
+  // Removes all expired entries.  Expired entries are otherwise removed lazily by Add and Get.
+  void RemoveExpired() { RemoveExpired(Now()); }
 
-  size_t size() const { return storage_.size(); }
+  // Total weight of the entries held.
+  MemoryUsage weight() const { return MemoryUsage(weight_); }
 
  protected:
-  template <typename T>
-  using Storage = typename StorageType<KeyType, T>::type;
-
-  typename KeyOrder<KeyType>::iterator PrepareToAdd(const KeyType& key) {
-    if (storage_.find(key) != storage_.end())
-      return std::end(key_order_);
-    // Check if we should evict any entries because of size
-    if (storage_.size() == capacity_)
-      RemoveOldestElement();
-    // Check if we have entries with time expired
-    while (CheckTimeExpired())  // Any old entries at beginning of the list
-      RemoveOldestElement();
-
-    // Record key as most-recently-used key
-    return key_order_.insert(std::end(key_order_), key);
-  }
-
-  void RemoveOldestElement() {
-    assert(!key_order_.empty());
-    // Identify least recently used key
-    const auto it = storage_.find(key_order_.front());
-    assert(it != storage_.end());
-    // Erase both elements in both containers
-    storage_.erase(it);
-    key_order_.pop_front();
-  }
-
-  bool CheckTimeExpired() const {
-    if (time_to_live_ == std::chrono::steady_clock::duration::zero() || storage_.empty())
-      return false;
-    auto key = storage_.find(key_order_.front());
-    assert(key != std::end(storage_) && "cannot find element");
-    return (std::get<1>(key->second) + time_to_live_) < std::chrono::steady_clock::now();
+  using Node = LruNode<KeyType, ValueType>;
+
+  Node* Find(const KeyType& key) const { return index_.Find(key, index_.HashOf(key)); }
+
+  // Adds a new entry of the given weight constructed from 'key' and 'value_args' as the most
+  // recently used, first evicting entries to respect the capacity, maximum weight and
+  // time_to_live.  Does nothing if 'key' is already held or 'weight' exceeds the maximum weight.
+  template <typename... ValueArgs>
+  void Emplace(std::uint64_t weight, KeyType key, ValueArgs&&... value_args) {
+    if (weight > max_weight_.data)
+      return;
+    const std::chrono::steady_clock::time_point now(Now());
+    RemoveExpired(now);
+    const std::size_t hash(index_.HashOf(key));
+    if (index_.Find(key, hash))
+      return;
+    // Check if we should evict any entries because of size or weight
+    while (size_ == capacity_ || max_weight_.data - weight < weight_) {
+      Node* victim(static_cast<Node*>(policy_.Victim()));
+      policy_.Evict(victim);
+      Release(victim);
+    }
+
+    Node* node(AllocateNode());
+    node->entry.emplace(std::move(key), std::forward<ValueArgs>(value_args)...);
+    node->hash = hash;
+    node->weight = weight;
+    node->timestamp = now;
+    LinkNewest(node);
+    index_.Insert(node);
+    weight_ += weight;
+    ++size_;
+    policy_.Insert(node);
+  }
+
+  // Record node as accessed
+  void Touch(Node* node) { policy_.Access(node); }
+
+  void Remove(Node* node) {
+    policy_.Remove(node);
+    Release(node);
+  }
+
+  // Returns the current time from a coarse clock, or a default time_point if entries don't expire.
+  std::chrono::steady_clock::time_point Now() const {
+    return time_to_live_ == std::chrono::steady_clock::duration::zero()
+               ? std::chrono::steady_clock::time_point()
+               : CoarseSteadyClock::now();
+  }
+
+  bool IsExpired(const Node& node, std::chrono::steady_clock::time_point now) const {
+    return time_to_live_ != std::chrono::steady_clock::duration::zero() &&
+           node.timestamp + time_to_live_ <= now;
+  }
+
+  // All entries have the same time_to_live, so the list in order of addition is also in order of
+  // expiry, and each expired entry is found and removed in O(1).
+  void RemoveExpired(std::chrono::steady_clock::time_point now) {
+    while (oldest_ && IsExpired(*oldest_, now))
+      Remove(oldest_);
   }
 
   const size_t capacity_;
+  const MemoryUsage max_weight_;
   const std::chrono::steady_clock::duration time_to_live_;
-  KeyOrder<KeyType> key_order_;
-  Storage<ValueType> storage_;
+  std::uint64_t weight_;
+  Policy policy_;
+
+ private:
+  using Index = typename std::conditional<std::is_same<Hash, OrderedKeys>::value,
+                                          LruOrderedIndex<KeyType, Node>,
+                                          LruHashIndex<KeyType, Node, Hash, KeyEqual>>::type;
+
+  static const std::size_t kInitialBlockSize_ = 16;
+
+  // Unlinks 'node' from the index and list, and returns it to the free list.
+  void Release(Node* node) {
+    index_.Erase(node);
+    Unlink(node);
+    node->entry = boost::none;
+    node->newer = free_;
+    free_ = node;
+    weight_ -= node->weight;
+    --size_;
+  }
+
+  Node* AllocateNode() {
+    if (!free_) {
+      // Blocks double in size, up to the remaining capacity.
+      const std::size_t block_size(std::min(std::max<std::size_t>(allocated_, kInitialBlockSize_),
+                                            capacity_ - allocated_));
+      blocks_.emplace_back(new Node[block_size]);
+      for (std::size_t i(0); i != block_size; ++i) {
+        blocks_.back()[i].newer = free_;
+        free_ = &blocks_.back()[i];
+      }
+      allocated_ += block_size;
+    }
+    Node* node(free_);
+    free_ = node->newer;
+    return node;
+  }
+
+  void LinkNewest(Node* node) {
+    node->older = newest_;
+    node->newer = nullptr;
+    if (newest_)
+      newest_->newer = node;
+    else
+      oldest_ = node;
+    newest_ = node;
+  }
+
+  void Unlink(Node* node) {
+    if (node->older)
+      node->older->newer = node->newer;
+    else
+      oldest_ = node->newer;
+    if (node->newer)
+      node->newer->older = node->older;
+    else
+      newest_ = node->older;
+  }
+
+  Index index_;
+  std::vector<std::unique_ptr<Node[]>> blocks_;
+  std::size_t allocated_;
+  Node* free_;
+  Node* oldest_;
+  Node* newest_;
+  std::size_t size_;
 };
 
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename Policy>
+const std::size_t LruCacheBase<KeyType, ValueType, Hash, KeyEqual, Policy>::kInitialBlockSize_;
+
 }  // namespace detail
 
 // Class providing fixed-size (by number of records) and / or time_to_live LRU-replacement cache
-template <typename KeyType, typename ValueType>
-class LruCache : public detail::LruCacheBase<KeyType, ValueType> {
+template <typename KeyType, typename ValueType,
+          typename Hash = typename detail::DefaultLruHash<KeyType>::type,
+          typename KeyEqual = std::equal_to<KeyType>, typename Policy = LruPolicy>
+class LruCache : public detail::LruCacheBase<KeyType, ValueType, Hash, KeyEqual, Policy> {
+  using Base = detail::LruCacheBase<KeyType, ValueType, Hash, KeyEqual, Policy>;
+
  public:
-  explicit LruCache(size_t capacity) : detail::LruCacheBase<KeyType, ValueType>(capacity) {}
+  using Weigher = std::function<std::uint64_t(const KeyType&, const ValueType&)>;
+
+  explicit LruCache(size_t capacity) : Base(capacity), weigher_() {}
 
   explicit LruCache(std::chrono::steady_clock::duration time_to_live)
-      : detail::LruCacheBase<KeyType, ValueType>(time_to_live) {}
+      : Base(time_to_live), weigher_() {}
 
   LruCache(size_t capacity, std::chrono::steady_clock::duration time_to_live)
-      : detail::LruCacheBase<KeyType, ValueType>(capacity, time_to_live) {}
+      : Base(capacity, time_to_live), weigher_() {}
+
+  LruCache(MemoryUsage max_weight, Weigher weigher)
+      : LruCache(max_weight, std::move(weigher), std::chrono::steady_clock::duration::zero()) {}
+
+  LruCache(MemoryUsage max_weight, Weigher weigher,
+           std::chrono::steady_clock::duration time_to_live)
+      : Base(std::numeric_limits<size_t>::max(), max_weight, time_to_live),
+        weigher_(std::move(weigher)) {}
 
   virtual ~LruCache() = default;
   LruCache(const LruCache&) = delete;
@@ -155,49 +442,81 @@ class LruCache : public detail::LruCacheBase<KeyType, ValueType> {
   LruCache& operator=(const LruCache&) = delete;
   LruCache& operator=(LruCache&&) = delete;
 
-  // We do not return an iterator here and use a pair instead as we are keeping two containers in
-  // sync and cannot allow access to these containers from the public interface
   boost::expected<ValueType, maidsafe_error> Get(const KeyType& key) {
-    const auto it = this->storage_.find(key);
-
-    if (it == this->storage_.end())
+    const auto node = Lookup(key);
+    if (!node)
       return boost::make_unexpected(MakeError(CommonErrors::no_such_element));
+    return node->entry->value;
+  }
 
-    // Update access record by moving accessed key to back of list
-    this->key_order_.splice(this->key_order_.end(), this->key_order_, std::get<0>(it->second));
-    return std::get<2>(it->second);
+  // The following count as a use of the entry, just as Get does, but don't copy its value nor
+  // construct an error on a miss.
+
+  // Calls 'functor(const ValueType&)' with the value if 'key' is cached, and returns whether it
+  // was.  The functor must not modify the cache.
+  template <typename Functor>
+  bool Visit(const KeyType& key, Functor functor) {
+    const auto node = Lookup(key);
+    if (!node)
+      return false;
+    functor(static_cast<const ValueType&>(node->entry->value));
+    return true;
+  }
+
+  // Returns a pointer to the cached value, or nullptr.  The pointer is only valid until the cache
+  // is next modified (including by a Get or Add which removes expired entries).
+  const ValueType* GetPtr(const KeyType& key) {
+    const auto node = Lookup(key);
+    return node ? &node->entry->value : nullptr;
+  }
+
+  // Copy-assigns the cached value to 'value' and returns true, or returns false and leaves 'value'
+  // unchanged.
+  bool TryGet(const KeyType& key, ValueType& value) {
+    const auto node = Lookup(key);
+    if (!node)
+      return false;
+    value = node->entry->value;
+    return true;
   }
 
   void Add(KeyType key, ValueType value) {
-    auto it = this->PrepareToAdd(key);
-    if (it == std::end(this->key_order_))
-      return;
-    // Create the key-value entry, linked to the usage record.
-    this->storage_.insert(std::make_pair(
-        std::move(key), std::make_tuple(it, std::chrono::steady_clock::now(), std::move(value))));
+    const std::uint64_t weight(weigher_ ? weigher_(key, value) : 1);
+    this->Emplace(weight, std::move(key), std::move(value));
   }
 
   void Delete(const KeyType& key) {
-    const auto it = this->storage_.find(key);
-    if (it != this->storage_.end()) {
-      std::get<1>(it->second) = std::chrono::steady_clock::now() - this->time_to_live_;
-      this->key_order_.splice(this->key_order_.begin(), this->key_order_, std::get<0>(it->second));
-      this->RemoveOldestElement();
-    }
+    const auto node = this->Find(key);
+    if (node)
+      this->Remove(node);
+  }
+
+ private:
+  typename Base::Node* Lookup(const KeyType& key) {
+    this->RemoveExpired();
+    const auto node = this->Find(key);
+    // Update access record by moving accessed key to back of list
+    if (node)
+      this->Touch(node);
+    return node;
   }
+
+  const Weigher weigher_;
 };
 
 // Class providing fixed-size (by number of records) and / or time_to_live LRU-replacement filter
-template <typename KeyType>
-class LruCache<KeyType, void> : public detail::LruCacheBase<KeyType, void> {
+template <typename KeyType, typename Hash, typename KeyEqual, typename Policy>
+class LruCache<KeyType, void, Hash, KeyEqual, Policy>
+    : public detail::LruCacheBase<KeyType, void, Hash, KeyEqual, Policy> {
+  using Base = detail::LruCacheBase<KeyType, void, Hash, KeyEqual, Policy>;
+
  public:
-  explicit LruCache(size_t capacity) : detail::LruCacheBase<KeyType, void>(capacity) {}
+  explicit LruCache(size_t capacity) : Base(capacity) {}
 
-  explicit LruCache(std::chrono::steady_clock::duration time_to_live)
-      : detail::LruCacheBase<KeyType, void>(time_to_live) {}
+  explicit LruCache(std::chrono::steady_clock::duration time_to_live) : Base(time_to_live) {}
 
   LruCache(size_t capacity, std::chrono::steady_clock::duration time_to_live)
-      : detail::LruCacheBase<KeyType, void>(capacity, time_to_live) {}
+      : Base(capacity, time_to_live) {}
 
   virtual ~LruCache() = default;
   LruCache(const LruCache&) = delete;
@@ -205,14 +524,7 @@ class LruCache<KeyType, void> : public detail::LruCacheBase<KeyType, void> {
   LruCache& operator=(const LruCache&) = delete;
   LruCache& operator=(LruCache&&) = delete;
 
-  void Add(KeyType key) {
-    auto it = this->PrepareToAdd(key);
-    if (it == std::end(this->key_order_))
-      return;
-    // Create the key entry, linked to the usage record.
-    this->storage_.insert(
-        std::make_pair(std::move(key), std::make_tuple(it, std::chrono::steady_clock::now())));
-  }
+  void Add(KeyType key) { this->Emplace(1, std::move(key)); }
 };
 
 }  // namespace maidsafe
@@ -0,0 +1,209 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  A probabilistic alternative to LruCache<KeyType, void> for filtering out keys which have already
+  been seen, with the same Add and Check functions.  Rather than holding the keys, it holds a few
+  bits per key, so uses far less memory than an LruCache of the same capacity.
+
+  Check always returns true for a key while the number of keys added after it as a fraction of
+  'capacity', plus the time since it was added as a fraction of 'time_to_live' (if given), is less
+  than one.  So the most recent 'capacity' keys are always reported when there is no time_to_live,
+  as are all keys added within the last 'time_to_live' when there are few keys.  Check returns true
+  for a fraction of around 'false_positive_rate' of other keys.  Older keys are forgotten gradually
+  rather than exactly, and may be reported for up to a third longer than 'time_to_live' or until up
+  to a third more than 'capacity' keys have been added after them.
+
+  Keys are added to the newest of four generations of Bloom filter.  Once the newest has been
+  filled with a third of 'capacity' keys or has lasted a third of 'time_to_live' (or a combination:
+  half of each, say), the oldest generation is cleared and becomes the newest.  Check tests all
+  generations which may hold an unexpired key, so each is sized for a quarter of the overall false
+  positive rate.
+
+  This class is not thread-safe.
+
+  Research links
+  http://en.wikipedia.org/wiki/Bloom_filter
+  https://www.eecs.harvard.edu/~michaelm/postscripts/rsa2008.pdf (Less Hashing, Same Performance)
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_ROTATING_BLOOM_FILTER_H_
+#define MAIDSAFE_COMMON_CONTAINERS_ROTATING_BLOOM_FILTER_H_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/clock.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/hash.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/hash/algorithms/siphash.h"
+
+namespace maidsafe {
+
+template <typename KeyType, typename Hash = SeededHash<SipHash>>
+class RotatingBloomFilter {
+ public:
+  explicit RotatingBloomFilter(size_t capacity, double false_positive_rate = 0.001)
+      : RotatingBloomFilter(capacity, std::chrono::steady_clock::duration::zero(),
+                            false_positive_rate) {}
+
+  RotatingBloomFilter(size_t capacity, std::chrono::steady_clock::duration time_to_live,
+                      double false_positive_rate = 0.001, Hash hash = Hash())
+      : hash_(std::move(hash)),
+        keys_per_generation_(KeysPerGeneration(capacity)),
+        bit_count_(BitCount(keys_per_generation_, false_positive_rate)),
+        hash_count_(std::max(1, static_cast<int>(std::lround(
+                                    std::log(2.0) * bit_count_ / keys_per_generation_)))),
+        generation_duration_(time_to_live / (kGenerationCount_ - 1)),
+        time_to_live_(time_to_live),
+        words_(kGenerationCount_ * (bit_count_ / 64), 0),
+        generations_(),
+        newest_(0) {}
+
+  RotatingBloomFilter(const RotatingBloomFilter&) = delete;
+  RotatingBloomFilter(RotatingBloomFilter&&) = delete;
+  RotatingBloomFilter& operator=(const RotatingBloomFilter&) = delete;
+  RotatingBloomFilter& operator=(RotatingBloomFilter&&) = delete;
+
+  void Add(const KeyType& key) {
+    const auto now(Now());
+    Generation* newest(&generations_[newest_]);
+    if (IsFull(*newest, now)) {
+      newest_ = (newest_ + 1) % kGenerationCount_;
+      newest = &generations_[newest_];
+      std::fill_n(Words(newest_), bit_count_ / 64, 0);
+      newest->count = 0;
+    }
+    if (newest->count++ == 0)
+      newest->started = now;
+    newest->last_added = now;
+
+    const std::uint64_t hash(hash_(key));
+    std::uint64_t* const words(Words(newest_));
+    for (int i(0); i != hash_count_; ++i) {
+      const std::size_t bit(Bit(hash, i));
+      words[bit / 64] |= std::uint64_t(1) << (bit % 64);
+    }
+  }
+
+  bool Check(const KeyType& key) const {
+    const auto now(Now());
+    const std::uint64_t hash(hash_(key));
+    for (std::size_t g(0); g != kGenerationCount_; ++g) {
+      const Generation& generation(generations_[g]);
+      if (generation.count == 0 ||
+          (time_to_live_ != std::chrono::steady_clock::duration::zero() &&
+           generation.last_added + time_to_live_ <= now)) {
+        continue;
+      }
+      const std::uint64_t* const words(Words(g));
+      int i(0);
+      while (i != hash_count_) {
+        const std::size_t bit(Bit(hash, i));
+        if ((words[bit / 64] & (std::uint64_t(1) << (bit % 64))) == 0)
+          break;
+        ++i;
+      }
+      if (i == hash_count_)
+        return true;
+    }
+    return false;
+  }
+
+  MemoryUsage memory_usage() const {
+    return MemoryUsage(words_.size() * sizeof(std::uint64_t));
+  }
+
+ private:
+  struct Generation {
+    Generation() : started(), last_added(), count(0) {}
+    std::chrono::steady_clock::time_point started, last_added;
+    std::size_t count;
+  };
+
+  static const std::size_t kGenerationCount_ = 4;
+
+  static std::size_t KeysPerGeneration(std::size_t capacity) {
+    if (capacity == 0) {
+      LOG(kError) << "RotatingBloomFilter capacity must be non-zero.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+    }
+    return (capacity + kGenerationCount_ - 2) / (kGenerationCount_ - 1);
+  }
+
+  // Returns the number of bits, rounded up to a whole number of words, for each generation to have
+  // a 1/kGenerationCount_ share of 'false_positive_rate' when holding 'keys' keys.
+  static std::size_t BitCount(std::size_t keys, double false_positive_rate) {
+    if (!(false_positive_rate > 0.0 && false_positive_rate < 1.0)) {
+      LOG(kError) << "RotatingBloomFilter false positive rate must be in (0, 1).";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+    }
+    const double bits(-static_cast<double>(keys) *
+                      std::log(false_positive_rate / kGenerationCount_) /
+                      (std::log(2.0) * std::log(2.0)));
+    return (static_cast<std::size_t>(std::ceil(bits)) + 63) / 64 * 64;
+  }
+
+  bool IsFull(const Generation& generation, std::chrono::steady_clock::time_point now) const {
+    double fullness(static_cast<double>(generation.count) / keys_per_generation_);
+    if (generation.count != 0 && time_to_live_ != std::chrono::steady_clock::duration::zero()) {
+      fullness += std::chrono::duration<double>(now - generation.started) /
+                  std::chrono::duration<double>(generation_duration_);
+    }
+    return fullness >= 1.0;
+  }
+
+  std::chrono::steady_clock::time_point Now() const {
+    return time_to_live_ == std::chrono::steady_clock::duration::zero()
+               ? std::chrono::steady_clock::time_point()
+               : CoarseSteadyClock::now();
+  }
+
+  // Derives each bit from two halves of a single hash (Kirsch & Mitzenmacher).
+  std::size_t Bit(std::uint64_t hash, int i) const {
+    const std::uint64_t first(hash), second((hash >> 32) | 1);
+    return static_cast<std::size_t>((first + i * second) % bit_count_);
+  }
+
+  std::uint64_t* Words(std::size_t generation) {
+    return &words_[generation * (bit_count_ / 64)];
+  }
+
+  const std::uint64_t* Words(std::size_t generation) const {
+    return &words_[generation * (bit_count_ / 64)];
+  }
+
+  const Hash hash_;
+  const std::size_t keys_per_generation_, bit_count_;
+  const int hash_count_;
+  const std::chrono::steady_clock::duration generation_duration_, time_to_live_;
+  std::vector<std::uint64_t> words_;
+  std::array<Generation, kGenerationCount_> generations_;
+  std::size_t newest_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_ROTATING_BLOOM_FILTER_H_
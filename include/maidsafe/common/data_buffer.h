@@ -20,19 +20,37 @@
 #define MAIDSAFE_COMMON_DATA_BUFFER_H_
 
 #include <atomic>
+#include <cassert>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
-#include <deque>
 #include <functional>
 #include <future>
+#include <limits>
+#include <list>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "boost/filesystem/path.hpp"
+#include "boost/optional.hpp"
 
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/latency_histogram.h"
 #include "maidsafe/common/types.h"
+#include "maidsafe/common/containers/counting_bloom_filter.h"
+#include "maidsafe/common/containers/frequency_sketch.h"
 #include "maidsafe/common/data_types/data.h"
+#include "maidsafe/common/hash/hash_numeric.h"
+#include "maidsafe/common/hash/hash_vector.h"
+#include "maidsafe/common/hash/algorithms/siphash.h"
+#include "maidsafe/common/hash/wrappers/seeded_hash.h"
 
 namespace maidsafe {
 
@@ -42,10 +60,64 @@ class DataBufferTest;
 
 }  // namespace test
 
+class SegmentLog;
+
 class DataBuffer {
  public:
   using KeyType = Data::NameAndTypeId;
   using PopFunctor = std::function<void(const KeyType&, const NonEmptyString&)>;
+  // An immutable value which can be shared by the buffer and its callers without copying.
+  using SharedValue = std::shared_ptr<const NonEmptyString>;
+  using StoreHandler = std::function<void(std::error_code)>;
+  using GetHandler = std::function<void(std::error_code, NonEmptyString)>;
+  using DeleteHandler = std::function<void(std::error_code)>;
+
+  // How values are held on disk: either each value in its own file, or appended to large segment
+  // files (see SegmentLog), which greatly reduces the number of filesystem operations under churn.
+  // max_disk_usage limits the live values held; with kSegmentLog, dead values awaiting compaction
+  // mean the segment files can take up to about twice that much space (see SegmentLog).
+  enum class DiskBackend { kFilePerValue, kSegmentLog };
+
+  // Which values are evicted from each tier when it is full, and which values read from disk are
+  // promoted back into memory.
+  //   kFifo: the oldest stored value is evicted.  Nothing is promoted.
+  //   kLru: the least recently stored or read value is evicted.  Every value read from disk is
+  //       promoted into memory by the background worker.
+  //   kTinyLfu: as kLru, except that a value read from disk is only promoted if its estimated
+  //       access frequency is higher than that of each memory value it would displace.
+  enum class EvictionPolicy { kFifo, kLru, kTinyLfu };
+
+  // Whether values left in an explicitly-specified 'disk_buffer' by a previous instance are ignored
+  // or recovered into the disk index.
+  enum class ExistingValues { kIgnore, kRecover };
+
+  // A snapshot of the buffer's state and of its activity since construction.
+  struct Statistics {
+    struct Usage {
+      uint64_t bytes, entries;
+    };
+    // Current usage of each tier, and of the values held only in memory which the background worker
+    // has yet to copy to disk.
+    Usage memory, disk, copy_backlog;
+    // Each Get, GetShared, TryGet, GetAsync and key of GetBatch counts as one hit or miss.  Deletes
+    // only counts Delete(key), DeleteAsync and DeleteBatch, not values replaced by Store.
+    uint64_t stores, memory_hits, disk_hits, misses, deletes;
+    // Values written to disk, whether copied by the background worker or too large for memory.
+    uint64_t spills, spilled_bytes;
+    // Values popped from disk to make space (passed to pop_functor if valid), values removed from
+    // memory to make space after having been copied to disk, and values promoted back into memory.
+    uint64_t pops, popped_bytes, memory_evictions, promotions;
+    // Total time spent waiting for or making space in each tier.
+    std::chrono::nanoseconds memory_wait_time, disk_wait_time;
+    // Latencies of successful single-key Stores and Gets, and of writing each value to disk.
+    LatencyHistogram::Snapshot store_latency, get_latency, spill_latency;
+  };
+
+  // Hashes a key using SipHash with a random seed chosen per instance of KeyHash.
+  struct KeyHash {
+    std::size_t operator()(const KeyType& key) const;
+    SeededHash<SipHash> hash;
+  };
 
   DataBuffer() = delete;
   DataBuffer(const DataBuffer&) = delete;
@@ -57,13 +129,33 @@ class DataBuffer {
   // temp_directory_path().  Starts a background worker thread which copies values from memory to
   // disk.  If pop_functor is valid, the disk cache will pop excess items when it is full,
   // otherwise Store will block until there is space made via Delete calls.
-  DataBuffer(MemoryUsage max_memory_usage, DiskUsage max_disk_usage, PopFunctor pop_functor);
+  //
+  // If expected_key_count is not 0, a counting Bloom filter sized for that many keys is kept over
+  // all held keys, so that most lookups of keys which aren't held return without taking either
+  // tier's lock.  This costs 8 bytes per expected key.
+  DataBuffer(MemoryUsage max_memory_usage, DiskUsage max_disk_usage, PopFunctor pop_functor,
+             DiskBackend disk_backend = DiskBackend::kFilePerValue,
+             EvictionPolicy eviction_policy = EvictionPolicy::kFifo,
+             std::size_t expected_key_count = 0);
   // Throws if max_memory_usage >= max_disk_usage.  Throws if a writable folder can't be created in
   // "disk_buffer".  Starts a background worker thread which copies values from memory to disk.  If
   // pop_functor is valid, the disk cache will pop excess items when it is full, otherwise Store
   // will block until there is space made via Delete calls.
+  //
+  // If existing_values is kRecover, files already in "disk_buffer" are added to the disk index
+  // oldest first (by last write time), using their names to identify the keys and without reading
+  // their contents.  If these exceed max_disk_usage, the oldest are removed, being passed to
+  // pop_functor if it is valid.  Values which a previous instance held only in memory can't be
+  // recovered.  Recovery is only supported by DiskBackend::kFilePerValue; throws if requested for
+  // any other backend.
+  //
+  // expected_key_count is as for the constructor above.
   DataBuffer(MemoryUsage max_memory_usage, DiskUsage max_disk_usage, PopFunctor pop_functor,
-             const boost::filesystem::path& disk_buffer, bool should_remove_root = false);
+             const boost::filesystem::path& disk_buffer, bool should_remove_root = false,
+             DiskBackend disk_backend = DiskBackend::kFilePerValue,
+             EvictionPolicy eviction_policy = EvictionPolicy::kFifo,
+             ExistingValues existing_values = ExistingValues::kIgnore,
+             std::size_t expected_key_count = 0);
   ~DataBuffer();
   // Throws if the background worker has thrown (e.g. the disk has become inaccessible).  Throws if
   // the size of value is greater than the current specified maximum disk usage, or if the value
@@ -71,15 +163,58 @@ class DataBuffer {
   // store to memory, blocks until there is enough space to store to disk.  Space will be made
   // available via external calls to Delete, and also automatically if pop_functor_ is not NULL.
   void Store(const KeyType& key, const NonEmptyString& value);
+  // As above, but the buffer holds 'value' itself in memory rather than a copy.  Throws if 'value'
+  // is null.
+  void Store(const KeyType& key, SharedValue value);
   // Throws if the background worker has thrown (e.g. the disk has become inaccessible).  Throws if
   // the value can't be read from disk.  If the value isn't in memory and has started to be stored
-  // to disk, blocks briefly while waiting for the storing to complete.
+  // to disk, blocks briefly while waiting for the storing to complete.  Unless the eviction policy
+  // is kFifo, a value read from disk is queued to be promoted into memory.
   NonEmptyString Get(const KeyType& key);
+  // As above, but a value held in memory is returned without being copied.
+  SharedValue GetShared(const KeyType& key);
+  // As Get, except that an empty optional is returned rather than throwing if 'key' isn't held.
+  boost::optional<NonEmptyString> TryGet(const KeyType& key);
+  // Throws if the background worker has thrown.  Doesn't wait for values being stored to disk.
+  bool Has(const KeyType& key);
   // Throws if the background worker has thrown (e.g. the disk has become inaccessible).  Throws if
   // the value was written to disk and can't be removed.
   void Delete(const KeyType& key);
   // Delete based on a predicate, allows pairs etc. to be used as key
   void Delete(std::function<bool(const KeyType&)> predicate);
+
+  // Batch equivalents of Store, Get and Delete which take each tier's lock once per batch rather
+  // than once per key.  StoreBatch reserves memory for as many consecutive values as fit at once,
+  // and writes values too large for memory to disk under a single acquisition of its lock.
+  // Otherwise these behave as the single-key functions, except that GetBatch returns a null value
+  // for each key which isn't held, and DeleteBatch ignores such keys.  If StoreBatch is given a
+  // key more than once, only its last value is stored.
+  void StoreBatch(const std::vector<std::pair<KeyType, NonEmptyString>>& key_values);
+  void StoreBatch(const std::vector<std::pair<KeyType, SharedValue>>& key_values);
+  std::vector<SharedValue> GetBatch(const std::vector<KeyType>& keys);
+  void DeleteBatch(const std::vector<KeyType>& keys);
+
+  // Asynchronous equivalents of Store, Get and Delete which never block a thread of 'asio_service'
+  // waiting for space or for a value to finish being written to disk.  Instead, the operation is
+  // queued and retried on 'asio_service' whenever the buffer's state changes.  The handler is
+  // invoked on 'asio_service' with the error code of anything the synchronous equivalent would
+  // have thrown; the future holds the exception itself.  'asio_service' must keep running until all
+  // operations have completed.  On destruction, queued operations complete with an error, and the
+  // destructor blocks until all operations have completed, so it shouldn't be called from a thread
+  // of 'asio_service'.
+  void StoreAsync(AsioService& asio_service, const KeyType& key, const NonEmptyString& value,
+                  StoreHandler handler);
+  std::future<void> StoreAsync(AsioService& asio_service, const KeyType& key,
+                               const NonEmptyString& value);
+  void GetAsync(AsioService& asio_service, const KeyType& key, GetHandler handler);
+  std::future<NonEmptyString> GetAsync(AsioService& asio_service, const KeyType& key);
+  void DeleteAsync(AsioService& asio_service, const KeyType& key, DeleteHandler handler);
+  std::future<void> DeleteAsync(AsioService& asio_service, const KeyType& key);
+
+  // Counters and histograms are updated with relaxed atomic operations and read without locking.
+  // The usage figures are copied under each tier's lock in turn, so are each consistent.
+  Statistics Stats();
+
   // Throws if max_memory_usage > max_disk_usage_.
   void SetMaxMemoryUsage(MemoryUsage max_memory_usage);
   // Throws if max_memory_usage_ > max_disk_usage.
@@ -105,38 +240,160 @@ class DataBuffer {
 
   enum class StoringState { kNotStarted, kStarted, kCancelled, kCompleted };
 
+  using KeyFilter = CountingBloomFilter<KeyType, KeyHash>;
+
+  struct Counters {
+    std::atomic<uint64_t> stores{0}, memory_hits{0}, disk_hits{0}, misses{0}, deletes{0};
+    std::atomic<uint64_t> spills{0}, spilled_bytes{0}, pops{0}, popped_bytes{0};
+    std::atomic<uint64_t> memory_evictions{0}, promotions{0};
+    std::atomic<uint64_t> memory_wait_nanoseconds{0}, disk_wait_nanoseconds{0};
+    LatencyHistogram store_latency, get_latency, spill_latency;
+  };
+
+  // Elements held in eviction order (insertion order unless moved), with a hashed index on their
+  // keys giving O(1) lookup, removal and access to the first element.  Duplicate keys are tolerated
+  // (e.g. a cancelled disk entry which has not yet been removed alongside its replacement); 'find'
+  // returns the one inserted first.  If a filter has been set, every key added to or removed from
+  // the index is added to or removed from the filter.
+  template <typename Element>
+  class HashedIndex {
+   public:
+    using value_type = Element;
+    using iterator = typename std::list<Element>::iterator;
+
+    HashedIndex() : elements_(), lookup_(), next_sequence_number_(0), filter_(nullptr) {}
+
+    void set_filter(KeyFilter* filter) { filter_ = filter; }
+
+    iterator begin() { return elements_.begin(); }
+    iterator end() { return elements_.end(); }
+    bool empty() const { return elements_.empty(); }
+    std::size_t size() const { return elements_.size(); }
+
+    template <typename... Args>
+    iterator emplace_back(Args&&... args) {
+      return emplace(elements_.end(), std::forward<Args>(args)...);
+    }
+    template <typename... Args>
+    iterator emplace(iterator position, Args&&... args);
+    // Returns a number which uniquely identifies the insertion of the element at 'itr'.
+    uint64_t sequence_number(iterator itr) { return FindInLookup(itr)->second.first; }
+    // Moves the element at 'itr' to before 'position' without invalidating any iterators.
+    void move_before(iterator position, iterator itr) {
+      elements_.splice(position, elements_, itr);
+    }
+    iterator erase(iterator itr);
+    iterator find(const KeyType& key);
+    // Returns the oldest element with 'key' for which 'predicate' returns true.
+    template <typename Predicate>
+    iterator find(const KeyType& key, Predicate predicate);
+
+   private:
+    using Lookup = std::unordered_multimap<KeyType, std::pair<uint64_t, iterator>, KeyHash>;
+    typename Lookup::iterator FindInLookup(iterator itr);
+
+    std::list<Element> elements_;
+    Lookup lookup_;
+    uint64_t next_sequence_number_;
+    KeyFilter* filter_;
+  };
+
   struct MemoryElement {
-    MemoryElement(KeyType key_in, NonEmptyString value_in)
+    MemoryElement(KeyType key_in, SharedValue value_in)
         : key(std::move(key_in)),
           value(std::move(value_in)),
           also_on_disk(StoringState::kNotStarted) {}
     KeyType key;
-    NonEmptyString value;
+    SharedValue value;
     StoringState also_on_disk;
   };
 
-  using MemoryIndex = std::deque<MemoryElement>;
+  using MemoryIndex = HashedIndex<MemoryElement>;
 
   struct DiskElement {
     explicit DiskElement(KeyType key_in) : key(std::move(key_in)), state(StoringState::kStarted) {}
     KeyType key;
     StoringState state;
   };
-  using DiskIndex = std::deque<DiskElement>;
+  using DiskIndex = HashedIndex<DiskElement>;
+
+  void Init(DiskBackend disk_backend, ExistingValues existing_values);
+  void RecoverDiskIndex();
 
-  void Init();
+  // A value read from disk, along with the sequence number of its disk index entry so that the
+  // promotion can be abandoned if the value has since been replaced.
+  struct QueuedPromotion {
+    QueuedPromotion(KeyType key_in, SharedValue value_in, uint64_t disk_sequence_number_in)
+        : key(std::move(key_in)),
+          value(std::move(value_in)),
+          disk_sequence_number(disk_sequence_number_in) {}
+    KeyType key;
+    SharedValue value;
+    uint64_t disk_sequence_number;
+  };
 
-  std::unique_lock<std::mutex> StoreInMemory(const KeyType& key, const NonEmptyString& value);
-  void WaitForSpaceInMemory(uint64_t required_space,
-                            std::unique_lock<std::mutex>& memory_store_lock);
-  void StoreOnDisk(const KeyType& key, const NonEmptyString& value,
-                   std::unique_lock<std::mutex>&& disk_store_lock);
-  void WaitForSpaceOnDisk(const KeyType& key, const NonEmptyString* const value,
+  void RecordAccess(const KeyType& key);
+  void QueuePromotions(std::vector<QueuedPromotion> promotions);
+  void PromoteQueuedValues();
+  void PromoteToMemory(QueuedPromotion& promotion);
+
+  // An asynchronous operation is retried until 'attempt' returns true, having completed it.
+  struct AsyncWaiter {
+    AsyncWaiter(AsioService* asio_service_in, std::function<bool()> attempt_in)
+        : asio_service(asio_service_in), attempt(std::move(attempt_in)) {}
+    AsioService* asio_service;
+    std::function<bool()> attempt;
+  };
+
+  void StartAsync(AsioService& asio_service, std::function<bool()> attempt);
+  void PostAttempt(AsioService& asio_service, std::function<bool()> attempt);
+  void RetryAsyncWaiters();
+  template <typename T>
+  void NotifyWaiters(T& store);
+
+  // If 'wait' is false, these return false rather than blocking.
+  bool DoStore(const KeyType& key, const SharedValue& value, bool wait);
+  bool DoGet(const KeyType& key, bool wait, SharedValue& value);
+  // As Delete(key), but not counted in the statistics, so that Store can replace a value.
+  void DoDelete(const KeyType& key);
+  // These require the corresponding store's mutex to be held.  GetFromMemory returns false if 'key'
+  // isn't in memory.  GetFromDisk throws if 'key' isn't on disk; if the value is read, a promotion
+  // is added to 'promotions' unless the eviction policy is kFifo.
+  bool GetFromMemory(const KeyType& key, SharedValue& value);
+  // As GetFromDisk, but returns false rather than throwing if 'key' isn't on disk.
+  bool GetFromDiskIfHeld(const KeyType& key, std::unique_lock<std::mutex>& disk_store_lock,
+                         SharedValue& value, std::vector<QueuedPromotion>& promotions);
+  // Returns false if the filter shows that 'key' isn't held.  Requires no lock to be held.  Throws
+  // if returning false after the background worker has stopped.
+  bool MightHold(const KeyType& key);
+  bool GetFromDisk(const KeyType& key, bool wait, std::unique_lock<std::mutex>& disk_store_lock,
+                   SharedValue& value, std::vector<QueuedPromotion>& promotions);
+  std::unique_lock<std::mutex> StoreInMemory(const KeyType& key, const SharedValue& value,
+                                             bool wait, bool& would_block);
+  bool WaitForSpaceInMemory(uint64_t required_space,
+                            std::unique_lock<std::mutex>& memory_store_lock, bool wait);
+  bool StoreOnDisk(const KeyType& key, const SharedValue& value,
+                   std::unique_lock<std::mutex>&& disk_store_lock, bool wait);
+  void WaitForSpaceOnDisk(const KeyType& key, const SharedValue& value,
                           std::unique_lock<std::mutex>& disk_store_lock, bool& cancelled);
+  // These require disk_store_.mutex to be held.  WriteValueToDisk requires a disk index entry for
+  // 'key' to have been added.
+  void ThrowIfTooLargeForDisk(const KeyType& key, uint64_t size);
+  void WriteValueToDisk(const KeyType& key, const SharedValue& value,
+                        std::unique_lock<std::mutex>& disk_store_lock);
+  MemoryIndex::iterator EraseFromMemory(MemoryIndex::iterator itr);
   void DeleteFromMemory(const KeyType& key, StoringState& also_on_disk);
   void DeleteFromDisk(const KeyType& key);
+  // These require the corresponding store's mutex to be held, and return whether 'key' was found.
+  bool EraseKeyFromMemory(const KeyType& key, StoringState& also_on_disk);
+  bool EraseKeyFromDisk(const KeyType& key);
+  bool WriteToDisk(const KeyType& key, const NonEmptyString& value);
+  NonEmptyString ReadFromDisk(const KeyType& key);
   void RemoveFile(const KeyType& key, NonEmptyString* value);
 
+  static void Count(std::atomic<uint64_t>& counter, uint64_t amount = 1);
+  static std::chrono::nanoseconds Since(std::chrono::steady_clock::time_point start);
+
   void CopyQueueToDisk();
   void CheckWorkerIsStillRunning();
   void StopRunning();
@@ -150,7 +407,7 @@ class DataBuffer {
 
   MemoryIndex::iterator FindOldestInMemoryOnly();
   MemoryIndex::iterator FindMemoryRemovalCandidate(
-      uint64_t required_space, std::unique_lock<std::mutex>& memory_store_lock);
+      uint64_t required_space, std::unique_lock<std::mutex>& memory_store_lock, bool wait);
 
   DiskIndex::iterator FindStartedToStoreOnDisk(const KeyType& key);
   DiskIndex::iterator FindOldestOnDisk();
@@ -161,15 +418,104 @@ class DataBuffer {
 
   Storage<MemoryUsage, MemoryIndex> memory_store_;
   Storage<DiskUsage, DiskIndex> disk_store_;
+  // Oldest memory element not yet picked up by the disk worker (elements are appended and picked up
+  // in order, so all those not started form a contiguous tail of the memory index).
+  MemoryIndex::iterator oldest_memory_only_;
   const PopFunctor kPopFunctor_;
   const boost::filesystem::path kDiskBuffer_;
   const bool kShouldRemoveRoot_;
-  std::map<KeyType, const NonEmptyString*> elements_being_moved_to_disk_{};
+  // Null unless the disk backend is DiskBackend::kSegmentLog.
+  std::unique_ptr<SegmentLog> segment_log_;
+  // Null unless an expected key count was given.  Shared by both tiers' indices, so a key is in the
+  // filter while either tier holds an entry for it.
+  std::unique_ptr<KeyFilter> key_filter_;
+  // The maximum number of values the disk worker copies under a single acquisition of the locks.
+  static const std::size_t kMaxCopyBatchSize_;
+  const EvictionPolicy kEvictionPolicy_;
+  Counters counters_;
+  // The following are guarded by memory_store_.mutex.  Keys are held in 'keys_being_deleted_' from
+  // the start to the end of a call to Delete so that a queued promotion can't resurrect them.
+  const KeyHash kKeyHash_;
+  FrequencySketch frequency_sketch_;
+  std::vector<QueuedPromotion> queued_promotions_;
+  uint64_t queued_promotions_size_;
+  std::unordered_multiset<KeyType, KeyHash> keys_being_deleted_;
+  Statistics::Usage copy_backlog_{0, 0};
+  std::map<KeyType, SharedValue> elements_being_moved_to_disk_{};
   std::atomic<bool> running_{true};
+  // Asynchronous operations which would have blocked are held in 'async_waiters_' until the next
+  // state change.  'async_generation_' is incremented on each state change so that an attempt which
+  // raced with one is retried rather than queued.
+  std::mutex async_mutex_{};
+  std::condition_variable async_cond_var_{};
+  std::vector<AsyncWaiter> async_waiters_{};
+  uint64_t async_generation_{0};
+  std::atomic<std::size_t> async_operation_count_{0};
   std::mutex worker_mutex_{};
   std::future<void> worker_{};
 };
 
+template <typename Element>
+template <typename... Args>
+typename DataBuffer::HashedIndex<Element>::iterator DataBuffer::HashedIndex<Element>::emplace(
+    iterator position, Args&&... args) {
+  auto itr(elements_.emplace(position, std::forward<Args>(args)...));
+  try {
+    lookup_.emplace((*itr).key, std::make_pair(next_sequence_number_++, itr));
+  } catch (...) {
+    elements_.erase(itr);
+    throw;
+  }
+  if (filter_)
+    filter_->Add((*itr).key);
+  return itr;
+}
+
+template <typename Element>
+typename DataBuffer::HashedIndex<Element>::iterator DataBuffer::HashedIndex<Element>::erase(
+    iterator itr) {
+  auto lookup_itr(FindInLookup(itr));
+  assert(lookup_itr != lookup_.end());
+  lookup_.erase(lookup_itr);
+  if (filter_)
+    filter_->Remove((*itr).key);
+  return elements_.erase(itr);
+}
+
+template <typename Element>
+typename DataBuffer::HashedIndex<Element>::iterator DataBuffer::HashedIndex<Element>::find(
+    const KeyType& key) {
+  return find(key, [](const Element&) { return true; });
+}
+
+template <typename Element>
+template <typename Predicate>
+typename DataBuffer::HashedIndex<Element>::iterator DataBuffer::HashedIndex<Element>::find(
+    const KeyType& key, Predicate predicate) {
+  // Other than transiently, there will be at most one element with a given key.
+  auto range(lookup_.equal_range(key));
+  auto result(elements_.end());
+  uint64_t oldest(std::numeric_limits<uint64_t>::max());
+  for (auto lookup_itr(range.first); lookup_itr != range.second; ++lookup_itr) {
+    if (lookup_itr->second.first < oldest && predicate(*lookup_itr->second.second)) {
+      oldest = lookup_itr->second.first;
+      result = lookup_itr->second.second;
+    }
+  }
+  return result;
+}
+
+template <typename Element>
+typename DataBuffer::HashedIndex<Element>::Lookup::iterator
+    DataBuffer::HashedIndex<Element>::FindInLookup(iterator itr) {
+  auto range(lookup_.equal_range((*itr).key));
+  for (auto lookup_itr(range.first); lookup_itr != range.second; ++lookup_itr) {
+    if (lookup_itr->second.second == itr)
+      return lookup_itr;
+  }
+  return lookup_.end();
+}
+
 }  // namespace maidsafe
 
 #endif  // MAIDSAFE_COMMON_DATA_BUFFER_H_
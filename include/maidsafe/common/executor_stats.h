@@ -0,0 +1,139 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  Optional instrumentation for the queues of handlers run by an IoService or an Active, to show
+  whether their threads are keeping up.  An ExecutorStats passed to either's constructor records
+  the time each handler is queued, how long it then waits before starting to run, how long it runs
+  for, and how many handlers are queued or running at any moment.  Without one, the only cost is a
+  null pointer check per handler.
+
+  An ExecutorStatsReporter logs snapshots of a set of ExecutorStats periodically.
+*/
+
+#ifndef MAIDSAFE_COMMON_EXECUTOR_STATS_H_
+#define MAIDSAFE_COMMON_EXECUTOR_STATS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/latency_histogram.h"
+#include "maidsafe/common/periodic_thread.h"
+
+namespace maidsafe {
+
+class ExecutorStats {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Snapshot {
+    std::string name;
+    // Handlers queued and finished (returned or thrown) since construction.
+    std::uint64_t queued, completed;
+    // Handlers queued or running at the time of the snapshot, and the most there have been.
+    std::uint64_t backlog, max_backlog;
+    LatencyHistogram::Snapshot queue_wait, run_time;
+  };
+
+  explicit ExecutorStats(std::string name);
+  ExecutorStats(const ExecutorStats&) = delete;
+  ExecutorStats& operator=(const ExecutorStats&) = delete;
+
+  // Called by the executor as a handler is queued.  Returns the time to be passed to Started.
+  Clock::time_point Queued();
+  // Called by the executor as a handler starts to run.  Returns the time to be passed to Finished.
+  Clock::time_point Started(Clock::time_point queued_time);
+  void Finished(Clock::time_point start_time);
+
+  // Counters and histograms are read without locking, so a snapshot taken while handlers are
+  // being queued or run may be slightly inconsistent.
+  Snapshot GetSnapshot() const;
+  const std::string& Name() const { return kName_; }
+
+ private:
+  const std::string kName_;
+  std::atomic<std::uint64_t> queued_, completed_, max_backlog_;
+  LatencyHistogram queue_wait_, run_time_;
+};
+
+// Writes a one-line summary, e.g. for logging.
+std::ostream& operator<<(std::ostream& stream, const ExecutorStats::Snapshot& snapshot);
+
+// Logs a snapshot of each of 'stats' at kInfo every 'interval' from a thread of its own, until
+// destroyed.
+class ExecutorStatsReporter {
+ public:
+  ExecutorStatsReporter(std::vector<std::shared_ptr<const ExecutorStats>> stats,
+                        std::chrono::steady_clock::duration interval);
+  ExecutorStatsReporter(const ExecutorStatsReporter&) = delete;
+  ExecutorStatsReporter& operator=(const ExecutorStatsReporter&) = delete;
+
+  // Logs a snapshot of each now.
+  void Report() const;
+
+ private:
+  const std::vector<std::shared_ptr<const ExecutorStats>> kStats_;
+  PeriodicThread periodic_thread_;
+};
+
+namespace detail {
+
+// Records the start of a handler's run on construction, and its end on destruction (so even if the
+// handler throws).
+class ExecutorRunScope {
+ public:
+  ExecutorRunScope(ExecutorStats& stats, ExecutorStats::Clock::time_point queued_time)
+      : stats_(stats), start_time_(stats.Started(queued_time)) {}
+  ~ExecutorRunScope() { stats_.Finished(start_time_); }
+  ExecutorRunScope(const ExecutorRunScope&) = delete;
+  ExecutorRunScope& operator=(const ExecutorRunScope&) = delete;
+
+ private:
+  ExecutorStats& stats_;
+  const ExecutorStats::Clock::time_point start_time_;
+};
+
+// Wraps a handler posted to an instrumented IoService.  The ExecutorStats must outlive it.
+template <typename Handler>
+class InstrumentedHandler {
+ public:
+  InstrumentedHandler(ExecutorStats& stats, Handler handler)
+      : stats_(&stats), handler_(std::move(handler)), queued_time_(stats.Queued()) {}
+
+  void operator()() {
+    const ExecutorRunScope run_scope(*stats_, queued_time_);
+    handler_();
+  }
+
+ private:
+  ExecutorStats* stats_;
+  Handler handler_;
+  ExecutorStats::Clock::time_point queued_time_;
+};
+
+}  // namespace detail
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_EXECUTOR_STATS_H_
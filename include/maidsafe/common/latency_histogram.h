@@ -0,0 +1,76 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_LATENCY_HISTOGRAM_H_
+#define MAIDSAFE_COMMON_LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace maidsafe {
+
+// A histogram of durations with log-linear buckets: each power of two of nanoseconds is split into
+// 8 equal buckets, so any recorded duration is reported to within 12.5% across the full range of
+// Duration.  Negative durations are recorded as zero.
+//
+// Record only uses relaxed atomic operations, so may be called from any number of threads with
+// negligible overhead.  A snapshot taken concurrently with Record may include only part of some of
+// those recordings (e.g. a bucket count but not its duration in 'total').
+class LatencyHistogram {
+ public:
+  using Duration = std::chrono::nanoseconds;
+
+  struct Snapshot {
+    Snapshot() : count(0), total(0), max(0), bucket_counts() {}
+    // Returns the upper bound of the bucket holding the given percentile (in the range [0, 100]),
+    // capped at 'max'.  Returns zero if 'count' is zero.
+    Duration Percentile(double percentile) const;
+    Duration Mean() const;
+    // Adds the durations counted in 'other', e.g. to combine the histograms of several instances.
+    void Merge(const Snapshot& other);
+
+    std::uint64_t count;
+    Duration total, max;
+    std::vector<std::uint64_t> bucket_counts;
+  };
+
+  LatencyHistogram();
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void Record(Duration duration);
+  Snapshot GetSnapshot() const;
+
+  // The smallest and largest durations counted in bucket 'index'.
+  static Duration BucketLowerBound(std::size_t index);
+  static Duration BucketUpperBound(std::size_t index);
+  static std::size_t BucketIndex(Duration duration);
+
+  static const std::size_t kBucketCount = 488;
+
+ private:
+  std::array<std::atomic<std::uint64_t>, kBucketCount> buckets_;
+  std::atomic<std::uint64_t> total_, max_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_LATENCY_HISTOGRAM_H_
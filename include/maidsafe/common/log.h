@@ -42,6 +42,10 @@
 #include "boost/program_options/variables_map.hpp"
 
 #include "maidsafe/common/active.h"
+#include "maidsafe/common/binary_log.h"
+#include "maidsafe/common/executor_stats.h"
+#include "maidsafe/common/log_file.h"
+#include "maidsafe/common/periodic_thread.h"
 
 #ifndef USE_LOGGING
 #ifdef NDEBUG
@@ -54,6 +58,7 @@
 namespace maidsafe {
 
 namespace test {
+class LogTest;
 class VisualiserLogTest;
 }
 
@@ -70,6 +75,11 @@ class OstreamBinder {
   OstreamBinder(BoundLeft& left, BoundRight& right) : left_(left), right_(right) {}
 
   void Serialise(std::ostream& out) const { out << left_ << right_; }
+  // Only valid if IsDeferrable is true for this type.
+  void Encode(ArgumentWriter& writer) const {
+    EncodeArgument(writer, left_);
+    EncodeArgument(writer, right_);
+  }
 
  private:
   BoundLeft& left_;
@@ -80,8 +90,20 @@ template <>
 class OstreamBinder<void, void> {
  public:
   void Serialise(std::ostream&) const {}
+  void Encode(ArgumentWriter&) const {}
 };
 
+template <typename Left, typename Right>
+struct IsDeferrable<OstreamBinder<Left, Right>>
+    : std::integral_constant<bool, IsDeferrable<Left>::value && IsDeferrable<Right>::value> {};
+template <>
+struct IsDeferrable<OstreamBinder<void, void>> : std::true_type {};
+
+template <typename BoundLeft, typename BoundRight>
+void EncodeArgument(ArgumentWriter& writer, const OstreamBinder<BoundLeft, BoundRight>& binder) {
+  binder.Encode(writer);
+}
+
 template <typename BoundLeft, typename BoundRight, typename Right>
 OstreamBinder<OstreamBinder<BoundLeft, BoundRight>, Right> operator<<(
     const OstreamBinder<BoundLeft, BoundRight>& left, const Right& right) {
@@ -99,36 +121,82 @@ struct NullStream {
   void operator=(const OstreamBinder<Left, Right>&) const {}
 };
 
-class LogMessage {
+// Set while the binary backend (enabled with the 'log_binary' option) is running.
+extern std::atomic<BinaryLog*> g_binary_log;
+
+// Incremented whenever the filter changes, invalidating the decisions cached by every
+// CallSiteFilter.
+extern std::atomic<std::uint32_t> g_filter_generation;
+
+// Each LOG statement has a function-local static CallSiteFilter and CallSiteFile.  Both are
+// constant-initialised, so need no guard on first use, and have trivial destructors.
+
+// Caches whether a LOG statement passes the filter.  Once cached, deciding costs two relaxed atomic
+// loads and a comparison.
+class CallSiteFilter {
+ public:
+  constexpr CallSiteFilter() : state_(0) {}
+  // 'file' and 'level' must be the same on every call.
+  bool ShouldLog(const char* file, int level) {
+    const std::uint32_t generation(g_filter_generation.load(std::memory_order_relaxed));
+    const std::uint32_t state(state_.load(std::memory_order_relaxed));
+    return (state >> 1) == generation ? (state & 1U) != 0 : Update(file, level);
+  }
+
  private:
-  struct FileInfo {
-    FileInfo(std::string project, std::string contract_file)
-        : project_(std::move(project)), contract_file_(std::move(contract_file)) {}
-    const std::string project_;
-    const std::string contract_file_;
+  bool Update(const char* file, int level);
+  // The filter generation of the cached decision (zero if none) shifted left one bit, plus one if
+  // the decision is to log.
+  std::atomic<std::uint32_t> state_;
+};
+
+// Caches the project and cleaned-up filename of a LOG statement.
+class CallSiteFile {
+ public:
+  struct Info {
+    Info(std::string project_in, std::string contract_file_in)
+        : project(std::move(project_in)), contract_file(std::move(contract_file_in)) {}
+    const std::string project;
+    const std::string contract_file;
   };
 
+  constexpr CallSiteFile() : info_(nullptr) {}
+  // 'file' must be the same on every call.
+  const Info& Get(const char* file);
+
+ private:
+  // Allocated on first use and deliberately never freed.
+  std::atomic<const Info*> info_;
+};
+
+class LogMessage {
  public:
-  LogMessage(const char* const file, const int level) : file_(file), level_(level) {}
+  LogMessage(const char* const file, const int level, CallSiteFile& call_site_file)
+      : file_(file), level_(level), call_site_file_(call_site_file) {}
 
+  // Only called if the filter has been passed.
   template <typename BoundLeft, typename BoundRight>
   void operator=(const OstreamBinder<BoundLeft, BoundRight>& binder) const {
-    const boost::optional<FileInfo> should_log(ShouldLog());
-    if (should_log) {
-      std::ostringstream out;
-      out << " " << should_log->contract_file_ << binder << "\n";
-      Log(should_log->project_, out.str());
+    BinaryLog* const binary_log(g_binary_log.load(std::memory_order_acquire));
+    if (binary_log) {
+      binary_log->Write(level_, call_site_file_, file_, binder);
+      return;
     }
+    const CallSiteFile::Info& file_info(call_site_file_.Get(file_));
+    std::ostringstream out;
+    out << " " << file_info.contract_file << binder << "\n";
+    Log(file_info.project, out.str());
   }
 
  private:
-  boost::optional<FileInfo> ShouldLog() const;
   void Log(const std::string& project, std::string message) const;
 
  private:
   const char* const file_;
   const int level_;
+  CallSiteFile& call_site_file_;
 };
+
 }  // namespace detail
 
 // Convert to map<string, int, std::less<>> when C++14 mode is enabled
@@ -141,12 +209,27 @@ enum class ColourMode { kNone, kPartialLine, kFullLine };
 const int kVerbose = -1, kInfo = 0, kSuccess = 1, kWarning = 2, kError = 3, kAlways = 4;
 
 #if USE_LOGGING
-#define LOG(level)                                                    \
-  maidsafe::log::detail::LogMessage(__FILE__, maidsafe::log::level) = \
-      maidsafe::log::detail::OstreamBinder<void, void>() << ":" << __LINE__ << "] "
+// The streamed values are only evaluated if the statement passes the filter.
+#define LOG(level)                                                                               \
+  !MAIDSAFE_LOG_STATIC(maidsafe::log::detail::CallSiteFilter)                                    \
+          .ShouldLog(__FILE__, maidsafe::log::level)                                             \
+      ? static_cast<void>(0)                                                                     \
+      : maidsafe::log::detail::LogMessage(                                                       \
+            __FILE__, maidsafe::log::level,                                                      \
+            MAIDSAFE_LOG_STATIC(maidsafe::log::detail::CallSiteFile)) =                          \
+            maidsafe::log::detail::OstreamBinder<void, void>() << ":" << __LINE__ << "] "
+// Evaluates to a static instance of 'Type' unique to the point of expansion.
+#define MAIDSAFE_LOG_STATIC(Type) \
+  ([]() -> Type& {                \
+    static Type instance;         \
+    return instance;              \
+  }())
 #else
-#define LOG(_) \
-  maidsafe::log::detail::NullStream() = maidsafe::log::detail::OstreamBinder<void, void>()
+// Logging is compiled out, so the streamed values are never evaluated.
+#define LOG(_)                                                                                   \
+  true ? static_cast<void>(0)                                                                    \
+       : maidsafe::log::detail::NullStream() =                                                   \
+             maidsafe::log::detail::OstreamBinder<void, void>()
 #endif
 #define TLOG(colour) maidsafe::log::TestLogMessage(maidsafe::log::Colour::colour).MessageStream()
 
@@ -171,26 +254,30 @@ class Logging {
                       const std::string& server_name, uint16_t server_port,
                       const std::string& server_dir);
   void Send(std::function<void()> message_functor);
-  void WriteToCombinedLogfile(const std::string& message);
+  // Messages at kError or above are written out immediately, others may be buffered.
+  void WriteToCombinedLogfile(const std::string& message, int level = kAlways);
   void WriteToVisualiserLogfile(const std::string& message);
   void WriteToVisualiserServer(const std::string& message);
-  void WriteToProjectLogfile(const std::string& project, const std::string& message);
+  void WriteToProjectLogfile(const std::string& project, const std::string& message,
+                             int level = kAlways);
   FilterMap Filter() const { return filter_; }
   bool Async() const { return !no_async_ && background_; }
   bool LogToConsole() const { return !no_log_to_console_; }
   ColourMode Colour() const { return colour_mode_; }
   std::string VlogPrefix() const;
   std::string VlogSessionId() const;
+  // Writes out the log files' buffers, after waiting for the binary backend (if running) to output
+  // everything logged by this thread.
   void Flush();
+  // Returns nullptr unless the 'log_executor_stats' option was set.
+  std::shared_ptr<const ExecutorStats> BackgroundStats() const {
+    return background_ ? background_->Stats() : nullptr;
+  }
 
+  friend class test::LogTest;
   friend class test::VisualiserLogTest;
 
  private:
-  struct LogFile {
-    LogFile() : stream(), mutex() {}
-    std::ofstream stream;
-    std::mutex mutex;
-  };
   struct Visualiser {
     Visualiser()
         : prefix("Vault ID uninitialised"),
@@ -203,7 +290,7 @@ class Logging {
           initialised(false),
           initialised_once_flag() {}
     std::string prefix, session_id;
-    LogFile logfile;
+    detail::LogFile logfile;
     asio::ip::tcp::iostream server_stream;
     std::string server_name, server_dir;
     uint16_t server_port;
@@ -211,11 +298,18 @@ class Logging {
     std::once_flag initialised_once_flag;
   };
   Logging();
+  ~Logging();
   bool IsHelpOption(const boost::program_options::options_description& log_config) const;
   void HandleFilterOptions();
+  void SetFilter(FilterMap filter);
   boost::filesystem::path GetLogfileName(const std::string& project) const;
   void SetStreams();
-  void WriteToLogfile(const std::string& message, LogFile& log_file);
+  void FlushLogFiles();
+  void StartBackground(int executor_stats_interval);
+  void StartBinaryLog(detail::BinaryLog::OverflowPolicy overflow_policy);
+  // Outputs everything already logged via the binary backend, then reverts to the default one.
+  // Nothing may be logged concurrently.
+  void StopBinaryLog();
 
   boost::program_options::variables_map log_variables_;
   FilterMap filter_;
@@ -223,10 +317,17 @@ class Logging {
   std::time_t start_time_;
   boost::filesystem::path log_folder_;
   ColourMode colour_mode_;
-  LogFile combined_logfile_stream_;
-  std::map<std::string, std::unique_ptr<LogFile>> project_logfile_streams_;
+  detail::LogFile combined_logfile_stream_;
+  std::map<std::string, std::unique_ptr<detail::LogFile>> project_logfile_streams_;
   Visualiser visualiser_;
+  // Declared after the log files, and before 'background_', so that it's stopped after the last
+  // rotation and before the files are closed.
+  std::unique_ptr<Active> log_file_compressor_;
   std::unique_ptr<Active> background_;
+  // Declared after 'background_' so that it's stopped first.
+  std::unique_ptr<ExecutorStatsReporter> background_stats_reporter_;
+  std::unique_ptr<detail::BinaryLog> binary_log_;
+  std::unique_ptr<PeriodicThread> log_file_flusher_;
 };
 
 namespace detail {
@@ -0,0 +1,102 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  The files written by Logging.  Messages are gathered in a buffer and written out together once
+  the buffer is full, when a message must be written immediately (e.g. errors), or when flushed.
+  Logging flushes every file periodically, and on Logging::Flush and shutdown.
+
+  Optionally, once a file reaches a maximum size it's renamed with a sequence number, e.g.
+  "<start time>_vault.log" becomes "<start time>_vault.1.log", and a new file started in its place.
+  Renamed files can be gzipped by a background Active, and all but the most recent few deleted.
+
+  Except in functors sent to the compressor, nothing here may LOG, since it's called by the logging
+  code itself, possibly with its locks held.
+*/
+
+#ifndef MAIDSAFE_COMMON_LOG_FILE_H_
+#define MAIDSAFE_COMMON_LOG_FILE_H_
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+#include "boost/filesystem/path.hpp"
+
+namespace maidsafe {
+
+class Active;
+
+namespace log {
+
+namespace detail {
+
+class LogFile {
+ public:
+  struct Options {
+    Options() : buffer_size(0), max_file_size(0), max_rotated_files(0), compressor(nullptr) {}
+    // Messages are written out once more than this many bytes are buffered.  0 writes each message
+    // out immediately.
+    std::size_t buffer_size;
+    // Files are rotated before exceeding this many bytes.  0 disables rotation.
+    std::uint64_t max_file_size;
+    // The number of rotated files to keep.  0 keeps them all.
+    unsigned max_rotated_files;
+    // If set, rotated files are gzipped, and deleted when no longer kept, by functors sent to this.
+    // It must outlive the LogFile.
+    Active* compressor;
+  };
+
+  LogFile();
+  // Flushes.
+  ~LogFile();
+  LogFile(const LogFile&) = delete;
+  LogFile& operator=(const LogFile&) = delete;
+
+  // Creates or truncates the file at 'path', first closing any file already open.  If this fails,
+  // messages are discarded.
+  void Open(const boost::filesystem::path& path, const Options& options);
+  // 'flush' forces the message, and any buffered before it, to be written out now.
+  void Write(const std::string& message, bool flush);
+  void Flush();
+
+  // The name given to a file on becoming the 'index'th rotated from 'path'.
+  static boost::filesystem::path RotatedPath(const boost::filesystem::path& path, unsigned index);
+
+ private:
+  // These are called with 'mutex_' held.
+  void WriteOut();
+  void Rotate();
+
+  std::mutex mutex_;
+  boost::filesystem::path path_;
+  Options options_;
+  std::ofstream stream_;
+  std::string buffer_;
+  std::uint64_t file_size_;
+  unsigned rotated_count_;
+};
+
+}  // namespace detail
+
+}  // namespace log
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_LOG_FILE_H_
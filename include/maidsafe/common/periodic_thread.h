@@ -0,0 +1,53 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_PERIODIC_THREAD_H_
+#define MAIDSAFE_COMMON_PERIODIC_THREAD_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace maidsafe {
+
+// Calls 'functor' every 'interval' from a thread of its own, until destroyed.  The destructor wakes
+// the thread rather than waiting out the interval, but waits for a call already running to finish.
+// Nothing here may LOG, since the logging code itself uses this.
+class PeriodicThread {
+ public:
+  PeriodicThread(std::function<void()> functor, std::chrono::steady_clock::duration interval);
+  ~PeriodicThread();
+  PeriodicThread(const PeriodicThread&) = delete;
+  PeriodicThread& operator=(const PeriodicThread&) = delete;
+
+ private:
+  void Run();
+
+  const std::function<void()> kFunctor_;
+  const std::chrono::steady_clock::duration kInterval_;
+  bool stopping_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::thread thread_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_PERIODIC_THREAD_H_
@@ -16,17 +16,44 @@
     See the Licences for the specific language governing permissions and limitations relating to
     use of the MaidSafe Software.                                                                 */
 
+/*
+  SafeQueue is a thread-safe FIFO queue for any number of producers and consumers, optionally
+  bounded to apply backpressure: when it holds 'capacity' elements, Push blocks until there is
+  room, while TryPush and PushFor fail (immediately or after a timeout) instead.  PopAll and
+  PopUpTo move a batch of elements into a caller-supplied vector under a single lock, and waiting
+  threads are only notified if some are actually waiting.
+
+  SpscQueue is a lock-free, bounded ring buffer for the case of exactly one producer thread and one
+  consumer thread.  Its functions never block; a consumer which needs to wait should back off or be
+  notified separately.
+*/
+
 #ifndef MAIDSAFE_COMMON_SAFE_QUEUE_H_
 #define MAIDSAFE_COMMON_SAFE_QUEUE_H_
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <limits>
+#include <memory>
 #include <mutex>
 #include <queue>
+#include <utility>
+#include <vector>
 
 template <typename T>
 class SafeQueue {
  public:
-  SafeQueue() : queue_(), mutex_(), condition_() {}
+  explicit SafeQueue(size_t capacity = std::numeric_limits<size_t>::max())
+      : capacity_(std::max<size_t>(capacity, 1)),
+        queue_(),
+        mutex_(),
+        condition_(),
+        not_full_condition_(),
+        waiting_consumers_(0),
+        waiting_producers_(0) {}
 
   bool Empty() const {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -38,37 +65,219 @@ class SafeQueue {
     return queue_.size();
   }
 
+  size_t Capacity() const { return capacity_; }
+
+  // Blocks while the queue is full.
   void Push(T element) {
-    {
-      std::lock_guard<std::mutex> lock(mutex_);
-      queue_.push(std::move(element));
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (queue_.size() >= capacity_) {
+      ++waiting_producers_;
+      not_full_condition_.wait(lock, [this] { return queue_.size() < capacity_; });
+      --waiting_producers_;
     }
-    condition_.notify_one();
+    PushAndNotify(lock, std::move(element));
+  }
+
+  // Returns false without blocking if the queue is full, in which case 'element' is not moved from.
+  template <typename Element>
+  bool TryPush(Element&& element) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (queue_.size() >= capacity_)
+      return false;
+    PushAndNotify(lock, std::forward<Element>(element));
+    return true;
+  }
+
+  // Returns false if the queue is still full after 'timeout', in which case 'element' is not moved
+  // from.
+  template <typename Element, typename Rep, typename Period>
+  bool PushFor(Element&& element, const std::chrono::duration<Rep, Period>& timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (queue_.size() >= capacity_) {
+      ++waiting_producers_;
+      const bool has_room(not_full_condition_.wait_for(
+          lock, timeout, [this] { return queue_.size() < capacity_; }));
+      --waiting_producers_;
+      if (!has_room)
+        return false;
+    }
+    PushAndNotify(lock, std::forward<Element>(element));
+    return true;
   }
 
   bool TryPop(T& element) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::unique_lock<std::mutex> lock(mutex_);
     if (queue_.empty())
       return false;
-    element = std::move(queue_.front());
-    queue_.pop();
+    PopAndNotify(lock, element);
     return true;
   }
 
   void WaitAndPop(T& element) {
     std::unique_lock<std::mutex> lock(mutex_);
+    ++waiting_consumers_;
     while (queue_.empty())
       condition_.wait(lock);
-    element = std::move(queue_.front());
-    queue_.pop();
+    --waiting_consumers_;
+    PopAndNotify(lock, element);
+  }
+
+  // Returns false if the queue is still empty after 'timeout'.
+  template <typename Rep, typename Period>
+  bool WaitAndPopFor(T& element, const std::chrono::duration<Rep, Period>& timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (queue_.empty()) {
+      ++waiting_consumers_;
+      const bool has_element(
+          condition_.wait_for(lock, timeout, [this] { return !queue_.empty(); }));
+      --waiting_consumers_;
+      if (!has_element)
+        return false;
+    }
+    PopAndNotify(lock, element);
+    return true;
+  }
+
+  // Moves all queued elements to the back of 'elements' and returns how many were moved.
+  size_t PopAll(std::vector<T>& elements) {
+    return PopUpTo(elements, std::numeric_limits<size_t>::max());
+  }
+
+  // Moves up to 'count' queued elements to the back of 'elements' and returns how many were moved.
+  size_t PopUpTo(std::vector<T>& elements, size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    count = std::min(count, queue_.size());
+    elements.reserve(elements.size() + count);
+    for (size_t i(0); i != count; ++i) {
+      elements.push_back(std::move(queue_.front()));
+      queue_.pop();
+    }
+    const bool notify(count != 0 && waiting_producers_ != 0);
+    lock.unlock();
+    if (notify)
+      not_full_condition_.notify_all();
+    return count;
   }
 
  private:
   SafeQueue& operator=(const SafeQueue&);
   SafeQueue(const SafeQueue& other);
+
+  template <typename Element>
+  void PushAndNotify(std::unique_lock<std::mutex>& lock, Element&& element) {
+    queue_.push(std::forward<Element>(element));
+    const bool notify(waiting_consumers_ != 0);
+    lock.unlock();
+    if (notify)
+      condition_.notify_one();
+  }
+
+  void PopAndNotify(std::unique_lock<std::mutex>& lock, T& element) {
+    element = std::move(queue_.front());
+    queue_.pop();
+    const bool notify(waiting_producers_ != 0);
+    lock.unlock();
+    if (notify)
+      not_full_condition_.notify_one();
+  }
+
+  const size_t capacity_;
   std::queue<T> queue_;
   mutable std::mutex mutex_;
-  std::condition_variable condition_;
+  std::condition_variable condition_, not_full_condition_;
+  size_t waiting_consumers_, waiting_producers_;
+};
+
+template <typename T>
+class SpscQueue {
+ public:
+  // 'capacity' is rounded up to a power of two.  T must be default-constructible and
+  // move-assignable.
+  explicit SpscQueue(size_t capacity)
+      : mask_(RoundUpToPowerOfTwo(std::max<size_t>(capacity, 2)) - 1),
+        slots_(new T[mask_ + 1]),
+        tail_(0),
+        cached_head_(0),
+        head_(0),
+        cached_tail_(0) {}
+
+  // Approximate if called while the other thread is pushing or popping.  The head is read first,
+  // so that a pop between the two reads can't make the head appear to be ahead of the tail.
+  size_t Size() const {
+    const size_t head(head_.load(std::memory_order_acquire));
+    const size_t tail(tail_.load(std::memory_order_acquire));
+    return std::min<size_t>(tail - head, mask_ + 1);
+  }
+
+  size_t Capacity() const { return mask_ + 1; }
+
+  // Producer only.  Returns false if the queue is full, in which case 'element' is not moved from.
+  template <typename Element>
+  bool TryPush(Element&& element) {
+    const size_t tail(tail_.load(std::memory_order_relaxed));
+    if (tail - cached_head_ > mask_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ > mask_)
+        return false;
+    }
+    slots_[tail & mask_] = std::forward<Element>(element);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only.
+  bool TryPop(T& element) {
+    const size_t head(head_.load(std::memory_order_relaxed));
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_)
+        return false;
+    }
+    element = std::move(slots_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only.  As SafeQueue::PopAll.
+  size_t PopAll(std::vector<T>& elements) {
+    return PopUpTo(elements, std::numeric_limits<size_t>::max());
+  }
+
+  // Consumer only.  As SafeQueue::PopUpTo.
+  size_t PopUpTo(std::vector<T>& elements, size_t count) {
+    const size_t head(head_.load(std::memory_order_relaxed));
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+    count = std::min(count, cached_tail_ - head);
+    elements.reserve(elements.size() + count);
+    for (size_t i(0); i != count; ++i)
+      elements.push_back(std::move(slots_[(head + i) & mask_]));
+    head_.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+ private:
+  SpscQueue& operator=(const SpscQueue&);
+  SpscQueue(const SpscQueue& other);
+
+  static size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t result(1);
+    while (result < value)
+      result <<= 1;
+    return result;
+  }
+
+  // The producer's and consumer's indices are kept on separate cache lines.
+  static const size_t kCacheLineSize_ = 64;
+
+  const size_t mask_;
+  const std::unique_ptr<T[]> slots_;
+  char padding0_[kCacheLineSize_];
+  std::atomic<size_t> tail_;  // Written by the producer.
+  size_t cached_head_;        // The producer's last view of 'head_'.
+  char padding1_[kCacheLineSize_];
+  std::atomic<size_t> head_;  // Written by the consumer.
+  size_t cached_tail_;        // The consumer's last view of 'tail_'.
+  char padding2_[kCacheLineSize_];
 };
 
 #endif  // MAIDSAFE_COMMON_SAFE_QUEUE_H_
@@ -0,0 +1,132 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_SEGMENT_LOG_H_
+#define MAIDSAFE_COMMON_SEGMENT_LOG_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/data_buffer.h"
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/data_types/data.h"
+
+namespace maidsafe {
+
+// Disk backend for DataBuffer which appends values to a small number of large segment files rather
+// than writing one file per value.  An in-memory index maps each key to the location of its value.
+// Once the active segment reaches 'max_segment_size' it is sealed and a new one started.  Removing
+// a value only updates the index; when the proportion of a sealed segment's bytes which are still
+// live drops below 'min_live_ratio', a background worker copies its remaining values to the active
+// segment and deletes the sealed file.
+//
+// Each record is self-describing: a header holding the value size, key type and key name, followed
+// by the value.  All functions are thread-safe.
+//
+// Removed and replaced values keep taking space on disk until their segment is compacted, so the
+// segment files can be considerably larger than the live values they hold.  A sealed segment is
+// compacted once less than 'min_live_ratio' of it is live, and the active segment is never
+// compacted, so the total size of the files is bounded by roughly
+//     (live value bytes + live record headers) / min_live_ratio + max_segment_size
+// plus a segment's worth while a compaction is in progress.  With the defaults, this is about twice
+// the live bytes plus 8 MiB.
+class SegmentLog {
+ public:
+  using KeyType = Data::NameAndTypeId;
+
+  static const std::uint64_t kDefaultMaxSegmentSize;
+  static const double kDefaultMinLiveRatio;
+
+  SegmentLog() = delete;
+  SegmentLog(const SegmentLog&) = delete;
+  SegmentLog(SegmentLog&&) = delete;
+  SegmentLog& operator=(const SegmentLog&) = delete;
+  SegmentLog& operator=(SegmentLog&&) = delete;
+
+  // Throws if 'directory' doesn't exist or if a segment file can't be created in it.  Any existing
+  // segment files in 'directory' are discarded.  Starts the background compaction worker.
+  explicit SegmentLog(const boost::filesystem::path& directory,
+                      std::uint64_t max_segment_size = kDefaultMaxSegmentSize,
+                      double min_live_ratio = kDefaultMinLiveRatio);
+  ~SegmentLog();
+
+  // Appends the value, replacing any existing value for 'key'.  Throws if the value can't be
+  // written.
+  void Put(const KeyType& key, const NonEmptyString& value);
+  // Throws if 'key' isn't held or if the value can't be read.
+  NonEmptyString Get(const KeyType& key);
+  // Removes 'key', returning the size of its value.  If 'value' is not null, it is set to the
+  // removed value.  Throws if 'key' isn't held or if 'value' can't be read.
+  std::uint64_t Remove(const KeyType& key, NonEmptyString* value);
+
+  std::size_t SegmentCount() const;
+  // Blocks until the background worker has no outstanding compactions.
+  void WaitForCompaction();
+
+ private:
+  struct Location {
+    std::uint32_t segment_id;
+    std::uint64_t offset;  // of the start of the record header
+    std::uint32_t header_size, value_size;
+  };
+
+  struct Segment {
+    explicit Segment(boost::filesystem::path path_in);
+    boost::filesystem::path path;
+    std::fstream file;
+    std::uint64_t size, live_size;
+    bool sealed;
+  };
+
+  // These require 'mutex_' to be held.
+  Location Append(const KeyType& key, const NonEmptyString& value);
+  NonEmptyString Read(const Location& location);
+  void Release(const Location& location);
+  void StartNewSegment();
+  void ScheduleCompactionIfSparse(std::uint32_t segment_id);
+
+  void Compact();
+  void CompactSegment(std::uint32_t segment_id, std::unique_lock<std::mutex>& lock);
+
+  const boost::filesystem::path kDirectory_;
+  const std::uint64_t kMaxSegmentSize_;
+  const double kMinLiveRatio_;
+  mutable std::mutex mutex_;
+  std::condition_variable cond_var_;
+  std::unordered_map<KeyType, Location, DataBuffer::KeyHash> index_;
+  std::map<std::uint32_t, std::unique_ptr<Segment>> segments_;
+  std::uint32_t active_segment_id_;
+  std::set<std::uint32_t> pending_compactions_;
+  bool compacting_;
+  std::atomic<bool> running_;
+  std::future<void> worker_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_SEGMENT_LOG_H_
@@ -0,0 +1,134 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_SHARDED_DATA_BUFFER_H_
+#define MAIDSAFE_COMMON_SHARDED_DATA_BUFFER_H_
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "boost/filesystem/path.hpp"
+#include "boost/optional.hpp"
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/data_buffer.h"
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+// Splits the key space between a number of independent DataBuffers ("shards"), each with its own
+// locks, disk worker thread and share of the overall memory and disk limits.  The shard for a given
+// key is chosen by hashing the key.  Apart from the limits applying per shard (so a single value
+// must fit within one shard's share), the semantics are as for DataBuffer.
+class ShardedDataBuffer {
+ public:
+  using KeyType = DataBuffer::KeyType;
+  using PopFunctor = DataBuffer::PopFunctor;
+  using SharedValue = DataBuffer::SharedValue;
+  using DiskBackend = DataBuffer::DiskBackend;
+  using EvictionPolicy = DataBuffer::EvictionPolicy;
+  using StoreHandler = DataBuffer::StoreHandler;
+  using GetHandler = DataBuffer::GetHandler;
+  using DeleteHandler = DataBuffer::DeleteHandler;
+  using Statistics = DataBuffer::Statistics;
+
+  ShardedDataBuffer() = delete;
+  ShardedDataBuffer(const ShardedDataBuffer&) = delete;
+  ShardedDataBuffer(ShardedDataBuffer&&) = delete;
+  ShardedDataBuffer& operator=(const ShardedDataBuffer&) = delete;
+  ShardedDataBuffer& operator=(ShardedDataBuffer&&) = delete;
+
+  // Throws if shard_count is 0 or if max_memory_usage > max_disk_usage.  Each shard is given a
+  // separate folder in temp_directory_path().  If expected_key_count is not 0, each shard keeps a
+  // negative lookup filter sized for its share of that many keys.
+  ShardedDataBuffer(MemoryUsage max_memory_usage, DiskUsage max_disk_usage, PopFunctor pop_functor,
+                    std::size_t shard_count,
+                    DiskBackend disk_backend = DiskBackend::kFilePerValue,
+                    EvictionPolicy eviction_policy = EvictionPolicy::kFifo,
+                    std::size_t expected_key_count = 0);
+  // Throws if shard_count is 0 or if max_memory_usage > max_disk_usage.  Each shard is given a
+  // separate folder within "disk_buffer".  expected_key_count is as for the constructor above.
+  ShardedDataBuffer(MemoryUsage max_memory_usage, DiskUsage max_disk_usage, PopFunctor pop_functor,
+                    std::size_t shard_count, const boost::filesystem::path& disk_buffer,
+                    bool should_remove_root = false,
+                    DiskBackend disk_backend = DiskBackend::kFilePerValue,
+                    EvictionPolicy eviction_policy = EvictionPolicy::kFifo,
+                    std::size_t expected_key_count = 0);
+  ~ShardedDataBuffer();
+
+  // These behave as the corresponding DataBuffer functions, applied to the shard owning 'key'.
+  void Store(const KeyType& key, const NonEmptyString& value);
+  void Store(const KeyType& key, SharedValue value);
+  NonEmptyString Get(const KeyType& key);
+  SharedValue GetShared(const KeyType& key);
+  boost::optional<NonEmptyString> TryGet(const KeyType& key);
+  bool Has(const KeyType& key);
+  void Delete(const KeyType& key);
+  void StoreAsync(AsioService& asio_service, const KeyType& key, const NonEmptyString& value,
+                  StoreHandler handler);
+  std::future<void> StoreAsync(AsioService& asio_service, const KeyType& key,
+                               const NonEmptyString& value);
+  void GetAsync(AsioService& asio_service, const KeyType& key, GetHandler handler);
+  std::future<NonEmptyString> GetAsync(AsioService& asio_service, const KeyType& key);
+  void DeleteAsync(AsioService& asio_service, const KeyType& key, DeleteHandler handler);
+  std::future<void> DeleteAsync(AsioService& asio_service, const KeyType& key);
+  // Keys are grouped by owning shard and each group is passed to that shard's batch function.
+  // GetBatch returns values in the order of 'keys'.
+  void StoreBatch(const std::vector<std::pair<KeyType, NonEmptyString>>& key_values);
+  void StoreBatch(const std::vector<std::pair<KeyType, SharedValue>>& key_values);
+  std::vector<SharedValue> GetBatch(const std::vector<KeyType>& keys);
+  void DeleteBatch(const std::vector<KeyType>& keys);
+  // Applied to every shard.
+  void Delete(std::function<bool(const KeyType&)> predicate);
+  // The sum of every shard's statistics, with their latency histograms merged.  Each shard's figures
+  // are read in turn, so aren't a snapshot of the whole buffer at one instant.
+  Statistics Stats();
+  // Throws if max_memory_usage > max_disk_usage_.  The new limit is divided between the shards.
+  void SetMaxMemoryUsage(MemoryUsage max_memory_usage);
+  // Throws if max_memory_usage_ > max_disk_usage.  The new limit is divided between the shards.
+  void SetMaxDiskUsage(DiskUsage max_disk_usage);
+
+  std::size_t ShardCount() const { return kShardCount_; }
+
+ private:
+  template <typename ValueType>
+  void StoreBatchInShards(const std::vector<std::pair<KeyType, ValueType>>& key_values);
+  template <typename UsageType>
+  UsageType ShareOf(UsageType total, std::size_t shard_index) const;
+  std::size_t KeyCountShare(std::size_t expected_key_count) const;
+  std::size_t ShardIndex(const KeyType& key) const;
+  DataBuffer& Shard(const KeyType& key);
+
+  const DataBuffer::KeyHash kHash_;
+  const boost::filesystem::path kDiskBuffer_;
+  const bool kShouldRemoveRoot_;
+  const std::size_t kShardCount_;
+  std::vector<std::unique_ptr<DataBuffer>> shards_;
+  std::mutex limits_mutex_;
+  MemoryUsage max_memory_usage_;
+  DiskUsage max_disk_usage_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_SHARDED_DATA_BUFFER_H_
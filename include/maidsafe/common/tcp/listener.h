@@ -39,22 +39,35 @@ class Listener : public std::enable_shared_from_this<Listener> {
   Listener(Listener&&) = delete;
   Listener& operator=(Listener) = delete;
 
+  // Returns the strand to be used by a newly-accepted connection.
+  using ConnectionStrandFunctor = std::function<asio::io_service::strand&()>;
+
+  // Accepted connections use 'strand'.
   static ListenerPtr MakeShared(asio::io_service::strand& strand,
                                 NewConnectionFunctor on_new_connection, Port desired_port);
+  // Each accepted connection uses the strand returned by a call to 'connection_strand' (the calls
+  // are never concurrent).  This allows connections to be spread across several io_services, e.g.
+  // those of an AsioServicePool.
+  static ListenerPtr MakeShared(asio::io_service::strand& strand,
+                                NewConnectionFunctor on_new_connection, Port desired_port,
+                                ConnectionStrandFunctor connection_strand);
   Port ListeningPort() const;
   void StopListening();
 
  private:
-  Listener(asio::io_service::strand& strand, NewConnectionFunctor on_new_connection);
+  Listener(asio::io_service::strand& strand, NewConnectionFunctor on_new_connection,
+           ConnectionStrandFunctor connection_strand);
 
   void StartListening(Port desired_port);
   void DoStartListening(Port port);
   void HandleAccept(ConnectionPtr accepted_connection, const std::error_code& ec);
   void DoStopListening();
+  void AsyncAccept();
 
   asio::io_service::strand& strand_;
   std::once_flag stop_listening_flag_;
   NewConnectionFunctor on_new_connection_;
+  ConnectionStrandFunctor connection_strand_;
   asio::ip::tcp::acceptor acceptor_;
 };
 
@@ -0,0 +1,195 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  A work-stealing thread pool for CPU-bound tasks such as hashing, encryption and signature
+  checking.  Each worker thread has its own deque of tasks.  A task posted from a worker goes to
+  the back of that worker's deque, and a task posted from any other thread goes to the front of
+  the next worker's deque in turn.  A worker takes tasks from the back of its own deque (so it
+  runs the tasks it spawned most recently while their data is still in cache, and others' tasks in
+  the order they were posted), and when that is empty, steals from the front of the others'.
+
+  ParallelFor and ParallelMap split a range into a few chunks per worker.  The calling thread works
+  through chunks too, so they may safely be called from within a task.
+
+  The destructor runs all tasks already posted (including any they post in turn) and then joins
+  the worker threads.
+*/
+
+#ifndef MAIDSAFE_COMMON_THREAD_POOL_H_
+#define MAIDSAFE_COMMON_THREAD_POOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "boost/thread/tss.hpp"
+
+namespace maidsafe {
+
+namespace detail {
+
+// Shared by the caller of ThreadPool::ParallelFor and the helper tasks it posts.
+class ParallelForState {
+ public:
+  ParallelForState(std::size_t chunk_count, std::function<void(std::size_t)> run_chunk);
+  // Runs unclaimed chunks until there are none left.
+  void Work();
+  // Waits until every chunk has run, and rethrows the first exception thrown by any of them.
+  void Wait();
+
+ private:
+  const std::size_t chunk_count_;
+  const std::function<void(std::size_t)> run_chunk_;
+  std::atomic<std::size_t> next_chunk_;
+  std::size_t completed_;
+  std::exception_ptr exception_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+};
+
+// The element type ParallelMap computes results into.  std::vector<bool> packs elements into
+// shared words, which can't safely be written from several threads, so bools are computed as bytes.
+template <typename Result>
+struct ParallelMapStorage {
+  typedef Result type;
+  static std::vector<Result> ToResults(std::vector<Result>& outputs) { return std::move(outputs); }
+};
+
+template <>
+struct ParallelMapStorage<bool> {
+  typedef std::uint8_t type;
+  static std::vector<bool> ToResults(const std::vector<std::uint8_t>& outputs) {
+    return std::vector<bool>(outputs.begin(), outputs.end());
+  }
+};
+
+}  // namespace detail
+
+class ThreadPool {
+ public:
+  typedef std::function<void()> Task;
+
+  // A 'thread_count' of zero selects Concurrency().
+  explicit ThreadPool(unsigned int thread_count = 0);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool(ThreadPool&&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ThreadPool& operator=(ThreadPool&&) = delete;
+
+  // Exceptions thrown by 'task' are logged and otherwise ignored.
+  void Post(Task task);
+
+  // Exceptions thrown by 'functor' are passed to the returned future.
+  template <typename Functor>
+  std::future<typename std::result_of<Functor()>::type> Submit(Functor functor);
+
+  // Calls 'functor(i)' for each 'i' in ['begin', 'end') and returns once all calls are complete.
+  // If any call throws, an exception from one of them is rethrown after all have completed.
+  template <typename Index, typename Functor>
+  void ParallelFor(Index begin, Index end, Functor functor);
+
+  // Returns a vector holding 'functor(input)' for each of 'inputs', computed as per ParallelFor.
+  // The result type must be default-constructible.
+  template <typename Input, typename Functor>
+  std::vector<typename std::result_of<Functor(const Input&)>::type> ParallelMap(
+      const std::vector<Input>& inputs, Functor functor);
+
+  unsigned int ThreadCount() const { return static_cast<unsigned int>(workers_.size()); }
+
+ private:
+  struct Worker {
+    Worker() : mutex(), tasks(), thread() {}
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    std::thread thread;
+  };
+
+  void Run(std::size_t index);
+  bool TryPop(std::size_t index, Task& task);
+  // Returns the index of the worker running on this thread, or ThreadCount() if none.
+  std::size_t CurrentWorker() const;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<std::size_t> queued_, sleeping_, next_worker_;
+  bool stopping_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  // Set by each worker thread to its index, so that Post needn't search for the calling thread.
+  // Only worker threads set it, and they're joined before it's destroyed, so a later ThreadPool at
+  // the same address can't see a stale index.
+  boost::thread_specific_ptr<std::size_t> worker_index_;
+};
+
+template <typename Functor>
+std::future<typename std::result_of<Functor()>::type> ThreadPool::Submit(Functor functor) {
+  typedef typename std::result_of<Functor()>::type Result;
+  // std::function needs a copyable target, so the task is shared.
+  auto task(std::make_shared<std::packaged_task<Result()>>(std::move(functor)));
+  auto future(task->get_future());
+  Post([task] { (*task)(); });
+  return future;
+}
+
+template <typename Index, typename Functor>
+void ThreadPool::ParallelFor(Index begin, Index end, Functor functor) {
+  if (!(begin < end))
+    return;
+  const std::uint64_t count(static_cast<std::uint64_t>(end - begin));
+  const std::size_t chunk_count(
+      static_cast<std::size_t>(std::min<std::uint64_t>(count, 4 * ThreadCount())));
+  // Chunks are only run before Wait returns, so may refer to 'functor' on this stack.
+  auto state(std::make_shared<detail::ParallelForState>(
+      chunk_count, [begin, count, chunk_count, &functor](std::size_t chunk) {
+        const Index first(begin + static_cast<Index>(count * chunk / chunk_count));
+        const Index last(begin + static_cast<Index>(count * (chunk + 1) / chunk_count));
+        for (Index i(first); i != last; ++i)
+          functor(i);
+      }));
+  const std::size_t helper_count(std::min<std::size_t>(chunk_count - 1, ThreadCount()));
+  for (std::size_t i(0); i != helper_count; ++i)
+    Post([state] { state->Work(); });
+  state->Work();
+  state->Wait();
+}
+
+template <typename Input, typename Functor>
+std::vector<typename std::result_of<Functor(const Input&)>::type> ThreadPool::ParallelMap(
+    const std::vector<Input>& inputs, Functor functor) {
+  typedef detail::ParallelMapStorage<typename std::result_of<Functor(const Input&)>::type> Storage;
+  std::vector<typename Storage::type> outputs(inputs.size());
+  ParallelFor(std::size_t(0), inputs.size(),
+              [&](std::size_t i) { outputs[i] = functor(inputs[i]); });
+  return Storage::ToResults(outputs);
+}
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_THREAD_POOL_H_
@@ -20,50 +20,80 @@
 
 namespace maidsafe {
 
-Active::Active()
-    : running_(true),
-      functors_(),
-      flags_mutex_(),
+Active::Active(std::shared_ptr<ExecutorStats> stats)
+    : stats_(std::move(stats)),
+      running_(true),
+      waiting_(false),
+      tail_(new Node),
+      head_(tail_.load()),
       mutex_(),
       condition_(),
       thread_([this] { Run(); }) {}
 
 Active::~Active() {
-  Send([this] {
-    std::lock_guard<std::mutex> flags_lock(flags_mutex_);
-    running_ = false;
-  });
+  Send([this] { running_ = false; });
   thread_.join();
+  // Discard any functors sent after the one above.
+  while (head_) {
+    Node* const next(head_->next.load());
+    delete head_;
+    head_ = next;
+  }
 }
 
 void Active::Send(Functor functor) {
-  std::lock_guard<std::mutex> flags_lock(flags_mutex_);
-  if (!running_)
+  if (!running_.load(std::memory_order_relaxed))
     return;
-  {
+  Node* const node(new Node(std::move(functor)));
+  if (stats_)
+    node->queued_time = stats_->Queued();
+  Node* const previous(tail_.exchange(node));
+  previous->next.store(node, std::memory_order_release);
+  // Only the first producer to find the consumer asleep pays for waking it.
+  if (waiting_.exchange(false)) {
     std::lock_guard<std::mutex> lock(mutex_);
-    functors_.push(std::move(functor));
+    condition_.notify_one();
   }
-  condition_.notify_one();
 }
 
 void Active::Run() {
-  auto running = [this]() -> bool {
-    std::lock_guard<std::mutex> flags_lock(flags_mutex_);
-    return running_;
-  };
-
-  while (running()) {
+  while (running_) {
     Functor functor;
-    {
-      std::unique_lock<std::mutex> lock(mutex_);
-      while (functors_.empty())
-        condition_.wait(lock);
-      functor = std::move(functors_.front());
-      functors_.pop();
+    ExecutorStats::Clock::time_point queued_time;
+    if (!Pop(functor, queued_time)) {
+      Wait();
+    } else if (stats_) {
+      const detail::ExecutorRunScope run_scope(*stats_, queued_time);
+      functor();
+    } else {
+      functor();
     }
-    functor();
   }
 }
 
+bool Active::Pop(Functor& functor, ExecutorStats::Clock::time_point& queued_time) {
+  Node* const next(head_->next.load(std::memory_order_acquire));
+  if (!next)
+    return false;
+  functor = std::move(next->functor);
+  queued_time = next->queued_time;
+  delete head_;
+  head_ = next;
+  return true;
+}
+
+void Active::Wait() {
+  waiting_ = true;
+  // This check and the exchange of 'waiting_' in Send are both sequentially consistent, so either
+  // we see the new node here, or Send sees that we're waiting and wakes us.
+  if (tail_.load() != head_) {
+    // A node has been pushed, but may not be linked yet.
+    waiting_ = false;
+    std::this_thread::yield();
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  condition_.wait(lock, [this] { return !waiting_; });
+}
+
 }  // namespace maidsafe
@@ -0,0 +1,393 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/binary_log.h"
+
+#include <algorithm>
+
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace log {
+
+namespace detail {
+
+namespace {
+
+const std::size_t kMinimumRingCapacity(1024);
+
+std::atomic<std::uint64_t> g_next_instance(1);
+
+std::size_t RingCapacity(std::size_t requested) {
+  std::size_t capacity(kMinimumRingCapacity);
+  while (capacity < requested)
+    capacity <<= 1;
+  return capacity;
+}
+
+// Records start on 8-byte boundaries, so that a skip marker always fits before the end of a ring.
+std::uint64_t Padded(std::uint64_t size) { return (size + 7) & ~std::uint64_t(7); }
+
+template <typename T>
+T Read(const char*& data) {
+  T value;
+  std::memcpy(&value, data, sizeof(value));
+  data += sizeof(value);
+  return value;
+}
+
+}  // unnamed namespace
+
+void DecodeArguments(const char* data, std::size_t size, std::ostream& out) {
+  const char* const end(data + size);
+  while (data < end) {
+    switch (static_cast<ArgumentType>(*data++)) {
+      case ArgumentType::kBool:
+        out << Read<bool>(data);
+        break;
+      case ArgumentType::kChar:
+        out << Read<char>(data);
+        break;
+      case ArgumentType::kInt16:
+        out << Read<std::int16_t>(data);
+        break;
+      case ArgumentType::kUint16:
+        out << Read<std::uint16_t>(data);
+        break;
+      case ArgumentType::kInt32:
+        out << Read<std::int32_t>(data);
+        break;
+      case ArgumentType::kUint32:
+        out << Read<std::uint32_t>(data);
+        break;
+      case ArgumentType::kInt64:
+        out << Read<std::int64_t>(data);
+        break;
+      case ArgumentType::kUint64:
+        out << Read<std::uint64_t>(data);
+        break;
+      case ArgumentType::kDouble:
+        out << Read<double>(data);
+        break;
+      case ArgumentType::kString: {
+        const std::uint32_t length(Read<std::uint32_t>(data));
+        out.write(data, length);
+        data += length;
+        break;
+      }
+      case ArgumentType::kManipulator:
+        out << Read<Manipulator>(data);
+        break;
+      default:
+        return;
+    }
+  }
+}
+
+// ======================================== BinaryLog::Ring ========================================
+struct BinaryLog::RecordHeader {
+  // Of the header and payload, excluding padding.  Zero marks the rest of the ring as unused.
+  std::uint32_t size;
+  std::int32_t level;
+  CallSiteFile* call_site_file;
+  const char* file;
+  std::chrono::system_clock::rep time;
+  // If set, the payload is a pointer to a heap-allocated std::vector<char> holding the values.
+  bool out_of_line;
+};
+
+// Single-producer, single-consumer.  Positions only ever increase; the offset into 'buffer_' is a
+// position modulo the capacity.  A record never wraps around the end of the buffer: if it won't
+// fit before the end, a skip marker is written there and the record goes at the start.
+//
+// Publishing a record, removing one and checking for emptiness are sequentially consistent, so
+// that a reader which finds every ring empty and then sleeps can't miss the writer's wakeup (see
+// BinaryLog::Run).
+class BinaryLog::Ring {
+ public:
+  Ring(std::size_t capacity, std::thread::id thread_id)
+      : kThreadId_(thread_id),
+        closed_(false),
+        buffer_(capacity),
+        kMask_(capacity - 1),
+        write_position_(0),
+        read_position_(0) {}
+
+  // Returns false if there isn't room.  Otherwise sets 'was_emptied' if, once the record was
+  // published, the reader had read every earlier record.
+  bool TryWrite(const RecordHeader& header, const std::vector<char>& payload, bool& was_emptied) {
+    const std::uint64_t write_position(write_position_.load(std::memory_order_relaxed));
+    const std::uint64_t read_position(read_position_.load(std::memory_order_acquire));
+    const std::uint64_t size(Padded(header.size));
+    std::uint64_t offset(write_position & kMask_);
+    const std::uint64_t space_before_end(buffer_.size() - offset);
+    const std::uint64_t skipped(space_before_end < size ? space_before_end : 0);
+    if (buffer_.size() - (write_position - read_position) < skipped + size)
+      return false;
+    if (skipped != 0) {
+      const std::uint32_t skip_marker(0);
+      std::memcpy(&buffer_[offset], &skip_marker, sizeof(skip_marker));
+      offset = 0;
+    }
+    std::memcpy(&buffer_[offset], &header, sizeof(header));
+    if (!payload.empty())
+      std::memcpy(&buffer_[offset + sizeof(header)], payload.data(), payload.size());
+    write_position_.store(write_position + skipped + size);
+    was_emptied = read_position_.load() == write_position;
+    return true;
+  }
+
+  // Calls 'functor(header, payload, payload_size)' for the oldest record, if any, before removing
+  // it.  Returns false if there are no records.
+  template <typename Functor>
+  bool Read(Functor functor) {
+    std::uint64_t read_position(read_position_.load(std::memory_order_relaxed));
+    if (read_position == write_position_.load(std::memory_order_acquire))
+      return false;
+    std::uint64_t offset(read_position & kMask_);
+    std::uint32_t size(0);
+    std::memcpy(&size, &buffer_[offset], sizeof(size));
+    if (size == 0) {
+      read_position += buffer_.size() - offset;
+      offset = 0;
+    }
+    RecordHeader header;
+    std::memcpy(&header, &buffer_[offset], sizeof(header));
+    functor(header, &buffer_[offset + sizeof(header)], header.size - sizeof(header));
+    read_position_.store(read_position + Padded(header.size));
+    return true;
+  }
+
+  bool Empty() const { return read_position_.load() == write_position_.load(); }
+
+  const std::thread::id kThreadId_;
+  std::atomic<bool> closed_;
+
+ private:
+  std::vector<char> buffer_;
+  const std::uint64_t kMask_;
+  std::atomic<std::uint64_t> write_position_, read_position_;
+};
+
+// ====================================== BinaryLog::Producer ======================================
+BinaryLog::Producer::Producer(std::uint64_t instance_in, std::shared_ptr<Ring> ring_in)
+    : instance(instance_in), ring(std::move(ring_in)), payload() {}
+
+BinaryLog::Producer::~Producer() { ring->closed_.store(true, std::memory_order_release); }
+
+// =========================================== BinaryLog ===========================================
+BinaryLog::BinaryLog(Output output, std::size_t ring_capacity, OverflowPolicy overflow_policy)
+    : kOutput_(std::move(output)),
+      kRingCapacity_(RingCapacity(ring_capacity)),
+      kOverflowPolicy_(overflow_policy),
+      kInstance_(g_next_instance++),
+      producer_(),
+      dropped_(0),
+      idle_(false),
+      rings_(),
+      rings_changed_(false),
+      stopping_(false),
+      flush_requests_(0),
+      flushes_completed_(0),
+      mutex_(),
+      condition_(),
+      flushed_condition_(),
+      thread_() {
+  thread_ = std::thread([this] { Run(); });
+}
+
+BinaryLog::~BinaryLog() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  condition_.notify_one();
+  thread_.join();
+}
+
+BinaryLog::Producer& BinaryLog::GetProducer() {
+  Producer* producer(producer_.get());
+  if (producer && producer->instance == kInstance_)
+    return *producer;
+  auto ring(std::make_shared<Ring>(kRingCapacity_, std::this_thread::get_id()));
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rings_.push_back(ring);
+    rings_changed_ = true;
+  }
+  producer_.reset(new Producer(kInstance_, std::move(ring)));
+  return *producer_;
+}
+
+void BinaryLog::WriteRecord(Producer& producer, int level, CallSiteFile& call_site_file,
+                            const char* file) {
+  RecordHeader header;
+  std::unique_ptr<std::vector<char>> out_of_line_payload;
+  if (sizeof(header) + producer.payload.size() > kRingCapacity_ / 4) {
+    // Too large to share the ring, so keep the record's place in order by writing a pointer.
+    out_of_line_payload.reset(new std::vector<char>(producer.payload));
+    const std::vector<char>* const pointer(out_of_line_payload.get());
+    producer.payload.resize(sizeof(pointer));
+    std::memcpy(producer.payload.data(), &pointer, sizeof(pointer));
+  }
+  header.size = static_cast<std::uint32_t>(sizeof(header) + producer.payload.size());
+  header.level = level;
+  header.call_site_file = &call_site_file;
+  header.file = file;
+  header.time = std::chrono::system_clock::now().time_since_epoch().count();
+  header.out_of_line = static_cast<bool>(out_of_line_payload);
+  bool was_emptied(false);
+  bool written(producer.ring->TryWrite(header, producer.payload, was_emptied));
+  // The background thread can't make room while it's waiting here.
+  if (!written && kOverflowPolicy_ == OverflowPolicy::kBlock &&
+      std::this_thread::get_id() != thread_.get_id()) {
+    do {
+      std::this_thread::yield();
+    } while (!producer.ring->TryWrite(header, producer.payload, was_emptied));
+    written = true;
+  }
+  if (!written) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  // Now owned by the ring.
+  out_of_line_payload.release();
+  if (was_emptied && idle_.load())
+    Wake();
+}
+
+void BinaryLog::Wake() {
+  { std::lock_guard<std::mutex> lock(mutex_); }
+  condition_.notify_one();
+}
+
+void BinaryLog::Flush() {
+  if (std::this_thread::get_id() == thread_.get_id())
+    return;
+  std::unique_lock<std::mutex> lock(mutex_);
+  const std::uint64_t flush_request(++flush_requests_);
+  condition_.notify_one();
+  flushed_condition_.wait(lock, [&] { return flushes_completed_ >= flush_request; });
+}
+
+void BinaryLog::Run() {
+  std::vector<std::shared_ptr<Ring>> rings;
+  std::uint64_t dropped_reported(0);
+  bool closed_ring_drained(false);
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    if (closed_ring_drained) {
+      rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                  [](const std::shared_ptr<Ring>& ring) {
+                                    return ring->closed_.load(std::memory_order_acquire) &&
+                                           ring->Empty();
+                                  }),
+                   rings_.end());
+      rings_changed_ = true;
+    }
+    if (rings_changed_) {
+      rings = rings_;
+      rings_changed_ = false;
+    }
+    // A pass which starts after a flush request and finds every ring empty completes it.
+    const std::uint64_t flush_request(flush_requests_);
+    const bool stopping(stopping_);
+    lock.unlock();
+    closed_ring_drained = false;
+    const bool drained_any(Drain(rings, closed_ring_drained));
+    ReportDropped(dropped_reported);
+    lock.lock();
+    if (drained_any)
+      continue;
+    if (flushes_completed_ != flush_request) {
+      flushes_completed_ = flush_request;
+      flushed_condition_.notify_all();
+    }
+    if (stopping)
+      return;
+    // A writer which finds 'idle_' unset after publishing a record into an emptied ring relies on
+    // the record being seen here, and one which finds it set takes the lock before notifying, so
+    // can't do so between this check and the wait.
+    idle_.store(true);
+    if (!rings_changed_ && !stopping_ && flush_requests_ == flush_request && AllEmpty(rings))
+      condition_.wait(lock);
+    idle_.store(false);
+  }
+}
+
+bool BinaryLog::AllEmpty(const std::vector<std::shared_ptr<Ring>>& rings) const {
+  return std::all_of(rings.begin(), rings.end(),
+                     [](const std::shared_ptr<Ring>& ring) { return ring->Empty(); });
+}
+
+bool BinaryLog::Drain(const std::vector<std::shared_ptr<Ring>>& rings,
+                      bool& closed_ring_drained) {
+  bool drained_any(false);
+  BinaryLogEntry entry;
+  for (const auto& ring : rings) {
+    // Read this first, so that the ring is known to be finished with if then found to be empty.
+    const bool closed(ring->closed_.load(std::memory_order_acquire));
+    entry.thread_id = ring->kThreadId_;
+    while (ring->Read([&](const RecordHeader& header, const char* payload, std::size_t size) {
+      std::unique_ptr<const std::vector<char>> out_of_line_payload;
+      if (header.out_of_line) {
+        out_of_line_payload.reset(Read<const std::vector<char>*>(payload));
+        payload = out_of_line_payload->data();
+        size = out_of_line_payload->size();
+      }
+      const CallSiteFile::Info& file_info(header.call_site_file->Get(header.file));
+      std::ostringstream message;
+      message << " " << file_info.contract_file;
+      DecodeArguments(payload, size, message);
+      message << "\n";
+      entry.level = header.level;
+      entry.time = std::chrono::system_clock::time_point(
+          std::chrono::system_clock::duration(header.time));
+      entry.project = file_info.project;
+      entry.message = message.str();
+      kOutput_(entry);
+    })) {
+      drained_any = true;
+    }
+    if (closed)
+      closed_ring_drained = true;
+  }
+  return drained_any;
+}
+
+void BinaryLog::ReportDropped(std::uint64_t& reported) const {
+  const std::uint64_t dropped(dropped_.load(std::memory_order_relaxed));
+  if (dropped == reported)
+    return;
+  BinaryLogEntry entry;
+  entry.level = kWarning;
+  entry.thread_id = std::this_thread::get_id();
+  entry.time = std::chrono::system_clock::now();
+  entry.project = "common";
+  entry.message = " Dropped " + std::to_string(dropped - reported) +
+                  " log messages since a logging thread's buffer was full.\n";
+  reported = dropped;
+  kOutput_(entry);
+}
+
+}  // namespace detail
+
+}  // namespace log
+
+}  // namespace maidsafe
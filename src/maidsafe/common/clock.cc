@@ -18,6 +18,10 @@
 
 #include "maidsafe/common/clock.h"
 
+#ifdef __linux__
+#include <time.h>
+#endif
+
 namespace maidsafe {
 
 Clock::time_point Clock::now() MAIDSAFE_NOEXCEPT {
@@ -35,4 +39,16 @@ std::time_t Clock::to_time_t(const time_point& t) {
 
 Clock::time_point Clock::from_time_t(std::time_t t) { return time_point(std::chrono::seconds(t)); }
 
+CoarseSteadyClock::time_point CoarseSteadyClock::now() MAIDSAFE_NOEXCEPT {
+#ifdef __linux__
+  // std::chrono::steady_clock uses CLOCK_MONOTONIC, which has the same epoch.
+  timespec now;
+  if (clock_gettime(CLOCK_MONOTONIC_COARSE, &now) == 0) {
+    return time_point(std::chrono::duration_cast<duration>(std::chrono::seconds(now.tv_sec) +
+                                                           std::chrono::nanoseconds(now.tv_nsec)));
+  }
+#endif
+  return std::chrono::steady_clock::now();
+}
+
 }  // namespace maidsafe
@@ -0,0 +1,280 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/containers/concurrent_lru_cache.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/containers/cache_expiry_timer.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(ConcurrentLruCacheTest, BEH_AddGetDelete) {
+  const size_t size(100);
+  ConcurrentLruCache<int, int> cache(size, 8);
+  EXPECT_EQ(8U, cache.shard_count());
+
+  for (int i(0); i < 1000; ++i) {
+    cache.Add(i, i);
+    EXPECT_GE(size, cache.size());
+  }
+  // Each shard holds its share of the capacity, so the cache is full.
+  EXPECT_EQ(size, cache.size());
+  // The most recently added entries are still held, as every shard has evicted its oldest ones.
+  for (int i(990); i < 1000; ++i) {
+    ASSERT_TRUE(cache.Check(i));
+    EXPECT_EQ(i, cache.Get(i).value());
+  }
+
+  for (int i(990); i < 1000; ++i) {
+    cache.Delete(i);
+    EXPECT_FALSE(cache.Check(i));
+    EXPECT_FALSE(cache.Get(i).valid());
+  }
+  EXPECT_EQ(size - 10, cache.size());
+}
+
+TEST(ConcurrentLruCacheTest, BEH_NonCopyingAccess) {
+  ConcurrentLruCache<int, std::shared_ptr<const std::string>> cache(10, 2);
+  cache.Add(0, std::make_shared<const std::string>(1000, 'a'));
+
+  std::size_t visited(0);
+  EXPECT_TRUE(cache.Visit(0, [&](const std::shared_ptr<const std::string>& value) {
+    visited = value->size();
+  }));
+  EXPECT_EQ(1000U, visited);
+  EXPECT_FALSE(cache.Visit(1, [&](const std::shared_ptr<const std::string>&) { visited = 0; }));
+  EXPECT_EQ(1000U, visited);
+
+  // The value outlives its removal from the cache.
+  std::shared_ptr<const std::string> value;
+  EXPECT_FALSE(cache.TryGet(1, value));
+  EXPECT_FALSE(value);
+  EXPECT_TRUE(cache.TryGet(0, value));
+  cache.Delete(0);
+  ASSERT_TRUE(value);
+  EXPECT_EQ(std::string(1000, 'a'), *value);
+}
+
+TEST(ConcurrentLruCacheTest, BEH_ShardCount) {
+  // Never more shards than entries.
+  ConcurrentLruCache<int, int> small_cache(3, 16);
+  EXPECT_EQ(3U, small_cache.shard_count());
+  ConcurrentLruCache<int, int> default_cache(std::chrono::seconds(1));
+  EXPECT_LE(8U, default_cache.shard_count());
+}
+
+TEST(ConcurrentLruCacheTest, BEH_Weighted) {
+  const std::uint64_t max_weight(4000);
+  ConcurrentLruCache<int, std::string> cache(
+      MemoryUsage(max_weight),
+      [](const int&, const std::string& value) { return static_cast<std::uint64_t>(value.size()); },
+      4);
+  for (int i(0); i < 1000; ++i) {
+    cache.Add(i, std::string(1 + i % 200, 'a'));
+    EXPECT_GE(max_weight, cache.weight().data);
+  }
+  // Each shard only evicts what it needs to, so the cache stays nearly full.
+  EXPECT_LT(max_weight - 4 * 200, cache.weight().data);
+  // Too heavy for any shard's share.
+  cache.Add(1000, std::string(max_weight / 4 + 1, 'b'));
+  EXPECT_FALSE(cache.Check(1000));
+}
+
+TEST(ConcurrentLruCacheTest, BEH_WeightedShardCount) {
+  const std::uint64_t max_weight(8 * 1024 * 1024);
+  auto weigher([](const int&, const std::string& value) {
+    return static_cast<std::uint64_t>(value.size());
+  });
+  // By default, an entry of up to half the maximum weight can be cached.
+  ConcurrentLruCache<int, std::string> default_cache(MemoryUsage(max_weight), weigher);
+  default_cache.Add(0, std::string(max_weight / 2, 'a'));
+  EXPECT_TRUE(default_cache.Check(0));
+  EXPECT_EQ(max_weight / 2, default_cache.weight().data);
+
+  // A maximum entry weight hint allows more shards, each still able to hold such an entry.
+  const std::uint64_t max_entry_weight(64 * 1024);
+  ConcurrentLruCache<int, std::string> hinted_cache(MemoryUsage(max_weight),
+                                                    MemoryUsage(max_entry_weight), weigher);
+  EXPECT_LE(hinted_cache.shard_count(), max_weight / max_entry_weight);
+  for (int i(0); i < 64; ++i) {
+    hinted_cache.Add(i, std::string(max_entry_weight, 'b'));
+    EXPECT_TRUE(hinted_cache.Check(i));
+  }
+}
+
+TEST(ConcurrentLruCacheTest, BEH_FilterSize) {
+  const size_t size(10);
+  ConcurrentLruCache<int, void> filter(size, 2);
+  for (int i(0); i < 1000; ++i) {
+    filter.Add(i);
+    EXPECT_GE(size, filter.size());
+  }
+  EXPECT_EQ(size, filter.size());
+  EXPECT_TRUE(filter.Check(999));
+}
+
+TEST(ConcurrentLruCacheTest, BEH_KeysWithoutStdHash) {
+  // Keys which std::hash doesn't support can't be assigned to shards, so share a single one.
+  const size_t size(10);
+  ConcurrentLruCache<std::pair<int, int>, void> filter(size, 4);
+  EXPECT_EQ(1U, filter.shard_count());
+  for (int i(0); i < 20; ++i)
+    filter.Add(std::make_pair(i, -i));
+  EXPECT_EQ(size, filter.size());
+  for (int i(0); i < 20; ++i)
+    EXPECT_EQ(i >= 10, filter.Check(std::make_pair(i, -i)));
+}
+
+TEST(ConcurrentLruCacheTest, BEH_FilterTime) {
+  std::chrono::milliseconds time(100);
+  ConcurrentLruCache<int, void> filter(time, 2);
+  for (int i(0); i < 10; ++i)
+    filter.Add(i);
+  EXPECT_EQ(10U, filter.size());
+  std::this_thread::sleep_for(time);
+  // Expired entries are trimmed from a shard when it is next added to; these keys cover both.
+  for (int i(10); i < 20; ++i)
+    filter.Add(i);
+  EXPECT_EQ(10U, filter.size());
+  for (int i(0); i < 10; ++i)
+    EXPECT_FALSE(filter.Check(i));
+}
+
+TEST(ConcurrentLruCacheTest, BEH_ExpiryTimer) {
+  std::chrono::milliseconds time(100);
+  ConcurrentLruCache<int, int> cache(100, time, 4);
+  AsioService asio_service(1);
+  {
+    CacheExpiryTimer<ConcurrentLruCache<int, int>> timer(asio_service, cache,
+                                                         std::chrono::milliseconds(20));
+    for (int i(0); i < 50; ++i)
+      cache.Add(i, i);
+    EXPECT_EQ(50U, cache.size());
+    // Nothing else touches the cache, so only the timer can remove the expired entries.
+    const auto deadline(std::chrono::steady_clock::now() + 10 * time);
+    while (cache.size() != 0 && std::chrono::steady_clock::now() < deadline)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(0U, cache.size());
+  }
+  // Once the timer is destroyed, entries are left until the cache is next used.
+  cache.Add(0, 0);
+  std::this_thread::sleep_for(2 * time);
+  EXPECT_EQ(1U, cache.size());
+}
+
+TEST(ConcurrentLruCacheTest, BEH_Concurrency) {
+  const size_t size(1000);
+  const int thread_count(8), key_range(4000);
+  ConcurrentLruCache<int, int> cache(size);
+  std::vector<std::thread> threads;
+  for (int t(0); t < thread_count; ++t) {
+    threads.emplace_back([&cache] {
+      for (int i(0); i < 10000; ++i) {
+        const int key(static_cast<int>(RandomUint32() % key_range));
+        switch (RandomUint32() % 3) {
+          case 0:
+            cache.Add(key, key * 3);
+            break;
+          case 1: {
+            auto value(cache.Get(key));
+            if (value.valid()) {
+              ASSERT_EQ(key * 3, value.value());
+            }
+            break;
+          }
+          default:
+            cache.Delete(key);
+            break;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  EXPECT_GE(size, cache.size());
+}
+
+namespace {
+
+// Runs 'operation' from 'thread_count' threads until each has done 'iterations' operations and
+// returns the overall operations per microsecond.
+template <typename Operation>
+double Throughput(int thread_count, int iterations, Operation operation) {
+  std::vector<std::thread> threads;
+  const auto start(std::chrono::steady_clock::now());
+  for (int t(0); t < thread_count; ++t) {
+    threads.emplace_back([&, t] {
+      std::uint64_t key(static_cast<std::uint64_t>(t) * 2654435761U);
+      for (int i(0); i < iterations; ++i) {
+        key = key * 6364136223846793005ULL + 1442695040888963407ULL;
+        operation(key >> 48);
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  const auto elapsed(std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start));
+  return static_cast<double>(thread_count) * iterations /
+         std::max<std::chrono::microseconds::rep>(elapsed.count(), 1);
+}
+
+}  // unnamed namespace
+
+TEST(ConcurrentLruCacheTest, FUNC_Contention) {
+  // Keys are drawn from 2^16 values, so roughly half of the lookups hit.
+  const size_t size(1 << 15);
+  const int iterations(200000);
+  for (int thread_count(1); thread_count <= 64; thread_count *= 2) {
+    LruCache<std::uint64_t, std::uint64_t> locked_cache(size);
+    std::mutex mutex;
+    const double locked(Throughput(thread_count, iterations / thread_count,
+                                   [&](std::uint64_t key) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!locked_cache.Get(key).valid())
+        locked_cache.Add(key, key);
+    }));
+
+    ConcurrentLruCache<std::uint64_t, std::uint64_t> sharded_cache(size);
+    const double sharded(Throughput(thread_count, iterations / thread_count,
+                                    [&](std::uint64_t key) {
+      if (!sharded_cache.Get(key).valid())
+        sharded_cache.Add(key, key);
+    }));
+
+    TLOG(kGreen) << thread_count << " threads: single mutex " << locked << " ops/us, "
+                 << sharded_cache.shard_count() << " shards " << sharded << " ops/us\n";
+  }
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,115 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/containers/counting_bloom_filter.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(CountingBloomFilterTest, BEH_AddRemove) {
+  CountingBloomFilter<std::string> filter(1000);
+  std::vector<std::string> keys;
+  for (int i(0); i != 1000; ++i)
+    keys.push_back(RandomString(20));
+  EXPECT_FALSE(filter.MightContain(keys[0]));
+  for (const auto& key : keys) {
+    filter.Add(key);
+    EXPECT_TRUE(filter.MightContain(key));
+  }
+  // A key added twice remains until it has been removed twice.
+  filter.Add(keys[0]);
+  filter.Remove(keys[0]);
+  EXPECT_TRUE(filter.MightContain(keys[0]));
+
+  for (std::size_t i(1); i != keys.size(); ++i)
+    filter.Remove(keys[i]);
+  for (std::size_t i(1); i != keys.size(); ++i)
+    EXPECT_FALSE(filter.MightContain(keys[i]));
+  EXPECT_TRUE(filter.MightContain(keys[0]));
+  filter.Remove(keys[0]);
+  EXPECT_FALSE(filter.MightContain(keys[0]));
+}
+
+TEST(CountingBloomFilterTest, BEH_FalsePositiveRate) {
+  CountingBloomFilter<std::string> filter(10000);
+  for (int i(0); i != 10000; ++i)
+    filter.Add(RandomString(20));
+  int false_positives(0);
+  for (int i(0); i != 10000; ++i) {
+    if (filter.MightContain(RandomString(20)))
+      ++false_positives;
+  }
+  EXPECT_GT(500, false_positives);
+}
+
+TEST(CountingBloomFilterTest, BEH_Saturation) {
+  // With only 64 counters, holding many keys saturates counters, which must never cause a false
+  // negative.
+  CountingBloomFilter<std::string> filter(8);
+  std::vector<std::string> keys;
+  for (int i(0); i != 2000; ++i) {
+    keys.push_back(RandomString(20));
+    filter.Add(keys.back());
+  }
+  for (std::size_t i(0); i < keys.size(); i += 2)
+    filter.Remove(keys[i]);
+  for (std::size_t i(1); i < keys.size(); i += 2)
+    EXPECT_TRUE(filter.MightContain(keys[i]));
+}
+
+TEST(CountingBloomFilterTest, BEH_Concurrency) {
+  CountingBloomFilter<std::string> filter(4000);
+  std::vector<std::vector<std::string>> keys(4);
+  for (auto& thread_keys : keys) {
+    for (int i(0); i != 1000; ++i)
+      thread_keys.push_back(RandomString(20));
+  }
+  std::vector<std::thread> threads;
+  for (auto& thread_keys : keys) {
+    threads.emplace_back([&] {
+      for (int round(0); round != 10; ++round) {
+        for (const auto& key : thread_keys)
+          filter.Add(key);
+        for (const auto& key : thread_keys)
+          ASSERT_TRUE(filter.MightContain(key));
+        for (const auto& key : thread_keys)
+          filter.Remove(key);
+      }
+      for (const auto& key : thread_keys)
+        filter.Add(key);
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  for (const auto& thread_keys : keys) {
+    for (const auto& key : thread_keys)
+      EXPECT_TRUE(filter.MightContain(key));
+  }
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
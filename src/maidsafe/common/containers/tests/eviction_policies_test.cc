@@ -0,0 +1,164 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/containers/eviction_policies.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/containers/lru_cache.h"
+
+namespace maidsafe {
+
+namespace test {
+
+template <typename Policy>
+class EvictionPolicyTest : public testing::Test {
+ protected:
+  template <typename ValueType>
+  using Cache = LruCache<int, ValueType, std::hash<int>, std::equal_to<int>, Policy>;
+};
+
+using Policies = testing::Types<LruPolicy, TwoQueuePolicy, ArcPolicy, TinyLfuPolicy>;
+TYPED_TEST_CASE(EvictionPolicyTest, Policies);
+
+TYPED_TEST(EvictionPolicyTest, BEH_Capacity) {
+  const int size(50);
+  typename TestFixture::template Cache<int> cache(size);
+  for (int i(0); i < 1000; ++i) {
+    cache.Add(i, i);
+    EXPECT_GE(static_cast<std::size_t>(size), cache.size());
+    // The entry just added is never the one evicted to make room for it.
+    ASSERT_TRUE(cache.Get(i).valid());
+    EXPECT_EQ(i, cache.Get(i).value());
+  }
+  EXPECT_EQ(static_cast<std::size_t>(size), cache.size());
+
+  typename TestFixture::template Cache<void> filter(size);
+  for (int i(0); i < 1000; ++i)
+    filter.Add(i);
+  EXPECT_EQ(static_cast<std::size_t>(size), filter.size());
+}
+
+TYPED_TEST(EvictionPolicyTest, BEH_Churn) {
+  // Random adds, gets and deletes, checked against a model of the held entries.
+  const int size(64);
+  typename TestFixture::template Cache<int> cache(size);
+  std::map<int, int> held;
+  for (int i(0); i < 20000; ++i) {
+    const int key(static_cast<int>(RandomUint32() % 256));
+    switch (RandomUint32() % 4) {
+      case 0:
+        cache.Delete(key);
+        held.erase(key);
+        break;
+      case 1: {
+        auto value(cache.Get(key));
+        if (value.valid()) {
+          ASSERT_EQ(key + 1, value.value());
+        }
+        break;
+      }
+      default:
+        cache.Add(key, key + 1);
+        held[key] = key + 1;
+        break;
+    }
+    ASSERT_GE(static_cast<std::size_t>(size), cache.size());
+  }
+  std::size_t count(0);
+  for (int key(0); key < 256; ++key) {
+    if (cache.Check(key)) {
+      ++count;
+      EXPECT_EQ(1U, held.count(key));
+    }
+  }
+  EXPECT_EQ(count, cache.size());
+}
+
+TYPED_TEST(EvictionPolicyTest, BEH_Weighted) {
+  typename TestFixture::template Cache<std::string> cache(MemoryUsage(1000),
+                                                         [](const int&, const std::string& value) {
+    return static_cast<std::uint64_t>(value.size());
+  });
+  for (int i(0); i < 1000; ++i) {
+    cache.Add(i, std::string(1 + RandomUint32() % 100, 'a'));
+    ASSERT_GE(1000U, cache.weight().data);
+  }
+  EXPECT_LT(900U, cache.weight().data);
+}
+
+TYPED_TEST(EvictionPolicyTest, BEH_TimeToLive) {
+  std::chrono::milliseconds time(100);
+  typename TestFixture::template Cache<int> cache(10, time);
+  for (int i(0); i < 10; ++i)
+    cache.Add(i, i);
+  std::this_thread::sleep_for(time);
+  cache.Add(10, 10);
+  EXPECT_EQ(1U, cache.size());
+  EXPECT_TRUE(cache.Check(10));
+}
+
+namespace {
+
+// Alternately reads a hot set of keys and a batch of once-used keys, then scans a large number of
+// once-used keys, and returns the number of hot keys still cached after the scan.
+template <typename Policy>
+int HotKeysSurvivingScan() {
+  const int size(100), hot_count(50);
+  LruCache<int, int, std::hash<int>, std::equal_to<int>, Policy> cache(size);
+  const auto read([&cache](int key) {
+    if (!cache.Get(key).valid())
+      cache.Add(key, key);
+  });
+  int cold_key(1000);
+  for (int round(0); round < 20; ++round) {
+    for (int key(0); key < hot_count; ++key)
+      read(key);
+    for (int i(0); i < 20; ++i)
+      read(cold_key++);
+  }
+  // Every hot key is still cached, even with the LRU policy.
+  for (int key(0); key < hot_count; ++key)
+    EXPECT_TRUE(cache.Check(key));
+  for (int i(0); i < 10 * size; ++i)
+    read(cold_key++);
+  int survivors(0);
+  for (int key(0); key < hot_count; ++key)
+    survivors += cache.Check(key) ? 1 : 0;
+  return survivors;
+}
+
+}  // unnamed namespace
+
+TEST(EvictionPolicyTest, BEH_ScanResistance) {
+  EXPECT_EQ(0, HotKeysSurvivingScan<LruPolicy>());
+  EXPECT_LE(40, HotKeysSurvivingScan<TwoQueuePolicy>());
+  EXPECT_LE(40, HotKeysSurvivingScan<ArcPolicy>());
+  EXPECT_LE(40, HotKeysSurvivingScan<TinyLfuPolicy>());
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,76 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/containers/frequency_sketch.h"
+
+#include <cstdint>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(FrequencySketchTest, BEH_IncrementAndEstimate) {
+  FrequencySketch sketch(1000);
+  const std::uint64_t hash(RandomUint32());
+  EXPECT_EQ(0U, sketch.Estimate(hash));
+  for (unsigned i(1); i != 16; ++i) {
+    sketch.Increment(hash);
+    EXPECT_LE(i, sketch.Estimate(hash));
+  }
+  // Counters saturate at 15.
+  sketch.Increment(hash);
+  EXPECT_EQ(15U, sketch.Estimate(hash));
+}
+
+TEST(FrequencySketchTest, BEH_DistinguishesHotFromCold) {
+  FrequencySketch sketch(1000);
+  for (std::uint64_t i(0); i != 1000; ++i) {
+    sketch.Increment(i);
+    if (i < 10) {
+      for (int j(0); j != 7; ++j)
+        sketch.Increment(i);
+    }
+  }
+  for (std::uint64_t i(0); i != 10; ++i)
+    EXPECT_LE(8U, sketch.Estimate(i));
+  unsigned cold_total(0);
+  for (std::uint64_t i(10); i != 1000; ++i)
+    cold_total += sketch.Estimate(i);
+  // Collisions may inflate a few cold estimates, but the average should stay close to 1.
+  EXPECT_GT(2.0, static_cast<double>(cold_total) / 990);
+}
+
+TEST(FrequencySketchTest, BEH_Aging) {
+  FrequencySketch sketch(16);
+  const std::uint64_t hot(1);
+  for (int i(0); i != 15; ++i)
+    sketch.Increment(hot);
+  EXPECT_EQ(15U, sketch.Estimate(hot));
+  // The sample size for 16 expected entries is 160 increments, after which all counters halve.
+  for (std::uint64_t i(100); i != 300; ++i)
+    sketch.Increment(i);
+  EXPECT_GT(15U, sketch.Estimate(hot));
+  EXPECT_LE(7U, sketch.Estimate(hot));
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -19,8 +19,15 @@
 #include "maidsafe/common/containers/lru_cache.h"
 
 #include <chrono>
+#include <cstdint>
+#include <set>
+#include <string>
 #include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
 
+#include "maidsafe/common/hash.h"
 #include "maidsafe/common/test.h"
 #include "maidsafe/common/identity.h"
 #include "maidsafe/common/utils.h"
@@ -30,6 +37,24 @@ namespace maidsafe {
 
 namespace test {
 
+namespace {
+
+struct CopyCounter {
+  explicit CopyCounter(int value_in) : value(value_in) {}
+  CopyCounter(const CopyCounter& other) : value(other.value) { ++copies; }
+  CopyCounter& operator=(const CopyCounter& other) {
+    value = other.value;
+    ++copies;
+    return *this;
+  }
+  int value;
+  static int copies;
+};
+
+int CopyCounter::copies = 0;
+
+}  // unnamed namespace
+
 TEST(LruCacheTest, BEH_SizeOnlyTest) {
   auto size(10);
   LruCache<int, int> cache(size);
@@ -180,6 +205,258 @@ TEST(LruCacheTest, BEH_TimeAndSizeStructValueTest) {
   }
 }
 
+TEST(LruCacheTest, BEH_ExpiredNotReturned) {
+  std::chrono::milliseconds time(100);
+  LruCache<int, int> cache(10, time);
+  LruCache<int, void> filter(10, time);
+  for (int i(0); i < 5; ++i) {
+    cache.Add(i, i);
+    filter.Add(i);
+  }
+  EXPECT_TRUE(cache.Get(0).valid());
+  std::this_thread::sleep_for(time + std::chrono::milliseconds(20));
+
+  // Nothing has been added since the entries expired, but they must not be returned.
+  for (int i(0); i < 5; ++i) {
+    EXPECT_FALSE(cache.Check(i));
+    EXPECT_FALSE(filter.Check(i));
+  }
+  EXPECT_EQ(5U, filter.size());
+  filter.RemoveExpired();
+  EXPECT_EQ(0U, filter.size());
+  EXPECT_FALSE(cache.Get(0).valid());
+  EXPECT_EQ(MakeError(CommonErrors::no_such_element).code(), cache.Get(0).error().code());
+  // Get also removes the expired entries.
+  EXPECT_EQ(0U, cache.size());
+
+  // Expired keys can be added again.
+  cache.Add(0, 10);
+  ASSERT_TRUE(cache.Get(0).valid());
+  EXPECT_EQ(10, cache.Get(0).value());
+}
+
+TEST(LruCacheTest, BEH_RecencyOrder) {
+  const int size(100);
+  LruCache<int, int> cache(size);
+  for (int i(0); i < size; ++i)
+    cache.Add(i, i);
+
+  // Touch the even keys, so the odd ones are evicted first.
+  for (int i(0); i < size; i += 2)
+    EXPECT_EQ(i, cache.Get(i).value());
+  for (int i(size); i < size + size / 2; ++i)
+    cache.Add(i, i);
+  for (int i(0); i < size; ++i)
+    EXPECT_EQ(i % 2 == 0, cache.Check(i)) << i;
+
+  // Re-adding an existing key neither changes its value nor its position.
+  cache.Add(0, -1);
+  EXPECT_EQ(0, cache.Get(0).value());
+  EXPECT_EQ(size, static_cast<int>(cache.size()));
+}
+
+TEST(LruCacheTest, BEH_Churn) {
+  // Exercises node recycling and rehashing across many adds and deletes, checking against a model.
+  const int size(64);
+  LruCache<int, int, SeededHash<SipHash>> cache(size);
+  std::set<int> held;
+  for (int i(0); i < 20000; ++i) {
+    const int key(static_cast<int>(RandomUint32() % 256));
+    if (RandomUint32() % 3 == 0) {
+      cache.Delete(key);
+      held.erase(key);
+    } else if (!cache.Check(key)) {
+      cache.Add(key, key * 2);
+      held.insert(key);
+    }
+    ASSERT_GE(static_cast<std::size_t>(size), cache.size());
+  }
+  for (int key(0); key < 256; ++key) {
+    if (cache.Check(key)) {
+      EXPECT_EQ(1U, held.count(key));
+      EXPECT_EQ(key * 2, cache.Get(key).value());
+    } else {
+      EXPECT_FALSE(cache.Get(key).valid());
+    }
+  }
+}
+
+TEST(LruCacheTest, BEH_StridedKeys) {
+  // Keys sharing their low bits, as e.g. aligned pointers do, are spread over the buckets.
+  const int size(1000);
+  LruCache<std::uint64_t, int> cache(size);
+  for (int i(0); i < size * 2; ++i)
+    cache.Add(static_cast<std::uint64_t>(i) << 20, i);
+  ASSERT_EQ(static_cast<std::size_t>(size), cache.size());
+  for (int i(0); i < size * 2; ++i) {
+    if (i < size) {
+      EXPECT_FALSE(cache.Check(static_cast<std::uint64_t>(i) << 20)) << i;
+    } else {
+      EXPECT_EQ(i, cache.Get(static_cast<std::uint64_t>(i) << 20).value());
+    }
+  }
+}
+
+TEST(LruCacheTest, BEH_KeysWithoutStdHash) {
+  // Keys which std::hash doesn't support are ordered by operator< instead.
+  const int size(10);
+  LruCache<Identity, void> filter(size);
+  std::vector<Identity> ids;
+  for (int i(0); i < size + 1; ++i) {
+    ids.push_back(MakeIdentity());
+    filter.Add(ids.back());
+  }
+  EXPECT_EQ(static_cast<std::size_t>(size), filter.size());
+  EXPECT_FALSE(filter.Check(ids.front()));
+  for (int i(1); i < size + 1; ++i)
+    EXPECT_TRUE(filter.Check(ids[i]));
+
+  LruCache<std::pair<int, int>, int> cache(size);
+  for (int i(0); i < size * 2; ++i)
+    cache.Add(std::make_pair(i, -i), i);
+  for (int i(0); i < size * 2; ++i) {
+    if (i < size) {
+      EXPECT_FALSE(cache.Check(std::make_pair(i, -i)));
+    } else {
+      EXPECT_EQ(i, cache.Get(std::make_pair(i, -i)).value());
+      cache.Delete(std::make_pair(i, -i));
+      EXPECT_FALSE(cache.Check(std::make_pair(i, -i)));
+    }
+  }
+  EXPECT_EQ(0U, cache.size());
+}
+
+TEST(LruCacheTest, BEH_Weighted) {
+  const std::uint64_t max_weight(1000);
+  LruCache<int, std::string> cache(MemoryUsage(max_weight),
+                                   [](const int&, const std::string& value) {
+    return static_cast<std::uint64_t>(value.size());
+  });
+  EXPECT_EQ(0U, cache.weight().data);
+
+  // Fill with ten 100-byte values.
+  for (int i(0); i < 10; ++i)
+    cache.Add(i, std::string(100, 'a'));
+  EXPECT_EQ(10U, cache.size());
+  EXPECT_EQ(max_weight, cache.weight().data);
+
+  // A 250-byte value evicts the three least recently used entries.
+  EXPECT_TRUE(cache.Get(0).valid());
+  cache.Add(10, std::string(250, 'b'));
+  EXPECT_EQ(8U, cache.size());
+  EXPECT_EQ(950U, cache.weight().data);
+  EXPECT_TRUE(cache.Check(0));
+  for (int i(1); i < 4; ++i)
+    EXPECT_FALSE(cache.Check(i));
+
+  // An entry heavier than the maximum is not added, and doesn't evict anything.
+  cache.Add(11, std::string(max_weight + 1, 'c'));
+  EXPECT_FALSE(cache.Check(11));
+  EXPECT_EQ(8U, cache.size());
+
+  // A single entry may use the whole budget.
+  cache.Add(12, std::string(max_weight, 'd'));
+  EXPECT_EQ(1U, cache.size());
+  EXPECT_EQ(max_weight, cache.weight().data);
+
+  cache.Delete(12);
+  EXPECT_EQ(0U, cache.size());
+  EXPECT_EQ(0U, cache.weight().data);
+
+  // Without a weigher, each entry weighs 1.
+  LruCache<int, int> unweighted(10);
+  for (int i(0); i < 20; ++i)
+    unweighted.Add(i, i);
+  EXPECT_EQ(10U, unweighted.weight().data);
+}
+
+TEST(LruCacheTest, BEH_NonCopyingAccess) {
+  const int size(10);
+  LruCache<int, CopyCounter> cache(size);
+  for (int i(0); i < size; ++i)
+    cache.Add(i, CopyCounter(i));
+  CopyCounter::copies = 0;
+
+  int visited(-1);
+  EXPECT_TRUE(cache.Visit(3, [&](const CopyCounter& value) { visited = value.value; }));
+  EXPECT_EQ(3, visited);
+  EXPECT_FALSE(cache.Visit(size, [&](const CopyCounter&) { visited = -1; }));
+  EXPECT_EQ(3, visited);
+
+  const CopyCounter* pointer(cache.GetPtr(4));
+  ASSERT_NE(nullptr, pointer);
+  EXPECT_EQ(4, pointer->value);
+  EXPECT_EQ(nullptr, cache.GetPtr(size));
+  EXPECT_EQ(0, CopyCounter::copies);
+
+  CopyCounter value(-1);
+  EXPECT_FALSE(cache.TryGet(size, value));
+  EXPECT_EQ(-1, value.value);
+  EXPECT_TRUE(cache.TryGet(5, value));
+  EXPECT_EQ(5, value.value);
+  EXPECT_EQ(1, CopyCounter::copies);
+
+  // Each of these counts as a use, so 0, 1 and 2 are now the least recently used entries.
+  for (int i(size); i < size + 3; ++i)
+    cache.Add(i, CopyCounter(i));
+  for (int i(0); i < 3; ++i)
+    EXPECT_FALSE(cache.Check(i));
+  for (int i(3); i < 6; ++i)
+    EXPECT_TRUE(cache.Check(i));
+}
+
+TEST(LruCacheTest, FUNC_Throughput) {
+  const int size(1 << 16), operations(1 << 21);
+  std::vector<std::uint64_t> keys;
+  keys.reserve(operations);
+  for (int i(0); i < operations; ++i)
+    keys.push_back(RandomUint32() % (size * 2));
+
+  LruCache<std::uint64_t, std::uint64_t> cache(size);
+  const auto start(std::chrono::steady_clock::now());
+  std::size_t hits(0);
+  for (const auto key : keys) {
+    if (cache.Get(key).valid())
+      ++hits;
+    else
+      cache.Add(key, key);
+  }
+  const auto elapsed(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start));
+  TLOG(kGreen) << operations << " Get/Add operations on a cache of " << size << " entries took "
+               << elapsed.count() / operations << " ns each (" << hits << " hits)\n";
+}
+
+TEST(LruCacheTest, FUNC_LargeValueHits) {
+  // Compares the cost of a hit via Get, which copies the value, and via Visit, which doesn't.
+  const int size(16), iterations(20000);
+  for (std::size_t value_size(64); value_size <= (1 << 20); value_size *= 16) {
+    LruCache<int, std::string> cache(size);
+    for (int i(0); i < size; ++i)
+      cache.Add(i, std::string(value_size, 'a'));
+
+    std::size_t total(0);
+    auto start(std::chrono::steady_clock::now());
+    for (int i(0); i < iterations; ++i)
+      total += cache.Get(i % size).value().size();
+    const auto get_time(std::chrono::steady_clock::now() - start);
+
+    start = std::chrono::steady_clock::now();
+    for (int i(0); i < iterations; ++i)
+      cache.Visit(i % size, [&](const std::string& value) { total += value.size(); });
+    const auto visit_time(std::chrono::steady_clock::now() - start);
+
+    EXPECT_EQ(2 * iterations * value_size, total);
+    TLOG(kGreen) << value_size << "-byte values: Get "
+                 << std::chrono::duration_cast<std::chrono::nanoseconds>(get_time).count() /
+                        iterations
+                 << " ns, Visit "
+                 << std::chrono::duration_cast<std::chrono::nanoseconds>(visit_time).count() /
+                        iterations
+                 << " ns per hit\n";
+  }
+}
+
 }  // namespace test
 
 }  // namespace maidsafe
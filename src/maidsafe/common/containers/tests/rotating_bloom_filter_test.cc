@@ -0,0 +1,137 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/containers/rotating_bloom_filter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/containers/lru_cache.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(RotatingBloomFilterTest, BEH_Capacity) {
+  const size_t capacity(1000);
+  RotatingBloomFilter<int> filter(capacity);
+  for (int i(0); i < 10000; ++i) {
+    filter.Add(i);
+    // The most recent 'capacity' keys are always reported.
+    for (int j(std::max(0, i - static_cast<int>(capacity) + 1)); j <= i; j += 37)
+      ASSERT_TRUE(filter.Check(j)) << i << ' ' << j;
+    ASSERT_TRUE(filter.Check(i));
+  }
+  // Keys are forgotten once a third more than 'capacity' keys have been added after them.
+  int false_positives(0);
+  for (int i(0); i < 10000 - static_cast<int>(capacity * 4 / 3) - 1; ++i)
+    false_positives += filter.Check(i) ? 1 : 0;
+  EXPECT_GT(20, false_positives);
+}
+
+TEST(RotatingBloomFilterTest, BEH_FalsePositiveRate) {
+  for (const double rate : {0.01, 0.001}) {
+    RotatingBloomFilter<std::string> filter(10000, rate);
+    for (int i(0); i != 10000; ++i)
+      filter.Add(RandomString(20));
+    const int tries(100000);
+    int false_positives(0);
+    for (int i(0); i != tries; ++i)
+      false_positives += filter.Check(RandomString(20)) ? 1 : 0;
+    EXPECT_GT(2 * rate * tries, false_positives) << rate;
+  }
+}
+
+TEST(RotatingBloomFilterTest, BEH_TimeToLive) {
+  std::chrono::milliseconds time(150);
+  RotatingBloomFilter<int> filter(1000, time);
+  filter.Add(0);
+  std::this_thread::sleep_for(time / 2);
+  filter.Add(1);
+  EXPECT_TRUE(filter.Check(0));
+  EXPECT_TRUE(filter.Check(1));
+  // The first key was the last added to its generation over 'time' ago, so is forgotten.
+  std::this_thread::sleep_for(time * 2 / 3 + std::chrono::milliseconds(10));
+  EXPECT_FALSE(filter.Check(0));
+  EXPECT_TRUE(filter.Check(1));
+  std::this_thread::sleep_for(time);
+  EXPECT_FALSE(filter.Check(1));
+
+  // Expired keys can be added again.
+  filter.Add(0);
+  EXPECT_TRUE(filter.Check(0));
+}
+
+TEST(RotatingBloomFilterTest, BEH_InvalidArguments) {
+  EXPECT_THROW(RotatingBloomFilter<int>(0), maidsafe_error);
+  EXPECT_THROW(RotatingBloomFilter<int>(10, 0.0), maidsafe_error);
+  EXPECT_THROW(RotatingBloomFilter<int>(10, 1.0), maidsafe_error);
+}
+
+TEST(RotatingBloomFilterTest, FUNC_CompareWithLruCache) {
+  // Compares the cost of recording each message as seen once, as a message firewall does.
+  const size_t capacity(100000);
+  const int message_count(1000000);
+  std::vector<std::string> messages;
+  messages.reserve(capacity);
+  for (size_t i(0); i != capacity; ++i)
+    messages.push_back(RandomString(64));
+
+  const auto run([&](const std::string& name, std::function<bool(const std::string&)> check,
+                     std::function<void(const std::string&)> add) {
+    const auto start(std::chrono::steady_clock::now());
+    int duplicates(0);
+    for (int i(0); i != message_count; ++i) {
+      // Change the first bytes so every message is new.
+      std::string message(messages[i % capacity]);
+      message[0] = static_cast<char>(i);
+      message[1] = static_cast<char>(i >> 8);
+      message[2] = static_cast<char>(i >> 16);
+      if (check(message))
+        ++duplicates;
+      else
+        add(message);
+    }
+    const auto elapsed(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start));
+    TLOG(kGreen) << name << ": " << elapsed.count() / message_count << " ns per message, "
+                 << duplicates << " false duplicates\n";
+  });
+
+  LruCache<std::string, void, SeededHash<SipHash>> cache(capacity);
+  run("LruCache", [&](const std::string& message) { return cache.Check(message); },
+      [&](const std::string& message) { cache.Add(message); });
+
+  RotatingBloomFilter<std::string> filter(capacity);
+  run("RotatingBloomFilter", [&](const std::string& message) { return filter.Check(message); },
+      [&](const std::string& message) { filter.Add(message); });
+  TLOG(kGreen) << "RotatingBloomFilter uses " << filter.memory_usage().data << " bytes for "
+               << capacity << " keys, versus at least " << capacity * 64
+               << " bytes for the keys alone in LruCache\n";
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
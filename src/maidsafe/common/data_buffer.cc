@@ -18,13 +18,19 @@
 
 #include "maidsafe/common/data_buffer.h"
 
+#include <algorithm>
 #include <chrono>
+#include <ctime>
+#include <iterator>
+#include <vector>
 
 #include "boost/filesystem/convenience.hpp"
 
 #include "maidsafe/common/convert.h"
 #include "maidsafe/common/encode.h"
 #include "maidsafe/common/log.h"
+#include "maidsafe/common/on_scope_exit.h"
+#include "maidsafe/common/segment_log.h"
 #include "maidsafe/common/tagged_value.h"
 #include "maidsafe/common/utils.h"
 
@@ -32,31 +38,73 @@ namespace fs = boost::filesystem;
 
 namespace maidsafe {
 
+namespace {
+
+// The frequency sketch is only used by EvictionPolicy::kTinyLfu.  It is sized assuming an average
+// value size of 1KB.
+std::size_t FrequencySketchSize(MemoryUsage max_memory_usage,
+                                DataBuffer::EvictionPolicy eviction_policy) {
+  if (eviction_policy != DataBuffer::EvictionPolicy::kTinyLfu)
+    return 0;
+  return static_cast<std::size_t>(std::min<std::uint64_t>(max_memory_usage.data / 1024, 1 << 20));
+}
+
+}  // unnamed namespace
+
+const std::size_t DataBuffer::kMaxCopyBatchSize_(64);
+
 DataBuffer::DataBuffer(MemoryUsage max_memory_usage, DiskUsage max_disk_usage,
-                       PopFunctor pop_functor)
+                       PopFunctor pop_functor, DiskBackend disk_backend,
+                       EvictionPolicy eviction_policy, std::size_t expected_key_count)
     : memory_store_(max_memory_usage),
       disk_store_(max_disk_usage),
+      oldest_memory_only_(memory_store_.index.end()),
       kPopFunctor_(std::move(pop_functor)),
       kDiskBuffer_(fs::unique_path(fs::temp_directory_path() / "DB-%%%%-%%%%-%%%%-%%%%")),
-      kShouldRemoveRoot_(true) {
-  Init();
+      kShouldRemoveRoot_(true),
+      segment_log_(),
+      key_filter_(expected_key_count == 0 ? nullptr : new KeyFilter(expected_key_count)),
+      kEvictionPolicy_(eviction_policy),
+      kKeyHash_(),
+      frequency_sketch_(FrequencySketchSize(max_memory_usage, eviction_policy)),
+      queued_promotions_(),
+      queued_promotions_size_(0),
+      keys_being_deleted_() {
+  Init(disk_backend, ExistingValues::kIgnore);
 }
 
 DataBuffer::DataBuffer(MemoryUsage max_memory_usage, DiskUsage max_disk_usage,
-                       PopFunctor pop_functor, const fs::path& disk_buffer, bool should_remove_root)
+                       PopFunctor pop_functor, const fs::path& disk_buffer, bool should_remove_root,
+                       DiskBackend disk_backend, EvictionPolicy eviction_policy,
+                       ExistingValues existing_values, std::size_t expected_key_count)
     : memory_store_(max_memory_usage),
       disk_store_(max_disk_usage),
+      oldest_memory_only_(memory_store_.index.end()),
       kPopFunctor_(std::move(pop_functor)),
       kDiskBuffer_(disk_buffer),
-      kShouldRemoveRoot_(should_remove_root) {
-  Init();
+      kShouldRemoveRoot_(should_remove_root),
+      segment_log_(),
+      key_filter_(expected_key_count == 0 ? nullptr : new KeyFilter(expected_key_count)),
+      kEvictionPolicy_(eviction_policy),
+      kKeyHash_(),
+      frequency_sketch_(FrequencySketchSize(max_memory_usage, eviction_policy)),
+      queued_promotions_(),
+      queued_promotions_size_(0),
+      keys_being_deleted_() {
+  Init(disk_backend, existing_values);
 }
 
-void DataBuffer::Init() {
+void DataBuffer::Init(DiskBackend disk_backend, ExistingValues existing_values) {
+  memory_store_.index.set_filter(key_filter_.get());
+  disk_store_.index.set_filter(key_filter_.get());
   if (memory_store_.max > disk_store_.max) {
     LOG(kError) << "Max memory usage must be < max disk usage.";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
   }
+  if (existing_values == ExistingValues::kRecover && disk_backend != DiskBackend::kFilePerValue) {
+    LOG(kError) << "Existing values can only be recovered by the file per value disk backend.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
   boost::system::error_code error_code;
   if (!fs::exists(kDiskBuffer_, error_code)) {
     if (!fs::create_directories(kDiskBuffer_, error_code)) {
@@ -73,25 +121,109 @@ void DataBuffer::Init() {
     return;
   }
   fs::remove(test_file);
+  if (existing_values == ExistingValues::kRecover)
+    RecoverDiskIndex();
+  if (disk_backend == DiskBackend::kSegmentLog)
+    segment_log_.reset(new SegmentLog(kDiskBuffer_));
   worker_ = std::async(std::launch::async, &DataBuffer::CopyQueueToDisk, this);
 }
 
+void DataBuffer::RecoverDiskIndex() {
+  struct RecoveredValue {
+    KeyType key;
+    uint64_t size;
+    std::time_t last_write_time;
+  };
+
+  std::vector<fs::path> paths;
+  boost::system::error_code error_code;
+  for (fs::directory_iterator itr(kDiskBuffer_, error_code), end; !error_code && itr != end;
+       itr.increment(error_code)) {
+    paths.push_back(itr->path());
+  }
+  if (error_code) {
+    LOG(kError) << "Failed to list " << kDiskBuffer_ << ": " << error_code.message();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+
+  // Decoding the names and reading the file attributes is split across several threads.
+  const std::size_t thread_count(
+      std::max<std::size_t>(1, std::min<std::size_t>(Concurrency(), paths.size() / 256)));
+  std::vector<std::future<std::vector<RecoveredValue>>> scans;
+  for (std::size_t i(0); i != thread_count; ++i) {
+    scans.emplace_back(std::async(std::launch::async, [&paths, i, thread_count] {
+      std::vector<RecoveredValue> values;
+      for (std::size_t j(i); j < paths.size(); j += thread_count) {
+        boost::system::error_code error_code;
+        if (!fs::is_regular_file(paths[j], error_code))
+          continue;
+        RecoveredValue value;
+        value.size = fs::file_size(paths[j], error_code);
+        if (!error_code)
+          value.last_write_time = fs::last_write_time(paths[j], error_code);
+        if (error_code || value.size == 0)
+          continue;
+        try {
+          value.key = detail::GetDataNameAndTypeId(paths[j].filename());
+        } catch (const std::exception&) {
+          LOG(kWarning) << "Ignoring " << paths[j] << " since its name isn't a valid key.";
+          continue;
+        }
+        values.push_back(std::move(value));
+      }
+      return values;
+    }));
+  }
+  std::vector<RecoveredValue> values;
+  for (auto& scan : scans) {
+    auto scanned(scan.get());
+    std::move(scanned.begin(), scanned.end(), std::back_inserter(values));
+  }
+  std::stable_sort(values.begin(), values.end(),
+                   [](const RecoveredValue& lhs, const RecoveredValue& rhs) {
+    return lhs.last_write_time < rhs.last_write_time;
+  });
+
+  for (const auto& value : values) {
+    (*disk_store_.index.emplace_back(value.key)).state = StoringState::kCompleted;
+    disk_store_.current.data += value.size;
+  }
+  while (disk_store_.current > disk_store_.max) {
+    auto itr(FindOldestOnDisk());
+    KeyType oldest_key(itr->key);
+    NonEmptyString oldest_value;
+    auto size_before(disk_store_.current.data);
+    RemoveFile(oldest_key, kPopFunctor_ ? &oldest_value : nullptr);
+    disk_store_.index.erase(itr);
+    Count(counters_.pops);
+    Count(counters_.popped_bytes, size_before - disk_store_.current.data);
+    if (kPopFunctor_)
+      kPopFunctor_(oldest_key, oldest_value);
+  }
+  LOG(kInfo) << "Recovered " << disk_store_.index.size() << " values from " << kDiskBuffer_;
+}
+
 DataBuffer::~DataBuffer() {
   {
     std::lock(memory_store_.mutex, disk_store_.mutex);
     std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex, std::adopt_lock);
     std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex, std::adopt_lock);
     running_ = false;
-    memory_store_.cond_var.notify_all();
-    disk_store_.cond_var.notify_all();
+    NotifyWaiters(memory_store_);
+    NotifyWaiters(disk_store_);
+  }
+  {
+    // Queued asynchronous operations have been retried by the notifications above and will fail.
+    std::unique_lock<std::mutex> async_lock(async_mutex_);
+    async_cond_var_.wait(async_lock, [this] { return async_operation_count_ == 0; });
   }
   {
     std::unique_lock<std::mutex> worker_lock(worker_mutex_);
     while (worker_.valid() &&
            worker_.wait_for(std::chrono::seconds(0)) == std::future_status::timeout) {
       worker_lock.unlock();
-      memory_store_.cond_var.notify_all();
-      disk_store_.cond_var.notify_all();
+      NotifyWaiters(memory_store_);
+      NotifyWaiters(disk_store_);
       std::this_thread::yield();
       worker_lock.lock();
     }
@@ -104,6 +236,7 @@ DataBuffer::~DataBuffer() {
     }
   }
 
+  segment_log_.reset();
   if (kShouldRemoveRoot_) {
     boost::system::error_code error_code;
     fs::remove_all(kDiskBuffer_, error_code);
@@ -113,27 +246,50 @@ DataBuffer::~DataBuffer() {
 }
 
 void DataBuffer::Store(const KeyType& key, const NonEmptyString& value) {
+  DoStore(key, std::make_shared<const NonEmptyString>(value), true);
+}
+
+void DataBuffer::Store(const KeyType& key, SharedValue value) {
+  DoStore(key, value, true);
+}
+
+bool DataBuffer::DoStore(const KeyType& key, const SharedValue& value, bool wait) {
+  const auto start(std::chrono::steady_clock::now());
+  if (!value) {
+    LOG(kError) << "Cannot store " << DebugKeyName(key) << " with a null value.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::null_pointer));
+  }
   try {
-    Delete(key);
+    DoDelete(key);
   } catch (const std::exception&) {
-    LOG(kVerbose) << "Storing " << DebugKeyName(key) << " with value " << value;
+    LOG(kVerbose) << "Storing " << DebugKeyName(key) << " with value " << *value;
   }
 
   CheckWorkerIsStillRunning();
-  auto disk_store_lock(StoreInMemory(key, value));
-  if (disk_store_lock)
-    StoreOnDisk(key, value, std::move(disk_store_lock));
+  bool would_block(false);
+  auto disk_store_lock(StoreInMemory(key, value, wait, would_block));
+  if (would_block)
+    return false;
+  if (disk_store_lock && !StoreOnDisk(key, value, std::move(disk_store_lock), wait))
+    return false;
+  Count(counters_.stores);
+  counters_.store_latency.Record(Since(start));
+  return true;
 }
 
 std::unique_lock<std::mutex> DataBuffer::StoreInMemory(const KeyType& key,
-                                                       const NonEmptyString& value) {
+                                                       const SharedValue& value, bool wait,
+                                                       bool& would_block) {
   {
-    uint64_t required_space(value.string().size());
+    uint64_t required_space(value->string().size());
     std::unique_lock<std::mutex> memory_store_lock(memory_store_.mutex);
     if (required_space > memory_store_.max)
       return std::move(std::unique_lock<std::mutex>(disk_store_.mutex));
 
-    WaitForSpaceInMemory(required_space, memory_store_lock);
+    if (!WaitForSpaceInMemory(required_space, memory_store_lock, wait)) {
+      would_block = true;
+      return std::move(std::unique_lock<std::mutex>());
+    }
 
     if (!running_) {
       {
@@ -144,62 +300,101 @@ std::unique_lock<std::mutex> DataBuffer::StoreInMemory(const KeyType& key,
       return std::move(std::unique_lock<std::mutex>());
     }
 
+    RecordAccess(key);
     memory_store_.current.data += required_space;
-    memory_store_.index.emplace_back(key, value);
+    auto itr(memory_store_.index.emplace_back(key, value));
+    if (oldest_memory_only_ == memory_store_.index.end())
+      oldest_memory_only_ = itr;
+    copy_backlog_.bytes += required_space;
+    ++copy_backlog_.entries;
   }
-  memory_store_.cond_var.notify_all();
+  NotifyWaiters(memory_store_);
   return std::move(std::unique_lock<std::mutex>());
 }
 
-void DataBuffer::WaitForSpaceInMemory(uint64_t required_space,
-                                      std::unique_lock<std::mutex>& memory_store_lock) {
+bool DataBuffer::WaitForSpaceInMemory(uint64_t required_space,
+                                      std::unique_lock<std::mutex>& memory_store_lock, bool wait) {
+  if (HasSpace(memory_store_, required_space))
+    return true;
+  const auto start(std::chrono::steady_clock::now());
+  on_scope_exit record_wait(
+      [&] { Count(counters_.memory_wait_nanoseconds, Since(start).count()); });
   while (!HasSpace(memory_store_, required_space)) {
-    auto itr(FindMemoryRemovalCandidate(required_space, memory_store_lock));
+    auto itr(FindMemoryRemovalCandidate(required_space, memory_store_lock, wait));
     if (!running_)
-      return;
+      return true;
 
     if (itr != memory_store_.index.end()) {
-      memory_store_.current.data -= (*itr).value.string().size();
-      memory_store_.index.erase(itr);
+      memory_store_.current.data -= (*itr).value->string().size();
+      EraseFromMemory(itr);
+      Count(counters_.memory_evictions);
+    } else if (!wait && !HasSpace(memory_store_, required_space)) {
+      return false;
     }
   }
+  return true;
 }
 
-void DataBuffer::StoreOnDisk(const KeyType& key, const NonEmptyString& value,
-                             std::unique_lock<std::mutex>&& disk_store_lock) {
+bool DataBuffer::StoreOnDisk(const KeyType& key, const SharedValue& value,
+                             std::unique_lock<std::mutex>&& disk_store_lock, bool wait) {
   assert(disk_store_lock);
-  if (value.string().size() > disk_store_.max) {
-    LOG(kError) << "Cannot store " << DebugKeyName(key) << " since its " << value.string().size()
+  const uint64_t size(value->string().size());
+  ThrowIfTooLargeForDisk(key, size);
+  // Without a pop functor, space is only made by calls to Delete.
+  if (!wait && !kPopFunctor_ && !HasSpace(disk_store_, size))
+    return false;
+  disk_store_.index.emplace_back(key);
+  WriteValueToDisk(key, value, disk_store_lock);
+  disk_store_lock.unlock();
+  NotifyWaiters(disk_store_);
+  return true;
+}
+
+void DataBuffer::ThrowIfTooLargeForDisk(const KeyType& key, uint64_t size) {
+  if (size > disk_store_.max) {
+    LOG(kError) << "Cannot store " << DebugKeyName(key) << " since its " << size
                 << " bytes exceeds max of " << disk_store_.max << " bytes.";
     StopRunning();
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::cannot_exceed_limit));
   }
-  disk_store_.index.emplace_back(key);
+}
 
+void DataBuffer::WriteValueToDisk(const KeyType& key, const SharedValue& value,
+                                  std::unique_lock<std::mutex>& disk_store_lock) {
   bool cancelled(false);
-  WaitForSpaceOnDisk(key, &value, disk_store_lock, cancelled);
-  if (!running_)
+  WaitForSpaceOnDisk(key, value, disk_store_lock, cancelled);
+  if (!running_ || cancelled)
     return;
 
-  if (!cancelled) {
-    if (!WriteFile(GetFilename(key), value.string())) {
-      LOG(kError) << "Failed to move " << DebugKeyName(key) << " to disk.";
-      StopRunning();
-      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
-    }
-    auto itr(FindStartedToStoreOnDisk(key));
+  auto itr(FindStartedToStoreOnDisk(key));
+  if (itr == disk_store_.index.end()) {
+    // Deleted while queued behind other values in the same batch.
+    itr = disk_store_.index.find(
+        key, [](const DiskElement& entry) { return entry.state == StoringState::kCancelled; });
     if (itr != disk_store_.index.end())
-      (*itr).state = StoringState::kCompleted;
-
-    disk_store_.current.data += value.string().size();
+      disk_store_.index.erase(itr);
+    return;
   }
-  disk_store_lock.unlock();
-  disk_store_.cond_var.notify_all();
+  const auto start(std::chrono::steady_clock::now());
+  if (!WriteToDisk(key, *value)) {
+    LOG(kError) << "Failed to move " << DebugKeyName(key) << " to disk.";
+    StopRunning();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  counters_.spill_latency.Record(Since(start));
+  (*itr).state = StoringState::kCompleted;
+  disk_store_.current.data += value->string().size();
+  Count(counters_.spills);
+  Count(counters_.spilled_bytes, value->string().size());
 }
 
-void DataBuffer::WaitForSpaceOnDisk(const KeyType& key, const NonEmptyString* const value,
+void DataBuffer::WaitForSpaceOnDisk(const KeyType& key, const SharedValue& value,
                                     std::unique_lock<std::mutex>& disk_store_lock,
                                     bool& cancelled) {
+  if (HasSpace(disk_store_, value->string().size()))
+    return;
+  const auto start(std::chrono::steady_clock::now());
+  on_scope_exit record_wait([&] { Count(counters_.disk_wait_nanoseconds, Since(start).count()); });
   while (!HasSpace(disk_store_, value->string().size()) && running_) {
     auto itr(Find(disk_store_, key));
     if (itr == disk_store_.index.end()) {
@@ -221,6 +416,8 @@ void DataBuffer::WaitForSpaceOnDisk(const KeyType& key, const NonEmptyString* co
         NonEmptyString oldest_value;
         RemoveFile(oldest_key, &oldest_value);
         disk_store_.index.erase(itr);
+        Count(counters_.pops);
+        Count(counters_.popped_bytes, oldest_value.string().size());
         kPopFunctor_(oldest_key, oldest_value);
       }
     } else {
@@ -237,110 +434,588 @@ void DataBuffer::WaitForSpaceOnDisk(const KeyType& key, const NonEmptyString* co
 }
 
 NonEmptyString DataBuffer::Get(const KeyType& key) {
+  return *GetShared(key);
+}
+
+DataBuffer::SharedValue DataBuffer::GetShared(const KeyType& key) {
+  SharedValue value;
+  DoGet(key, true, value);
+  return value;
+}
+
+boost::optional<NonEmptyString> DataBuffer::TryGet(const KeyType& key) {
+  const auto start(std::chrono::steady_clock::now());
+  if (!MightHold(key))
+    return boost::none;
   CheckWorkerIsStillRunning();
+  SharedValue value;
   {
     std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
-    auto itr(Find(memory_store_, key));
-    if (itr != memory_store_.index.end())
-      return (*itr).value;
+    if (GetFromMemory(key, value)) {
+      counters_.get_latency.Record(Since(start));
+      return *value;
+    }
   }
-  std::unique_lock<std::mutex> disk_store_lock(disk_store_.mutex);
+  std::vector<QueuedPromotion> promotions;
+  {
+    std::unique_lock<std::mutex> disk_store_lock(disk_store_.mutex);
+    if (!GetFromDiskIfHeld(key, disk_store_lock, value, promotions))
+      return boost::none;
+  }
+  QueuePromotions(std::move(promotions));
+  counters_.get_latency.Record(Since(start));
+  return *value;
+}
+
+bool DataBuffer::Has(const KeyType& key) {
+  if (!MightHold(key))
+    return false;
+  CheckWorkerIsStillRunning();
+  {
+    std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
+    if (Find(memory_store_, key) != memory_store_.index.end())
+      return true;
+  }
+  std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex);
+  auto itr(Find(disk_store_, key));
+  return itr != disk_store_.index.end() && (*itr).state != StoringState::kCancelled;
+}
+
+bool DataBuffer::DoGet(const KeyType& key, bool wait, SharedValue& value) {
+  const auto start(std::chrono::steady_clock::now());
+  if (!MightHold(key))
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+  CheckWorkerIsStillRunning();
+  {
+    std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
+    if (GetFromMemory(key, value)) {
+      counters_.get_latency.Record(Since(start));
+      return true;
+    }
+  }
+  std::vector<QueuedPromotion> promotions;
+  {
+    std::unique_lock<std::mutex> disk_store_lock(disk_store_.mutex);
+    if (!GetFromDisk(key, wait, disk_store_lock, value, promotions))
+      return false;
+  }
+  QueuePromotions(std::move(promotions));
+  counters_.get_latency.Record(Since(start));
+  return true;
+}
+
+bool DataBuffer::GetFromMemory(const KeyType& key, SharedValue& value) {
+  auto itr(Find(memory_store_, key));
+  if (itr == memory_store_.index.end())
+    return false;
+  Count(counters_.memory_hits);
+  if (kEvictionPolicy_ != EvictionPolicy::kFifo) {
+    RecordAccess(key);
+    // Only values already copied to disk can be removed from memory, and these are all before
+    // 'oldest_memory_only_', so moving there makes this the last to be removed.
+    if ((*itr).also_on_disk == StoringState::kCompleted)
+      memory_store_.index.move_before(oldest_memory_only_, itr);
+  }
+  value = (*itr).value;
+  return true;
+}
+
+bool DataBuffer::GetFromDiskIfHeld(const KeyType& key,
+                                   std::unique_lock<std::mutex>& disk_store_lock,
+                                   SharedValue& value, std::vector<QueuedPromotion>& promotions) {
+  auto itr(Find(disk_store_, key));
+  if (itr == disk_store_.index.end() || (*itr).state == StoringState::kCancelled) {
+    Count(counters_.misses);
+    return false;
+  }
+  try {
+    return GetFromDisk(key, true, disk_store_lock, value, promotions);
+  } catch (const common_error& error) {
+    // The value may have been deleted while waiting for it to be written to disk.
+    if (error.code() != make_error_code(CommonErrors::no_such_element))
+      throw;
+  }
+  return false;
+}
+
+bool DataBuffer::MightHold(const KeyType& key) {
+  if (!key_filter_ || key_filter_->MightContain(key))
+    return true;
+  Count(counters_.misses);
+  // Checking 'running_' is enough to report a failed worker without the cost of checking its
+  // future on every miss.
+  if (!running_)
+    CheckWorkerIsStillRunning();
+  return false;
+}
+
+bool DataBuffer::GetFromDisk(const KeyType& key, bool wait,
+                             std::unique_lock<std::mutex>& disk_store_lock, SharedValue& value,
+                             std::vector<QueuedPromotion>& promotions) {
   auto itr(FindAndThrowIfCancelled(key));
   if ((*itr).state == StoringState::kStarted) {
     auto temp_itr(elements_being_moved_to_disk_.find(key));
-    if (temp_itr != std::end(elements_being_moved_to_disk_))
-      return *temp_itr->second;
+    if (temp_itr != std::end(elements_being_moved_to_disk_)) {
+      value = temp_itr->second;
+      Count(counters_.disk_hits);
+      return true;
+    }
+    if (!wait)
+      return false;
     disk_store_.cond_var.wait(disk_store_lock, [this, &key]() -> bool {
       auto itr(Find(disk_store_, key));
       return (itr == disk_store_.index.end() || (*itr).state != StoringState::kStarted);
     });
     itr = FindAndThrowIfCancelled(key);
   }
-  auto result(ReadFile(GetFilename(key)));
-  if (result)
-    return NonEmptyString(*result);
-  else
-    BOOST_THROW_EXCEPTION(result.error());
-  // TODO(Fraser#5#): 2012-11-23 - There should maybe be another background task moving the item
-  //                               from wherever it's found to the back of the memory index.
+  value = std::make_shared<const NonEmptyString>(ReadFromDisk(key));
+  Count(counters_.disk_hits);
+  if (kEvictionPolicy_ != EvictionPolicy::kFifo) {
+    disk_store_.index.move_before(disk_store_.index.end(), itr);
+    promotions.emplace_back(key, value, disk_store_.index.sequence_number(itr));
+  }
+  return true;
 }
 
 void DataBuffer::Delete(const KeyType& key) {
+  DoDelete(key);
+  Count(counters_.deletes);
+}
+
+void DataBuffer::DoDelete(const KeyType& key) {
   CheckWorkerIsStillRunning();
   StoringState also_on_disk(StoringState::kNotStarted);
   DeleteFromMemory(key, also_on_disk);
+  on_scope_exit allow_promotion([&] {
+    if (kEvictionPolicy_ == EvictionPolicy::kFifo)
+      return;
+    std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
+    keys_being_deleted_.erase(keys_being_deleted_.find(key));
+  });
   if (also_on_disk != StoringState::kNotStarted)
     DeleteFromDisk(key);
 }
 
 void DataBuffer::Delete(std::function<bool(const KeyType&)> predicate) {
   CheckWorkerIsStillRunning();
+  // Both stores are locked together so that a queued promotion can't copy a value back into memory
+  // between its removal from each.
+  std::lock(memory_store_.mutex, disk_store_.mutex);
+  std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex, std::adopt_lock);
+  std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex, std::adopt_lock);
   {
-    std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
     auto before_size(memory_store_.index.size());
-    memory_store_.index.erase(std::remove_if(std::begin(memory_store_.index),
-                                             std::end(memory_store_.index),
-                                             [&](const MemoryElement& item) {
-                                if (predicate(item.key)) {
-                                  memory_store_.current.data -= item.value.string().size();
-                                  return true;
-                                } else {
-                                  return false;
-                                }
-                              }),
-                              std::end(memory_store_.index));
+    auto itr(memory_store_.index.begin());
+    while (itr != memory_store_.index.end()) {
+      if (predicate((*itr).key)) {
+        memory_store_.current.data -= (*itr).value->string().size();
+        itr = EraseFromMemory(itr);
+      } else {
+        ++itr;
+      }
+    }
     if (memory_store_.index.size() != before_size)
-      memory_store_.cond_var.notify_all();
+      NotifyWaiters(memory_store_);
   }
-  std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex);
   auto before_size(disk_store_.index.size());
-  disk_store_.index.erase(
-      std::remove_if(std::begin(disk_store_.index), std::end(disk_store_.index),
-                     [&](const DiskElement& item) { return predicate(item.key); }),
-      std::end(disk_store_.index));
+  auto itr(disk_store_.index.begin());
+  while (itr != disk_store_.index.end()) {
+    if (predicate((*itr).key))
+      itr = disk_store_.index.erase(itr);
+    else
+      ++itr;
+  }
   if (disk_store_.index.size() != before_size)
-    disk_store_.cond_var.notify_all();
+    NotifyWaiters(disk_store_);
 }
 
-void DataBuffer::DeleteFromMemory(const KeyType& key, StoringState& also_on_disk) {
+void DataBuffer::StoreBatch(const std::vector<std::pair<KeyType, NonEmptyString>>& key_values) {
+  std::vector<std::pair<KeyType, SharedValue>> shared_key_values;
+  shared_key_values.reserve(key_values.size());
+  for (const auto& key_value : key_values) {
+    shared_key_values.emplace_back(key_value.first,
+                                   std::make_shared<const NonEmptyString>(key_value.second));
+  }
+  StoreBatch(shared_key_values);
+}
+
+void DataBuffer::StoreBatch(const std::vector<std::pair<KeyType, SharedValue>>& key_values) {
+  for (const auto& key_value : key_values) {
+    if (!key_value.second) {
+      LOG(kError) << "Cannot store " << DebugKeyName(key_value.first) << " with a null value.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::null_pointer));
+    }
+  }
+  // As for consecutive calls to Store, the last value given for a key replaces any earlier ones.
+  std::vector<const std::pair<KeyType, SharedValue>*> unique_key_values;
+  std::vector<KeyType> keys;
+  {
+    std::unordered_set<KeyType, KeyHash> seen(key_values.size(), kKeyHash_);
+    for (auto itr(key_values.rbegin()); itr != key_values.rend(); ++itr) {
+      if (seen.insert(itr->first).second) {
+        unique_key_values.push_back(&*itr);
+        keys.push_back(itr->first);
+      }
+    }
+  }
+  std::reverse(std::begin(unique_key_values), std::end(unique_key_values));
+  DeleteBatch(keys);
+
+  std::vector<const std::pair<KeyType, SharedValue>*> for_memory, for_disk;
+  {
+    std::unique_lock<std::mutex> memory_store_lock(memory_store_.mutex);
+    for (auto key_value : unique_key_values) {
+      if (key_value->second->string().size() > memory_store_.max)
+        for_disk.push_back(key_value);
+      else
+        for_memory.push_back(key_value);
+    }
+    auto run_begin(for_memory.begin());
+    while (run_begin != for_memory.end() && running_) {
+      // Reserve space for as many consecutive values as fit in memory together.
+      uint64_t required_space(0);
+      auto run_end(run_begin);
+      while (run_end != for_memory.end() &&
+             required_space + (*run_end)->second->string().size() <= memory_store_.max) {
+        required_space += (*run_end)->second->string().size();
+        ++run_end;
+      }
+      WaitForSpaceInMemory(required_space, memory_store_lock, true);
+      if (!running_)
+        break;
+      for (; run_begin != run_end; ++run_begin) {
+        RecordAccess((*run_begin)->first);
+        const uint64_t size((*run_begin)->second->string().size());
+        memory_store_.current.data += size;
+        auto itr(memory_store_.index.emplace_back((*run_begin)->first, (*run_begin)->second));
+        if (oldest_memory_only_ == memory_store_.index.end())
+          oldest_memory_only_ = itr;
+        copy_backlog_.bytes += size;
+        ++copy_backlog_.entries;
+        Count(counters_.stores);
+      }
+      NotifyWaiters(memory_store_);
+    }
+  }
+  CheckWorkerIsStillRunning();
+
+  if (for_disk.empty())
+    return;
+  {
+    std::unique_lock<std::mutex> disk_store_lock(disk_store_.mutex);
+    for (const auto& key_value : for_disk) {
+      ThrowIfTooLargeForDisk(key_value->first, key_value->second->string().size());
+      disk_store_.index.emplace_back(key_value->first);
+      WriteValueToDisk(key_value->first, key_value->second, disk_store_lock);
+      if (!running_)
+        break;
+      Count(counters_.stores);
+    }
+  }
+  NotifyWaiters(disk_store_);
+  CheckWorkerIsStillRunning();
+}
+
+std::vector<DataBuffer::SharedValue> DataBuffer::GetBatch(const std::vector<KeyType>& keys) {
+  CheckWorkerIsStillRunning();
+  std::vector<SharedValue> values(keys.size());
+  std::vector<std::size_t> not_in_memory;
+  for (std::size_t i(0); i != keys.size(); ++i) {
+    if (MightHold(keys[i]))
+      not_in_memory.push_back(i);
+  }
+  if (not_in_memory.empty())
+    return values;
+  {
+    std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
+    not_in_memory.erase(std::remove_if(std::begin(not_in_memory), std::end(not_in_memory),
+                                       [&](std::size_t i) {
+                                         return GetFromMemory(keys[i], values[i]);
+                                       }),
+                        std::end(not_in_memory));
+  }
+  if (not_in_memory.empty())
+    return values;
+
+  std::vector<QueuedPromotion> promotions;
+  {
+    std::unique_lock<std::mutex> disk_store_lock(disk_store_.mutex);
+    for (auto i : not_in_memory)
+      GetFromDiskIfHeld(keys[i], disk_store_lock, values[i], promotions);
+  }
+  QueuePromotions(std::move(promotions));
+  return values;
+}
+
+void DataBuffer::DeleteBatch(const std::vector<KeyType>& keys) {
+  CheckWorkerIsStillRunning();
+  std::vector<const KeyType*> maybe_on_disk;
   bool changed(false);
+  uint64_t deleted(0);
   {
     std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
-    auto itr(Find(memory_store_, key));
-    if (itr != memory_store_.index.end()) {
-      also_on_disk = (*itr).also_on_disk;
-      memory_store_.current.data -= (*itr).value.string().size();
-      memory_store_.index.erase(itr);
-      changed = true;
+    for (const auto& key : keys) {
+      if (kEvictionPolicy_ != EvictionPolicy::kFifo)
+        keys_being_deleted_.insert(key);
+      StoringState also_on_disk(StoringState::kNotStarted);
+      if (EraseKeyFromMemory(key, also_on_disk)) {
+        changed = true;
+        if (also_on_disk == StoringState::kNotStarted)
+          ++deleted;
+      }
+      if (also_on_disk != StoringState::kNotStarted)
+        maybe_on_disk.push_back(&key);
+    }
+  }
+  on_scope_exit count_deletes([&] { Count(counters_.deletes, deleted); });
+  on_scope_exit allow_promotion([&] {
+    if (kEvictionPolicy_ == EvictionPolicy::kFifo)
+      return;
+    std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
+    for (const auto& key : keys)
+      keys_being_deleted_.erase(keys_being_deleted_.find(key));
+  });
+  if (changed)
+    NotifyWaiters(memory_store_);
+  if (maybe_on_disk.empty())
+    return;
+
+  {
+    std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex);
+    for (auto key : maybe_on_disk) {
+      if (EraseKeyFromDisk(*key))
+        ++deleted;
+    }
+  }
+  NotifyWaiters(disk_store_);
+}
+
+void DataBuffer::StoreAsync(AsioService& asio_service, const KeyType& key,
+                            const NonEmptyString& value, StoreHandler handler) {
+  auto shared_value(std::make_shared<const NonEmptyString>(value));
+  StartAsync(asio_service, [this, key, shared_value, handler]() -> bool {
+    std::error_code error;
+    try {
+      if (!DoStore(key, shared_value, false))
+        return false;
+    } catch (const std::system_error& e) {
+      error = e.code();
+    } catch (const std::exception& e) {
+      LOG(kError) << boost::diagnostic_information(e);
+      error = make_error_code(CommonErrors::unknown);
+    }
+    handler(error);
+    return true;
+  });
+}
+
+std::future<void> DataBuffer::StoreAsync(AsioService& asio_service, const KeyType& key,
+                                         const NonEmptyString& value) {
+  auto shared_value(std::make_shared<const NonEmptyString>(value));
+  auto promise(std::make_shared<std::promise<void>>());
+  StartAsync(asio_service, [this, key, shared_value, promise]() -> bool {
+    try {
+      if (!DoStore(key, shared_value, false))
+        return false;
+      promise->set_value();
+    } catch (...) {
+      promise->set_exception(std::current_exception());
+    }
+    return true;
+  });
+  return promise->get_future();
+}
+
+void DataBuffer::GetAsync(AsioService& asio_service, const KeyType& key, GetHandler handler) {
+  StartAsync(asio_service, [this, key, handler]() -> bool {
+    std::error_code error;
+    SharedValue value;
+    try {
+      if (!DoGet(key, false, value))
+        return false;
+    } catch (const std::system_error& e) {
+      error = e.code();
+    } catch (const std::exception& e) {
+      LOG(kError) << boost::diagnostic_information(e);
+      error = make_error_code(CommonErrors::unknown);
+    }
+    handler(error, value ? *value : NonEmptyString());
+    return true;
+  });
+}
+
+std::future<NonEmptyString> DataBuffer::GetAsync(AsioService& asio_service, const KeyType& key) {
+  auto promise(std::make_shared<std::promise<NonEmptyString>>());
+  StartAsync(asio_service, [this, key, promise]() -> bool {
+    try {
+      SharedValue value;
+      if (!DoGet(key, false, value))
+        return false;
+      promise->set_value(*value);
+    } catch (...) {
+      promise->set_exception(std::current_exception());
+    }
+    return true;
+  });
+  return promise->get_future();
+}
+
+void DataBuffer::DeleteAsync(AsioService& asio_service, const KeyType& key,
+                             DeleteHandler handler) {
+  StartAsync(asio_service, [this, key, handler]() -> bool {
+    std::error_code error;
+    try {
+      Delete(key);
+    } catch (const std::system_error& e) {
+      error = e.code();
+    } catch (const std::exception& e) {
+      LOG(kError) << boost::diagnostic_information(e);
+      error = make_error_code(CommonErrors::unknown);
+    }
+    handler(error);
+    return true;
+  });
+}
+
+std::future<void> DataBuffer::DeleteAsync(AsioService& asio_service, const KeyType& key) {
+  auto promise(std::make_shared<std::promise<void>>());
+  StartAsync(asio_service, [this, key, promise]() -> bool {
+    try {
+      Delete(key);
+      promise->set_value();
+    } catch (...) {
+      promise->set_exception(std::current_exception());
+    }
+    return true;
+  });
+  return promise->get_future();
+}
+
+void DataBuffer::StartAsync(AsioService& asio_service, std::function<bool()> attempt) {
+  ++async_operation_count_;
+  PostAttempt(asio_service, std::move(attempt));
+}
+
+void DataBuffer::PostAttempt(AsioService& asio_service, std::function<bool()> attempt) {
+  asio_service.service().post([this, &asio_service, attempt] {
+    uint64_t generation(0);
+    {
+      std::lock_guard<std::mutex> async_lock(async_mutex_);
+      generation = async_generation_;
+    }
+    bool completed(attempt());
+    std::unique_lock<std::mutex> async_lock(async_mutex_);
+    if (completed) {
+      if (--async_operation_count_ == 0)
+        async_cond_var_.notify_all();
+    } else if (generation != async_generation_) {
+      async_lock.unlock();
+      PostAttempt(asio_service, attempt);
     } else {
-      // Assume it's on disk so as to invoke a DeleteFromDisk
-      also_on_disk = StoringState::kCompleted;
+      async_waiters_.emplace_back(&asio_service, attempt);
     }
+  });
+}
+
+void DataBuffer::RetryAsyncWaiters() {
+  if (async_operation_count_ == 0)
+    return;
+  std::vector<AsyncWaiter> waiters;
+  {
+    std::lock_guard<std::mutex> async_lock(async_mutex_);
+    ++async_generation_;
+    waiters.swap(async_waiters_);
+  }
+  for (auto& waiter : waiters)
+    PostAttempt(*waiter.asio_service, std::move(waiter.attempt));
+}
+
+DataBuffer::MemoryIndex::iterator DataBuffer::EraseFromMemory(MemoryIndex::iterator itr) {
+  if ((*itr).also_on_disk == StoringState::kNotStarted) {
+    copy_backlog_.bytes -= (*itr).value->string().size();
+    --copy_backlog_.entries;
+  }
+  if (itr == oldest_memory_only_)
+    ++oldest_memory_only_;
+  return memory_store_.index.erase(itr);
+}
+
+void DataBuffer::DeleteFromMemory(const KeyType& key, StoringState& also_on_disk) {
+  bool changed(false);
+  {
+    std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
+    if (kEvictionPolicy_ != EvictionPolicy::kFifo)
+      keys_being_deleted_.insert(key);
+    changed = EraseKeyFromMemory(key, also_on_disk);
   }
   if (changed)
-    memory_store_.cond_var.notify_all();
+    NotifyWaiters(memory_store_);
 }
 
 void DataBuffer::DeleteFromDisk(const KeyType& key) {
   {
     std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex);
-    auto itr(Find(disk_store_, key));
-    if (itr == disk_store_.index.end()) {
+    if (!EraseKeyFromDisk(key)) {
       LOG(kWarning) << DebugKeyName(key) << " is not in the disk index.";
       BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
     }
+  }
+  NotifyWaiters(disk_store_);
+}
 
-    if ((*itr).state == StoringState::kStarted) {
-      (*itr).state = StoringState::kCancelled;
-    } else if ((*itr).state == StoringState::kCompleted) {
-      RemoveFile(itr->key, nullptr);
-      disk_store_.index.erase(itr);
-    }
+bool DataBuffer::EraseKeyFromMemory(const KeyType& key, StoringState& also_on_disk) {
+  auto itr(Find(memory_store_, key));
+  if (itr == memory_store_.index.end()) {
+    // Assume it's on disk so as to invoke a DeleteFromDisk
+    also_on_disk = StoringState::kCompleted;
+    return false;
+  }
+  also_on_disk = (*itr).also_on_disk;
+  memory_store_.current.data -= (*itr).value->string().size();
+  EraseFromMemory(itr);
+  return true;
+}
+
+bool DataBuffer::EraseKeyFromDisk(const KeyType& key) {
+  auto itr(Find(disk_store_, key));
+  if (itr == disk_store_.index.end())
+    return false;
+  if ((*itr).state == StoringState::kStarted) {
+    (*itr).state = StoringState::kCancelled;
+  } else if ((*itr).state == StoringState::kCompleted) {
+    RemoveFile(itr->key, nullptr);
+    disk_store_.index.erase(itr);
+  }
+  return true;
+}
+
+bool DataBuffer::WriteToDisk(const KeyType& key, const NonEmptyString& value) {
+  if (!segment_log_)
+    return WriteFile(GetFilename(key), value.string());
+  try {
+    segment_log_->Put(key, value);
+  } catch (const std::exception& e) {
+    LOG(kError) << boost::diagnostic_information(e);
+    return false;
   }
-  disk_store_.cond_var.notify_all();
+  return true;
+}
+
+NonEmptyString DataBuffer::ReadFromDisk(const KeyType& key) {
+  if (segment_log_)
+    return segment_log_->Get(key);
+  auto result(ReadFile(GetFilename(key)));
+  if (result)
+    return NonEmptyString(*result);
+  else
+    BOOST_THROW_EXCEPTION(result.error());
 }
 
 void DataBuffer::RemoveFile(const KeyType& key, NonEmptyString* value) {
+  if (segment_log_) {
+    disk_store_.current.data -= segment_log_->Remove(key, value);
+    return;
+  }
   auto path(GetFilename(key));
   boost::system::error_code error_code;
   uint64_t size(fs::file_size(path, error_code));
@@ -363,8 +1038,7 @@ void DataBuffer::RemoveFile(const KeyType& key, NonEmptyString* value) {
 }
 
 void DataBuffer::CopyQueueToDisk() {
-  KeyType key;
-  NonEmptyString value;
+  std::vector<std::pair<KeyType, SharedValue>> batch;
   for (;;) {
     {
       // Get oldest value not yet stored to disk
@@ -373,25 +1047,173 @@ void DataBuffer::CopyQueueToDisk() {
 
       memory_store_.cond_var.wait(memory_store_lock, [this, &itr]() -> bool {
         itr = FindOldestInMemoryOnly();
-        return itr != memory_store_.index.end() || !running_;
+        return itr != memory_store_.index.end() || !queued_promotions_.empty() || !running_;
       });
       if (!running_)
         return;
 
-      assert(itr != memory_store_.index.end());
-      key = (*itr).key;
-      value = (*itr).value;
-      (*itr).also_on_disk = StoringState::kStarted;
-      std::unique_lock<std::mutex> disk_store_lock(disk_store_.mutex);
-      memory_store_lock.unlock();
-      StoreOnDisk(key, value, std::move(disk_store_lock));
-      memory_store_lock.lock();
-      itr = Find(memory_store_, key);
-      if (itr != memory_store_.index.end())
-        (*itr).also_on_disk = StoringState::kCompleted;
+      if (!queued_promotions_.empty()) {
+        // Promotions only touch memory and the disk index, so are handled ahead of copying to disk.
+        PromoteQueuedValues();
+        itr = FindOldestInMemoryOnly();
+      }
+
+      if (itr != memory_store_.index.end()) {
+        // Take a batch of consecutive values, limited so that memory isn't held up for too long
+        // waiting for the whole batch to be written.
+        batch.clear();
+        uint64_t batch_size(0);
+        while (itr != memory_store_.index.end() && batch.size() < kMaxCopyBatchSize_ &&
+               (batch.empty() || batch_size < memory_store_.max / 4)) {
+          batch.emplace_back((*itr).key, (*itr).value);
+          batch_size += (*itr).value->string().size();
+          (*itr).also_on_disk = StoringState::kStarted;
+          ++itr;
+        }
+        oldest_memory_only_ = itr;
+        copy_backlog_.bytes -= batch_size;
+        copy_backlog_.entries -= batch.size();
+        std::unique_lock<std::mutex> disk_store_lock(disk_store_.mutex);
+        for (const auto& key_value : batch) {
+          ThrowIfTooLargeForDisk(key_value.first, key_value.second->string().size());
+          disk_store_.index.emplace_back(key_value.first);
+        }
+        memory_store_lock.unlock();
+        for (const auto& key_value : batch) {
+          WriteValueToDisk(key_value.first, key_value.second, disk_store_lock);
+          if (!running_)
+            break;
+        }
+        disk_store_lock.unlock();
+        NotifyWaiters(disk_store_);
+        memory_store_lock.lock();
+        for (const auto& key_value : batch) {
+          itr = memory_store_.index.find(key_value.first, [](const MemoryElement& element) {
+            return element.also_on_disk == StoringState::kStarted;
+          });
+          if (itr != memory_store_.index.end())
+            (*itr).also_on_disk = StoringState::kCompleted;
+        }
+      }
+    }
+    NotifyWaiters(memory_store_);
+  }
+}
+
+void DataBuffer::RecordAccess(const KeyType& key) {
+  if (kEvictionPolicy_ == EvictionPolicy::kTinyLfu)
+    frequency_sketch_.Increment(kKeyHash_(key));
+}
+
+void DataBuffer::QueuePromotions(std::vector<QueuedPromotion> promotions) {
+  if (promotions.empty())
+    return;
+  {
+    std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
+    for (auto& promotion : promotions) {
+      RecordAccess(promotion.key);
+      // There's no point queueing more than could fit in memory.
+      uint64_t size(promotion.value->string().size());
+      if (queued_promotions_size_ + size > memory_store_.max)
+        continue;
+      queued_promotions_size_ += size;
+      queued_promotions_.push_back(std::move(promotion));
+    }
+  }
+  NotifyWaiters(memory_store_);
+}
+
+void DataBuffer::PromoteQueuedValues() {
+  std::vector<QueuedPromotion> promotions;
+  promotions.swap(queued_promotions_);
+  queued_promotions_size_ = 0;
+  std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex);
+  for (auto& promotion : promotions)
+    PromoteToMemory(promotion);
+}
+
+void DataBuffer::PromoteToMemory(QueuedPromotion& promotion) {
+  const KeyType& key(promotion.key);
+  if (Find(memory_store_, key) != memory_store_.index.end() || keys_being_deleted_.count(key) != 0)
+    return;
+  // The value was read by Get; only promote it if that disk entry hasn't since been replaced.
+  auto disk_itr(Find(disk_store_, key));
+  if (disk_itr == disk_store_.index.end() || (*disk_itr).state != StoringState::kCompleted ||
+      disk_store_.index.sequence_number(disk_itr) != promotion.disk_sequence_number) {
+    return;
+  }
+  uint64_t required_space(promotion.value->string().size());
+  if (required_space > memory_store_.max)
+    return;
+
+  // Make space by removing values which have already been copied to disk, in eviction order.
+  // Unlike Store, this never blocks: if there isn't enough space (or the policy rejects it), the
+  // value just stays on disk.
+  while (!HasSpace(memory_store_, required_space)) {
+    auto victim(std::find_if(memory_store_.index.begin(), oldest_memory_only_,
+                             [](const MemoryElement& key_value) {
+      return key_value.also_on_disk == StoringState::kCompleted;
+    }));
+    if (victim == oldest_memory_only_)
+      return;
+    if (kEvictionPolicy_ == EvictionPolicy::kTinyLfu &&
+        frequency_sketch_.Estimate(kKeyHash_(key)) <=
+            frequency_sketch_.Estimate(kKeyHash_((*victim).key))) {
+      return;
     }
-    memory_store_.cond_var.notify_all();
+    memory_store_.current.data -= (*victim).value->string().size();
+    EraseFromMemory(victim);
+    Count(counters_.memory_evictions);
   }
+
+  memory_store_.current.data += required_space;
+  auto itr(memory_store_.index.emplace(oldest_memory_only_, key, std::move(promotion.value)));
+  (*itr).also_on_disk = StoringState::kCompleted;
+  Count(counters_.promotions);
+}
+
+DataBuffer::Statistics DataBuffer::Stats() {
+  Statistics stats;
+  {
+    std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
+    stats.memory.bytes = memory_store_.current.data;
+    stats.memory.entries = memory_store_.index.size();
+    stats.copy_backlog = copy_backlog_;
+  }
+  {
+    std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex);
+    stats.disk.bytes = disk_store_.current.data;
+    stats.disk.entries = disk_store_.index.size();
+  }
+  auto load([](const std::atomic<uint64_t>& counter) {
+    return counter.load(std::memory_order_relaxed);
+  });
+  stats.stores = load(counters_.stores);
+  stats.memory_hits = load(counters_.memory_hits);
+  stats.disk_hits = load(counters_.disk_hits);
+  stats.misses = load(counters_.misses);
+  stats.deletes = load(counters_.deletes);
+  stats.spills = load(counters_.spills);
+  stats.spilled_bytes = load(counters_.spilled_bytes);
+  stats.pops = load(counters_.pops);
+  stats.popped_bytes = load(counters_.popped_bytes);
+  stats.memory_evictions = load(counters_.memory_evictions);
+  stats.promotions = load(counters_.promotions);
+  stats.memory_wait_time = std::chrono::nanoseconds(load(counters_.memory_wait_nanoseconds));
+  stats.disk_wait_time = std::chrono::nanoseconds(load(counters_.disk_wait_nanoseconds));
+  stats.store_latency = counters_.store_latency.GetSnapshot();
+  stats.get_latency = counters_.get_latency.GetSnapshot();
+  stats.spill_latency = counters_.spill_latency.GetSnapshot();
+  return stats;
+}
+
+void DataBuffer::Count(std::atomic<uint64_t>& counter, uint64_t amount) {
+  counter.fetch_add(amount, std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds DataBuffer::Since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                              start);
 }
 
 void DataBuffer::CheckWorkerIsStillRunning() {
@@ -409,8 +1231,8 @@ void DataBuffer::CheckWorkerIsStillRunning() {
 
 void DataBuffer::StopRunning() {
   running_ = false;
-  memory_store_.cond_var.notify_all();
-  disk_store_.cond_var.notify_all();
+  NotifyWaiters(memory_store_);
+  NotifyWaiters(disk_store_);
 }
 
 fs::path DataBuffer::GetFilename(const KeyType& key) const {
@@ -426,7 +1248,7 @@ void DataBuffer::SetMaxMemoryUsage(MemoryUsage max_memory_usage) {
     }
     memory_store_.max = max_memory_usage;
   }
-  memory_store_.cond_var.notify_all();
+  NotifyWaiters(memory_store_);
 }
 
 void DataBuffer::SetMaxDiskUsage(DiskUsage max_disk_usage) {
@@ -441,7 +1263,13 @@ void DataBuffer::SetMaxDiskUsage(DiskUsage max_disk_usage) {
     disk_store_.max = max_disk_usage;
   }
   if (increased)
-    disk_store_.cond_var.notify_all();
+    NotifyWaiters(disk_store_);
+}
+
+template <typename T>
+void DataBuffer::NotifyWaiters(T& store) {
+  store.cond_var.notify_all();
+  RetryAsyncWaiters();
 }
 
 template <typename T>
@@ -452,36 +1280,38 @@ bool DataBuffer::HasSpace(const T& store, uint64_t required_space) const {
 
 template <typename T>
 typename T::index_type::iterator DataBuffer::Find(T& store, const KeyType& key) {
-  return std::find_if(
-      store.index.begin(), store.index.end(),
-      [&key](const typename T::index_type::value_type& key_value) { return key_value.key == key; });
+  return store.index.find(key);
 }
 
 DataBuffer::MemoryIndex::iterator DataBuffer::FindOldestInMemoryOnly() {
-  return std::find_if(memory_store_.index.begin(), memory_store_.index.end(),
-                      [](const MemoryElement& key_value) {
-    return key_value.also_on_disk == StoringState::kNotStarted;
-  });
+  return oldest_memory_only_;
 }
 
 DataBuffer::MemoryIndex::iterator DataBuffer::FindMemoryRemovalCandidate(
-    uint64_t required_space, std::unique_lock<std::mutex>& memory_store_lock) {
+    uint64_t required_space, std::unique_lock<std::mutex>& memory_store_lock, bool wait) {
   auto itr(memory_store_.index.end());
-  memory_store_.cond_var.wait(memory_store_lock, [this, &itr, &required_space]() -> bool {
-    itr = std::find_if(memory_store_.index.begin(), memory_store_.index.end(),
+  auto found([this, &itr, &required_space]() -> bool {
+    // Only elements older than 'oldest_memory_only_' can have been copied to disk, and of those
+    // only the worker's current batch can still be being copied, so this search is bounded by
+    // kMaxCopyBatchSize_ + 1 elements.
+    itr = std::find_if(memory_store_.index.begin(), oldest_memory_only_,
                        [](const MemoryElement& key_value) {
       return key_value.also_on_disk == StoringState::kCompleted;
     });
+    if (itr == oldest_memory_only_)
+      itr = memory_store_.index.end();
     return itr != memory_store_.index.end() || HasSpace(memory_store_, required_space) || !running_;
   });
+  if (wait)
+    memory_store_.cond_var.wait(memory_store_lock, found);
+  else
+    found();
   return itr;
 }
 
 DataBuffer::DiskIndex::iterator DataBuffer::FindStartedToStoreOnDisk(const KeyType& key) {
-  return std::find_if(disk_store_.index.begin(), disk_store_.index.end(),
-                      [&key](const DiskElement& entry) {
-    return entry.state == StoringState::kStarted && entry.key == key;
-  });
+  return disk_store_.index.find(
+      key, [](const DiskElement& entry) { return entry.state == StoringState::kStarted; });
 }
 
 DataBuffer::DiskIndex::iterator DataBuffer::FindOldestOnDisk() { return disk_store_.index.begin(); }
@@ -489,6 +1319,7 @@ DataBuffer::DiskIndex::iterator DataBuffer::FindOldestOnDisk() { return disk_sto
 DataBuffer::DiskIndex::iterator DataBuffer::FindAndThrowIfCancelled(const KeyType& key) {
   auto itr(Find(disk_store_, key));
   if (itr == disk_store_.index.end() || (*itr).state == StoringState::kCancelled) {
+    Count(counters_.misses);
     LOG(kWarning) << DebugKeyName(key) << " is not in the disk index or is cancelled.";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
   }
@@ -497,4 +1328,10 @@ DataBuffer::DiskIndex::iterator DataBuffer::FindAndThrowIfCancelled(const KeyTyp
 
 std::string DataBuffer::DebugKeyName(const KeyType& key) { return hex::Encode(key.name); }
 
+std::size_t DataBuffer::KeyHash::operator()(const KeyType& key) const {
+  if (!key.name.IsInitialised())
+    return static_cast<std::size_t>(hash(key.type_id.data));
+  return static_cast<std::size_t>(hash(key.name.string(), key.type_id.data));
+}
+
 }  // namespace maidsafe
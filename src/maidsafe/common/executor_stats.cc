@@ -0,0 +1,113 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/executor_stats.h"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+ExecutorStats::ExecutorStats(std::string name)
+    : kName_(std::move(name)),
+      queued_(0),
+      completed_(0),
+      max_backlog_(0),
+      queue_wait_(),
+      run_time_() {}
+
+ExecutorStats::Clock::time_point ExecutorStats::Queued() {
+  const std::uint64_t queued(queued_.fetch_add(1, std::memory_order_relaxed) + 1);
+  // Handlers queued by other threads after this one may already have completed, so 'completed'
+  // can exceed 'queued'.
+  const std::uint64_t completed(completed_.load(std::memory_order_relaxed));
+  const std::uint64_t backlog(queued > completed ? queued - completed : 0);
+  std::uint64_t max_backlog(max_backlog_.load(std::memory_order_relaxed));
+  while (backlog > max_backlog &&
+         !max_backlog_.compare_exchange_weak(max_backlog, backlog, std::memory_order_relaxed)) {
+  }
+  return Clock::now();
+}
+
+ExecutorStats::Clock::time_point ExecutorStats::Started(Clock::time_point queued_time) {
+  const Clock::time_point start_time(Clock::now());
+  queue_wait_.Record(start_time - queued_time);
+  return start_time;
+}
+
+void ExecutorStats::Finished(Clock::time_point start_time) {
+  run_time_.Record(Clock::now() - start_time);
+  completed_.fetch_add(1, std::memory_order_release);
+}
+
+ExecutorStats::Snapshot ExecutorStats::GetSnapshot() const {
+  Snapshot snapshot;
+  snapshot.name = kName_;
+  // Read 'completed_' first, with acquire pairing with the release in Finished, so that every
+  // handler counted as completed is also counted as queued and the backlog can't appear negative.
+  snapshot.completed = completed_.load(std::memory_order_acquire);
+  snapshot.queued = queued_.load(std::memory_order_relaxed);
+  snapshot.backlog = snapshot.queued - snapshot.completed;
+  snapshot.max_backlog = max_backlog_.load(std::memory_order_relaxed);
+  snapshot.queue_wait = queue_wait_.GetSnapshot();
+  snapshot.run_time = run_time_.GetSnapshot();
+  return snapshot;
+}
+
+std::ostream& operator<<(std::ostream& stream, const ExecutorStats::Snapshot& snapshot) {
+  using std::chrono::microseconds;
+  using std::chrono::duration_cast;
+  const auto summarise = [&stream](const LatencyHistogram::Snapshot& histogram) {
+    stream << "mean " << duration_cast<microseconds>(histogram.Mean()).count() << " us, p99 "
+           << duration_cast<microseconds>(histogram.Percentile(99)).count() << " us, max "
+           << duration_cast<microseconds>(histogram.max).count() << " us";
+  };
+  stream << snapshot.name << ": " << snapshot.queued << " queued, " << snapshot.completed
+         << " completed, backlog " << snapshot.backlog << " (max " << snapshot.max_backlog
+         << "), queue wait ";
+  summarise(snapshot.queue_wait);
+  stream << ", run time ";
+  summarise(snapshot.run_time);
+  return stream;
+}
+
+namespace {
+
+std::chrono::steady_clock::duration CheckedReportingInterval(
+    std::chrono::steady_clock::duration interval) {
+  if (interval <= std::chrono::steady_clock::duration::zero()) {
+    LOG(kError) << "Reporting interval must be positive.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  return interval;
+}
+
+}  // unnamed namespace
+
+ExecutorStatsReporter::ExecutorStatsReporter(
+    std::vector<std::shared_ptr<const ExecutorStats>> stats,
+    std::chrono::steady_clock::duration interval)
+    : kStats_(std::move(stats)),
+      periodic_thread_([this] { Report(); }, CheckedReportingInterval(interval)) {}
+
+void ExecutorStatsReporter::Report() const {
+  for (const auto& stats : kStats_)
+    LOG(kInfo) << stats->GetSnapshot();
+}
+
+}  // namespace maidsafe
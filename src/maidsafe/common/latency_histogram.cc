@@ -0,0 +1,127 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace maidsafe {
+
+namespace {
+
+// Each power of two is split into 2^kSubBucketBits buckets.
+const unsigned kSubBucketBits(3);
+const std::uint64_t kSubBucketCount(1 << kSubBucketBits);
+
+unsigned MostSignificantBit(std::uint64_t value) {
+  unsigned bit(0);
+  for (unsigned step(32); step != 0; step /= 2) {
+    if (value >> step) {
+      value >>= step;
+      bit += step;
+    }
+  }
+  return bit;
+}
+
+}  // unnamed namespace
+
+const std::size_t LatencyHistogram::kBucketCount;
+
+LatencyHistogram::Duration LatencyHistogram::Snapshot::Percentile(double percentile) const {
+  if (count == 0)
+    return Duration(0);
+  const std::uint64_t rank(static_cast<std::uint64_t>(
+      std::ceil(std::min(std::max(percentile, 0.0), 100.0) / 100.0 * count)));
+  std::uint64_t cumulative(0);
+  for (std::size_t i(0); i != bucket_counts.size(); ++i) {
+    cumulative += bucket_counts[i];
+    if (cumulative >= std::max<std::uint64_t>(rank, 1))
+      return std::min(BucketUpperBound(i), max);
+  }
+  return max;
+}
+
+LatencyHistogram::Duration LatencyHistogram::Snapshot::Mean() const {
+  return count == 0 ? Duration(0) : total / static_cast<Duration::rep>(count);
+}
+
+void LatencyHistogram::Snapshot::Merge(const Snapshot& other) {
+  if (bucket_counts.size() < other.bucket_counts.size())
+    bucket_counts.resize(other.bucket_counts.size(), 0);
+  for (std::size_t i(0); i != other.bucket_counts.size(); ++i)
+    bucket_counts[i] += other.bucket_counts[i];
+  count += other.count;
+  total += other.total;
+  max = std::max(max, other.max);
+}
+
+LatencyHistogram::LatencyHistogram() : buckets_(), total_(0), max_(0) {
+  for (auto& bucket : buckets_)
+    bucket.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Record(Duration duration) {
+  const std::uint64_t nanoseconds(duration.count() < 0 ? 0 : duration.count());
+  buckets_[BucketIndex(duration)].fetch_add(1, std::memory_order_relaxed);
+  total_.fetch_add(nanoseconds, std::memory_order_relaxed);
+  std::uint64_t max(max_.load(std::memory_order_relaxed));
+  while (nanoseconds > max &&
+         !max_.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {
+  }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::GetSnapshot() const {
+  Snapshot snapshot;
+  snapshot.bucket_counts.reserve(kBucketCount);
+  for (const auto& bucket : buckets_) {
+    snapshot.bucket_counts.push_back(bucket.load(std::memory_order_relaxed));
+    snapshot.count += snapshot.bucket_counts.back();
+  }
+  snapshot.total = Duration(total_.load(std::memory_order_relaxed));
+  snapshot.max = Duration(max_.load(std::memory_order_relaxed));
+  return snapshot;
+}
+
+LatencyHistogram::Duration LatencyHistogram::BucketLowerBound(std::size_t index) {
+  if (index < kSubBucketCount)
+    return Duration(index);
+  const unsigned shift(static_cast<unsigned>(index / kSubBucketCount) - 1);
+  return Duration((kSubBucketCount + index % kSubBucketCount) << shift);
+}
+
+LatencyHistogram::Duration LatencyHistogram::BucketUpperBound(std::size_t index) {
+  if (index < kSubBucketCount)
+    return Duration(index);
+  const unsigned shift(static_cast<unsigned>(index / kSubBucketCount) - 1);
+  // The last bucket's upper bound is Duration::max(), so this doesn't overflow.
+  return Duration(((kSubBucketCount + index % kSubBucketCount) << shift) +
+                  ((std::uint64_t(1) << shift) - 1));
+}
+
+std::size_t LatencyHistogram::BucketIndex(Duration duration) {
+  if (duration.count() < static_cast<Duration::rep>(kSubBucketCount))
+    return duration.count() < 0 ? 0 : static_cast<std::size_t>(duration.count());
+  const std::uint64_t nanoseconds(duration.count());
+  const unsigned shift(MostSignificantBit(nanoseconds) - kSubBucketBits);
+  return static_cast<std::size_t>((shift + 1) * kSubBucketCount +
+                                  ((nanoseconds >> shift) & (kSubBucketCount - 1)));
+}
+
+}  // namespace maidsafe
@@ -76,6 +76,12 @@ maidsafe::detail::Spinlock& g_console_mutex() {
   return mutex;
 }
 
+// Per thread which logs while the binary backend is running.
+const std::size_t kBinaryLogRingCapacity(1 << 16);
+
+// Per log file, unless 'log_flush_interval' is 0.
+const std::size_t kLogFileBufferSize(1 << 16);
+
 const std::array<std::string, 11> kProjects = {{"api", "common", "crux", "drive", "encrypt",
                                                 "launcher", "nfs", "passport", "routing", "vault",
                                                 "vault_manager"}};
@@ -216,15 +222,52 @@ void GetColourAndLevel(char& log_level, Colour& colour, int level) {
   }
 }
 
-std::string GetColouredLogEntry(char log_level) {
+enum class TimeType { kLocal, kUTC };
+
+template <TimeType time_type>
+std::string Strftime(const std::time_t* now_t);
+
+template <>
+std::string Strftime<TimeType::kLocal>(const std::time_t* now_t) {
+  std::lock_guard<maidsafe::detail::Spinlock> lock(g_console_mutex());
+  char temp[10];
+  if (!std::strftime(temp, sizeof(temp), "%H:%M:%S.", std::localtime(now_t)))  // NOLINT (Fraser)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unknown));
+  return std::string{temp};
+}
+
+template <>
+std::string Strftime<TimeType::kUTC>(const std::time_t* now_t) {
+  std::lock_guard<maidsafe::detail::Spinlock> lock(g_console_mutex());
+  char temp[21];
+  if (!std::strftime(temp, sizeof(temp), "%Y-%m-%d %H:%M:%S.",
+                     std::gmtime(now_t)))  // NOLINT (Fraser)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unknown));
+  return std::string{temp};
+}
+
+template <TimeType time_type>
+std::string GetTime(std::chrono::system_clock::time_point now) {
+  auto seconds_since_epoch(
+      std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()));
+
+  std::time_t now_t(std::chrono::system_clock::to_time_t(
+      std::chrono::system_clock::time_point(seconds_since_epoch)));
+
+  return Strftime<time_type>(&now_t) +
+         std::to_string((now.time_since_epoch() - seconds_since_epoch).count());
+}
+
+std::string GetColouredLogEntry(char log_level, std::thread::id thread_id,
+                                std::chrono::system_clock::time_point time) {
   std::ostringstream oss;
-  oss << log_level << " " << std::this_thread::get_id();
+  oss << log_level << " " << thread_id;
 #ifdef MAIDSAFE_WIN32
   oss << '\t';
 #else
   oss << ' ';
 #endif
-  oss << detail::GetUTCTime();
+  oss << GetTime<TimeType::kUTC>(time);
   return oss.str();
 }
 
@@ -275,9 +318,25 @@ void SendToConsole(ColourMode colour_mode, Colour colour, int level,
   fflush(stdout);
 }
 
+void Print(ColourMode colour_mode, Colour colour, int level, const std::string& project,
+           const std::string& coloured_log_entry, const std::string& message) {
+  SendToConsole(colour_mode, colour, level, coloured_log_entry, message);
+  Logging::Instance().WriteToCombinedLogfile(coloured_log_entry + message, level);
+  Logging::Instance().WriteToProjectLogfile(project, coloured_log_entry + message, level);
+}
+
+void PrintBinaryLogEntry(const detail::BinaryLogEntry& entry) {
+  char log_level(' ');
+  Colour colour(Colour::kDefaultColour);
+  GetColourAndLevel(log_level, colour, entry.level);
+  Print(Logging::Instance().Colour(), colour, entry.level, entry.project,
+        GetColouredLogEntry(log_level, entry.thread_id, entry.time), entry.message);
+}
+
 po::options_description SetProgramOptions(std::string& config_file, bool& no_log_to_console,
                                           std::string& log_folder, bool& no_async,
-                                          int& colour_mode) {
+                                          int& colour_mode, int& executor_stats_interval,
+                                          bool& binary, bool& binary_block) {
 #ifdef __ANDROID__
   fs::path inipath;
   fs::path logpath;
@@ -295,7 +354,25 @@ po::options_description SetProgramOptions(std::string& config_file, bool& no_log
       "log_folder", po::value<std::string>(&log_folder)->default_value(logpath.string().c_str()),
       "Path to folder where log files will be written. If empty, no files will be written.")(
       "log_no_console", po::bool_switch(&no_log_to_console),
-      "Disable logging to console.")("help,h", "Show help message.");
+      "Disable logging to console.")(
+      "log_executor_stats", po::value<int>(&executor_stats_interval)->default_value(0),
+      "Interval in seconds at which to log the queueing statistics of the asynchronous logging "
+      "thread.  0 disables them.")(
+      "log_binary", po::bool_switch(&binary),
+      "Format log messages on the logging thread from per-thread buffers, rather than on the "
+      "thread logging them.  Ignored if asynchronous logging is disabled.")(
+      "log_binary_block", po::bool_switch(&binary_block),
+      "With log_binary, wait for space rather than dropping messages when a thread's buffer is "
+      "full.")(
+      "log_flush_interval", po::value<int>()->default_value(1000),
+      "Interval in milliseconds at which buffered messages are written to the log files.  Errors "
+      "are always written immediately.  0 writes every message immediately.")(
+      "log_max_file_size", po::value<int>()->default_value(0),
+      "Size in MB at which a log file is renamed and a new one started.  0 disables rotation.")(
+      "log_max_rotated_files", po::value<int>()->default_value(0),
+      "Number of rotated files to keep for each log file.  0 keeps them all.")(
+      "log_compress_rotated", po::bool_switch(), "Gzip rotated log files.")(
+      "help,h", "Show help message.");
   for (auto project : kProjects) {
     std::string description("Set log level for ");
     description += std::string(project) + " project.";
@@ -391,76 +468,51 @@ bool SetupLogFolder(const fs::path& log_folder) {
   return true;
 }
 
-enum class TimeType { kLocal, kUTC };
-
-template <TimeType time_type>
-std::string Strftime(const std::time_t* now_t);
-
-template <>
-std::string Strftime<TimeType::kLocal>(const std::time_t* now_t) {
-  std::lock_guard<maidsafe::detail::Spinlock> lock(g_console_mutex());
-  char temp[10];
-  if (!std::strftime(temp, sizeof(temp), "%H:%M:%S.", std::localtime(now_t)))  // NOLINT (Fraser)
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unknown));
-  return std::string{temp};
-}
-
-template <>
-std::string Strftime<TimeType::kUTC>(const std::time_t* now_t) {
-  std::lock_guard<maidsafe::detail::Spinlock> lock(g_console_mutex());
-  char temp[21];
-  if (!std::strftime(temp, sizeof(temp), "%Y-%m-%d %H:%M:%S.",
-                     std::gmtime(now_t)))  // NOLINT (Fraser)
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unknown));
-  return std::string{temp};
-}
-
-template <TimeType time_type>
-std::string GetTime() {
-  auto now(std::chrono::system_clock::now());
-  auto seconds_since_epoch(
-      std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()));
-
-  std::time_t now_t(std::chrono::system_clock::to_time_t(
-      std::chrono::system_clock::time_point(seconds_since_epoch)));
-
-  return Strftime<time_type>(&now_t) +
-         std::to_string((now.time_since_epoch() - seconds_since_epoch).count());
-}
-
 }  // unnamed namespace
 
 namespace detail {
 
-// ======================================= LogMessage ==============================================
-boost::optional<LogMessage::FileInfo> LogMessage::ShouldLog() const {
-  auto file_info(GetProjectAndContractFile(file_));
+std::atomic<BinaryLog*> g_binary_log(nullptr);
 
-  const FilterMap filter(Logging::Instance().Filter());
-  if (file_info.first.empty()) {
-    file_info.first = "common";
-  }
+std::atomic<std::uint32_t> g_filter_generation(1);
 
-  // With C++14, the map can be searched without a temp string
-  const std::string project(file_info.first.begin(), file_info.first.end());
-
-  const auto filter_itr = filter.find(project);
-
-  if (filter_itr != filter.end()) {
-    if ((*filter_itr).second <= level_) {
-      const auto fix_slashes(file_info.second | boost::adaptors::replaced('\\', '/'));
-      return FileInfo{std::move(project), std::string(fix_slashes.begin(), fix_slashes.end())};
-    }
-  }
-  return boost::none;
+// ===================================== CallSiteFilter ============================================
+bool CallSiteFilter::Update(const char* file, int level) {
+  // Read the generation before the filter, so that a concurrent change invalidates this decision.
+  const std::uint32_t generation(g_filter_generation.load(std::memory_order_acquire));
+  const boost::string_ref project_ref(GetProjectAndContractFile(file).first);
+  const std::string project(project_ref.empty() ? std::string("common") : project_ref.to_string());
+  const FilterMap filter(Logging::Instance().Filter());
+  const auto filter_itr(filter.find(project));
+  const bool should_log(filter_itr != filter.end() && filter_itr->second <= level);
+  state_.store((generation << 1) | (should_log ? 1U : 0U), std::memory_order_relaxed);
+  return should_log;
+}
+
+// ====================================== CallSiteFile =============================================
+const CallSiteFile::Info& CallSiteFile::Get(const char* file) {
+  const Info* info(info_.load(std::memory_order_acquire));
+  if (info)
+    return *info;
+  const auto project_and_file(GetProjectAndContractFile(file));
+  const auto fix_slashes(project_and_file.second | boost::adaptors::replaced('\\', '/'));
+  std::unique_ptr<Info> new_info(new Info(
+      project_and_file.first.empty() ? std::string("common") : project_and_file.first.to_string(),
+      std::string(fix_slashes.begin(), fix_slashes.end())));
+  // If another thread got there first, use its copy.
+  if (info_.compare_exchange_strong(info, new_info.get(), std::memory_order_acq_rel))
+    return *new_info.release();
+  return *info;
 }
 
+// ======================================= LogMessage ==============================================
 void LogMessage::Log(const std::string& project, std::string message) const {
   char log_level(' ');
   Colour colour(Colour::kDefaultColour);
   const int level(level_);
   GetColourAndLevel(log_level, colour, level);
-  std::string coloured_log_entry(GetColouredLogEntry(log_level));
+  std::string coloured_log_entry(
+      GetColouredLogEntry(log_level, std::this_thread::get_id(), std::chrono::system_clock::now()));
   ColourMode colour_mode(Logging::Instance().Colour());
 #if defined(__GLIBCXX__)
   //  && __GLIBCXX__ < date (date in format of 20141218 as the date of fix of COW string)
@@ -468,15 +520,11 @@ void LogMessage::Log(const std::string& project, std::string message) const {
   auto coloured_log_entry_ptr(
       std::make_shared<std::string>(coloured_log_entry.data(), coloured_log_entry.size()));
   auto print_functor([level, colour, coloured_log_entry_ptr, message_ptr, colour_mode, project] {
-    SendToConsole(colour_mode, colour, level, *coloured_log_entry_ptr, *message_ptr);
-    Logging::Instance().WriteToCombinedLogfile(*coloured_log_entry_ptr + *message_ptr);
-    Logging::Instance().WriteToProjectLogfile(project, *coloured_log_entry_ptr + *message_ptr);
+    Print(colour_mode, colour, level, project, *coloured_log_entry_ptr, *message_ptr);
   });
 #else
   auto print_functor([level, colour, coloured_log_entry, message, colour_mode, project] {
-    SendToConsole(colour_mode, colour, level, coloured_log_entry, message);
-    Logging::Instance().WriteToCombinedLogfile(coloured_log_entry + message);
-    Logging::Instance().WriteToProjectLogfile(project, coloured_log_entry + message);
+    Print(colour_mode, colour, level, project, coloured_log_entry, message);
   });
 #endif
   Logging::Instance().Async() ? Logging::Instance().Send(print_functor) : print_functor();
@@ -528,12 +576,18 @@ Logging::Logging()
       combined_logfile_stream_(),
       project_logfile_streams_(),
       visualiser_(),
-      background_() {
+      log_file_compressor_(),
+      background_(),
+      background_stats_reporter_(),
+      binary_log_(),
+      log_file_flusher_() {
   // Force intialisation order to ensure g_console_mutex is available in Logging's destuctor.
   std::lock_guard<maidsafe::detail::Spinlock> lock(g_console_mutex());
   static_cast<void>(lock);
 }
 
+Logging::~Logging() { StopBinaryLog(); }
+
 Logging& Logging::Instance() {
   static Logging logging;
   return logging;
@@ -546,17 +600,23 @@ std::vector<std::vector<char>> Logging::Initialise(int argc, char** argv) {
   std::call_once(logging_initialised, [this, argc, argv, &unused_options]() {
     try {
       std::string config_file, log_folder;
-      int colour_mode(-1);
-      po::options_description log_config(
-          SetProgramOptions(config_file, no_log_to_console_, log_folder, no_async_, colour_mode));
+      int colour_mode(-1), executor_stats_interval(0);
+      bool binary(false), binary_block(false);
+      po::options_description log_config(SetProgramOptions(
+          config_file, no_log_to_console_, log_folder, no_async_, colour_mode,
+          executor_stats_interval, binary, binary_block));
       ParseProgramOptions(log_config, config_file, argc, argv, log_variables_, unused_options);
       if (IsHelpOption(log_config))
         return;
 #if USE_LOGGING
-      background_ = maidsafe::make_unique<Active>();
+      StartBackground(executor_stats_interval);
       DoCasts(colour_mode, log_folder, colour_mode_, log_folder_);
       HandleFilterOptions();
       SetStreams();
+      if (binary && !no_async_) {
+        StartBinaryLog(binary_block ? detail::BinaryLog::OverflowPolicy::kBlock
+                                    : detail::BinaryLog::OverflowPolicy::kDrop);
+      }
 #endif
     } catch (const std::exception& e) {
       std::cout << "Exception initialising logging: " << boost::diagnostic_information(e) << "\n\n";
@@ -572,17 +632,23 @@ std::vector<std::vector<wchar_t>> Logging::Initialise(int argc, wchar_t** argv)
   std::call_once(logging_initialised, [this, argc, argv, &unused_options]() {
     try {
       std::string config_file, log_folder;
-      int colour_mode(-1);
-      po::options_description log_config(
-          SetProgramOptions(config_file, no_log_to_console_, log_folder, no_async_, colour_mode));
+      int colour_mode(-1), executor_stats_interval(0);
+      bool binary(false), binary_block(false);
+      po::options_description log_config(SetProgramOptions(
+          config_file, no_log_to_console_, log_folder, no_async_, colour_mode,
+          executor_stats_interval, binary, binary_block));
       ParseProgramOptions(log_config, config_file, argc, argv, log_variables_, unused_options);
       if (IsHelpOption(log_config))
         return;
 #if USE_LOGGING
-      background_ = maidsafe::make_unique<Active>();
+      StartBackground(executor_stats_interval);
       DoCasts(colour_mode, log_folder, colour_mode_, log_folder_);
       HandleFilterOptions();
       SetStreams();
+      if (binary && !no_async_) {
+        StartBinaryLog(binary_block ? detail::BinaryLog::OverflowPolicy::kBlock
+                                    : detail::BinaryLog::OverflowPolicy::kDrop);
+      }
 #endif
     } catch (const std::exception& e) {
       std::cout << "Exception initialising logging: " << boost::diagnostic_information(e) << "\n\n";
@@ -602,7 +668,7 @@ void Logging::InitialiseVlog(const std::string& prefix, const std::string& sessi
     visualiser_.session_id = session_id;
     if (visualiser_.session_id.empty())
       LOG(kWarning) << "VLOG messages disabled since Vlog Session ID is empty.";
-    visualiser_.logfile.stream.open(GetLogfileName("visualiser").c_str(), std::ios_base::trunc);
+    visualiser_.logfile.Open(GetLogfileName("visualiser"), detail::LogFile::Options());
     visualiser_.server_name = server_name;
     visualiser_.server_port = server_port;
     visualiser_.server_dir = server_dir;
@@ -642,6 +708,12 @@ void Logging::HandleFilterOptions() {
     if (itr != log_variables_.end())
       filter_[project] = GetLogLevel((*itr).second.as<std::string>());
   }
+  detail::g_filter_generation.fetch_add(1, std::memory_order_release);
+}
+
+void Logging::SetFilter(FilterMap filter) {
+  filter_ = std::move(filter);
+  detail::g_filter_generation.fetch_add(1, std::memory_order_release);
 }
 
 fs::path Logging::GetLogfileName(const std::string& project) const {
@@ -656,16 +728,55 @@ void Logging::SetStreams() {
   if (log_folder_.empty() || !SetupLogFolder(log_folder_))
     return;
 
+  const int flush_interval(std::max(0, log_variables_["log_flush_interval"].as<int>()));
+  detail::LogFile::Options options;
+  options.buffer_size = flush_interval == 0 ? 0 : kLogFileBufferSize;
+  options.max_file_size =
+      static_cast<std::uint64_t>(std::max(0, log_variables_["log_max_file_size"].as<int>())) << 20;
+  options.max_rotated_files =
+      static_cast<unsigned>(std::max(0, log_variables_["log_max_rotated_files"].as<int>()));
+  if (options.max_file_size != 0 && log_variables_["log_compress_rotated"].as<bool>()) {
+    log_file_compressor_ = maidsafe::make_unique<Active>();
+    options.compressor = log_file_compressor_.get();
+  }
+
   for (auto& entry : filter_) {
-    auto log_file(make_unique<LogFile>());
-    log_file->stream.open(GetLogfileName(entry.first).c_str(), std::ios_base::trunc);
+    auto log_file(make_unique<detail::LogFile>());
+    log_file->Open(GetLogfileName(entry.first), options);
     project_logfile_streams_.insert(std::make_pair(entry.first, std::move(log_file)));
   }
 
-  if (filter_.size() != 1) {
-    std::lock_guard<std::mutex> lock(combined_logfile_stream_.mutex);
-    combined_logfile_stream_.stream.open(GetLogfileName("combined").c_str(), std::ios_base::trunc);
+  if (filter_.size() != 1)
+    combined_logfile_stream_.Open(GetLogfileName("combined"), options);
+
+  if (flush_interval != 0) {
+    log_file_flusher_ = maidsafe::make_unique<PeriodicThread>(
+        [this] { FlushLogFiles(); }, std::chrono::milliseconds(flush_interval));
+  }
+}
+
+void Logging::StartBackground(int executor_stats_interval) {
+  if (executor_stats_interval <= 0) {
+    background_ = maidsafe::make_unique<Active>();
+    return;
   }
+  auto stats(std::make_shared<ExecutorStats>("Logging thread"));
+  background_ = maidsafe::make_unique<Active>(stats);
+  background_stats_reporter_ = maidsafe::make_unique<ExecutorStatsReporter>(
+      std::vector<std::shared_ptr<const ExecutorStats>>(1, stats),
+      std::chrono::seconds(executor_stats_interval));
+}
+
+void Logging::StartBinaryLog(detail::BinaryLog::OverflowPolicy overflow_policy) {
+  StopBinaryLog();
+  binary_log_ = maidsafe::make_unique<detail::BinaryLog>(&PrintBinaryLogEntry,
+                                                         kBinaryLogRingCapacity, overflow_policy);
+  detail::g_binary_log.store(binary_log_.get(), std::memory_order_release);
+}
+
+void Logging::StopBinaryLog() {
+  detail::g_binary_log.store(nullptr, std::memory_order_release);
+  binary_log_.reset();
 }
 
 void Logging::Send(std::function<void()> message_functor) {
@@ -676,20 +787,12 @@ void Logging::Send(std::function<void()> message_functor) {
 #endif
 }
 
-void Logging::WriteToLogfile(const std::string& message, LogFile& log_file) {
-  std::lock_guard<std::mutex> lock(log_file.mutex);
-  if (log_file.stream.good()) {
-    log_file.stream.write(message.c_str(), message.size());
-    log_file.stream.flush();
-  }
-}
-
-void Logging::WriteToCombinedLogfile(const std::string& message) {
-  WriteToLogfile(message, combined_logfile_stream_);
+void Logging::WriteToCombinedLogfile(const std::string& message, int level) {
+  combined_logfile_stream_.Write(message, level >= kError);
 }
 
 void Logging::WriteToVisualiserLogfile(const std::string& message) {
-  WriteToLogfile(message, visualiser_.logfile);
+  visualiser_.logfile.Write(message, true);
 }
 
 void Logging::WriteToVisualiserServer(const std::string& message) {
@@ -734,19 +837,24 @@ void Logging::WriteToVisualiserServer(const std::string& message) {
   }
 }
 
-void Logging::WriteToProjectLogfile(const std::string& project, const std::string& message) {
+void Logging::WriteToProjectLogfile(const std::string& project, const std::string& message,
+                                    int level) {
   auto itr(project_logfile_streams_.find(project));
   if (itr != project_logfile_streams_.end())
-    WriteToLogfile(message, *(itr->second));
+    itr->second->Write(message, level >= kError);
 }
 
 void Logging::Flush() {
-  for (auto& stream : project_logfile_streams_) {
-    std::lock_guard<std::mutex> lock(stream.second->mutex);
-    stream.second->stream.flush();
-  }
-  std::lock_guard<std::mutex> lock(combined_logfile_stream_.mutex);
-  combined_logfile_stream_.stream.flush();
+  if (binary_log_)
+    binary_log_->Flush();
+  FlushLogFiles();
+}
+
+void Logging::FlushLogFiles() {
+  for (auto& stream : project_logfile_streams_)
+    stream.second->Flush();
+  combined_logfile_stream_.Flush();
+  visualiser_.logfile.Flush();
 }
 
 std::string Logging::VlogPrefix() const {
@@ -763,9 +871,9 @@ std::string Logging::VlogSessionId() const {
 
 namespace detail {
 
-std::string GetLocalTime() { return GetTime<TimeType::kLocal>(); }
+std::string GetLocalTime() { return GetTime<TimeType::kLocal>(std::chrono::system_clock::now()); }
 
-std::string GetUTCTime() { return GetTime<TimeType::kUTC>(); }
+std::string GetUTCTime() { return GetTime<TimeType::kUTC>(std::chrono::system_clock::now()); }
 
 }  // namespace detail
 
@@ -0,0 +1,163 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/log_file.h"
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/active.h"
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/utils.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace log {
+
+namespace detail {
+
+namespace {
+
+const std::uint16_t kCompressionLevel(6);
+
+fs::path CompressedPath(const fs::path& path) {
+  fs::path compressed_path(path);
+  compressed_path += ".gz";
+  return compressed_path;
+}
+
+// Replaces 'path' with a gzipped copy.  If that fails, 'path' is left as it is.
+void CompressFile(const fs::path& path) {
+  try {
+    const auto contents(ReadFile(path));
+    if (!contents || contents->empty())
+      return;
+    const crypto::CompressedText compressed(
+        crypto::Compress(crypto::UncompressedText(*contents), kCompressionLevel));
+    if (WriteFile(CompressedPath(path), compressed->string())) {
+      boost::system::error_code ec;
+      fs::remove(path, ec);
+    }
+  } catch (const std::exception&) {
+  }
+}
+
+void RemoveFile(const fs::path& path) {
+  boost::system::error_code ec;
+  fs::remove(path, ec);
+  fs::remove(CompressedPath(path), ec);
+}
+
+}  // unnamed namespace
+
+// ========================================= LogFile ===============================================
+LogFile::LogFile()
+    : mutex_(), path_(), options_(), stream_(), buffer_(), file_size_(0), rotated_count_(0) {}
+
+LogFile::~LogFile() { Flush(); }
+
+void LogFile::Open(const fs::path& path, const Options& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (stream_.is_open()) {
+    WriteOut();
+    stream_.close();
+  }
+  stream_.clear();
+  path_ = path;
+  options_ = options;
+  stream_.open(path_.c_str(), std::ios_base::trunc);
+  buffer_.reserve(options_.buffer_size);
+  file_size_ = 0;
+  rotated_count_ = 0;
+}
+
+void LogFile::Write(const std::string& message, bool flush) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!stream_.is_open() || !stream_.good())
+    return;
+  if (options_.max_file_size != 0) {
+    const std::uint64_t current_size(file_size_ + buffer_.size());
+    if (current_size != 0 && current_size + message.size() > options_.max_file_size) {
+      WriteOut();
+      Rotate();
+    }
+  }
+  buffer_ += message;
+  if (flush || buffer_.size() > options_.buffer_size)
+    WriteOut();
+}
+
+void LogFile::Flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  WriteOut();
+}
+
+fs::path LogFile::RotatedPath(const fs::path& path, unsigned index) {
+  fs::path rotated_path(path.parent_path() / path.stem());
+  rotated_path += "." + std::to_string(index) + path.extension().string();
+  return rotated_path;
+}
+
+void LogFile::WriteOut() {
+  if (buffer_.empty())
+    return;
+  if (stream_.good()) {
+    stream_.write(buffer_.data(), buffer_.size());
+    stream_.flush();
+    file_size_ += buffer_.size();
+  }
+  buffer_.clear();
+}
+
+void LogFile::Rotate() {
+  const fs::path rotated_path(RotatedPath(path_, rotated_count_ + 1));
+  stream_.close();
+  boost::system::error_code ec;
+  fs::rename(path_, rotated_path, ec);
+  if (ec) {
+    // Carry on with the current file, and try again once it's grown by another 'max_file_size'.
+    stream_.open(path_.c_str(), std::ios_base::app);
+    file_size_ = 0;
+    return;
+  }
+  stream_.open(path_.c_str(), std::ios_base::trunc);
+  file_size_ = 0;
+  ++rotated_count_;
+
+  // Files are compressed and removed in order, so a file is never removed while being compressed.
+  const bool remove_oldest(options_.max_rotated_files != 0 &&
+                           rotated_count_ > options_.max_rotated_files);
+  const fs::path oldest_path(
+      remove_oldest ? RotatedPath(path_, rotated_count_ - options_.max_rotated_files) : fs::path());
+  if (options_.compressor) {
+    options_.compressor->Send([rotated_path, oldest_path] {
+      CompressFile(rotated_path);
+      if (!oldest_path.empty())
+        RemoveFile(oldest_path);
+    });
+  } else if (remove_oldest) {
+    RemoveFile(oldest_path);
+  }
+}
+
+}  // namespace detail
+
+}  // namespace log
+
+}  // namespace maidsafe
@@ -0,0 +1,52 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/periodic_thread.h"
+
+#include <utility>
+
+namespace maidsafe {
+
+PeriodicThread::PeriodicThread(std::function<void()> functor,
+                               std::chrono::steady_clock::duration interval)
+    : kFunctor_(std::move(functor)),
+      kInterval_(interval),
+      stopping_(false),
+      mutex_(),
+      condition_(),
+      thread_([this] { Run(); }) {}
+
+PeriodicThread::~PeriodicThread() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  condition_.notify_one();
+  thread_.join();
+}
+
+void PeriodicThread::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!condition_.wait_for(lock, kInterval_, [this] { return stopping_; })) {
+    lock.unlock();
+    kFunctor_();
+    lock.lock();
+  }
+}
+
+}  // namespace maidsafe
@@ -0,0 +1,319 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/segment_log.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace {
+
+const std::string kSegmentPrefix("segment_");
+// Value size (4 bytes), key type (4 bytes) and key name size (1 byte), followed by the key name.
+const std::uint32_t kFixedHeaderSize(9);
+
+void AppendUint32(std::uint32_t value, std::vector<char>& buffer) {
+  for (int i(0); i != 4; ++i)
+    buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+std::uint32_t ParseUint32(const char* data) {
+  std::uint32_t value(0);
+  for (int i(3); i >= 0; --i)
+    value = (value << 8) | static_cast<unsigned char>(data[i]);
+  return value;
+}
+
+std::vector<char> MakeRecordHeader(const SegmentLog::KeyType& key, std::size_t value_size) {
+  std::vector<char> header;
+  const std::size_t name_size(key.name.IsInitialised() ? key.name.string().size() : 0);
+  header.reserve(kFixedHeaderSize + name_size);
+  AppendUint32(static_cast<std::uint32_t>(value_size), header);
+  AppendUint32(key.type_id.data, header);
+  header.push_back(static_cast<char>(name_size));
+  if (name_size != 0)
+    header.insert(header.end(), key.name.string().begin(), key.name.string().end());
+  return header;
+}
+
+fs::path SegmentPath(const fs::path& directory, std::uint32_t segment_id) {
+  return directory / (kSegmentPrefix + std::to_string(segment_id));
+}
+
+}  // unnamed namespace
+
+const std::uint64_t SegmentLog::kDefaultMaxSegmentSize(8 * 1024 * 1024);
+const double SegmentLog::kDefaultMinLiveRatio(0.5);
+
+SegmentLog::Segment::Segment(fs::path path_in)
+    : path(std::move(path_in)),
+      file(path.string(), std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc),
+      size(0),
+      live_size(0),
+      sealed(false) {}
+
+SegmentLog::SegmentLog(const fs::path& directory, std::uint64_t max_segment_size,
+                       double min_live_ratio)
+    : kDirectory_(directory),
+      kMaxSegmentSize_(max_segment_size),
+      kMinLiveRatio_(min_live_ratio),
+      mutex_(),
+      cond_var_(),
+      index_(),
+      segments_(),
+      active_segment_id_(0),
+      pending_compactions_(),
+      compacting_(false),
+      running_(true),
+      worker_() {
+  boost::system::error_code error_code;
+  if (!fs::is_directory(kDirectory_, error_code)) {
+    LOG(kError) << kDirectory_ << " is not a directory.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  std::vector<fs::path> stale_segments;
+  for (fs::directory_iterator itr(kDirectory_, error_code), end; !error_code && itr != end;
+       itr.increment(error_code)) {
+    if (itr->path().filename().string().compare(0, kSegmentPrefix.size(), kSegmentPrefix) == 0)
+      stale_segments.push_back(itr->path());
+  }
+  for (const auto& stale_segment : stale_segments)
+    fs::remove(stale_segment, error_code);
+
+  StartNewSegment();
+  worker_ = std::async(std::launch::async, &SegmentLog::Compact, this);
+}
+
+SegmentLog::~SegmentLog() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  cond_var_.notify_all();
+  if (worker_.valid()) {
+    try {
+      worker_.get();
+    } catch (const std::exception& e) {
+      LOG(kError) << boost::diagnostic_information(e);
+    }
+  }
+}
+
+void SegmentLog::Put(const KeyType& key, const NonEmptyString& value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto location(Append(key, value));
+  auto itr(index_.find(key));
+  if (itr == index_.end()) {
+    index_.emplace(key, location);
+  } else {
+    Release(itr->second);
+    itr->second = location;
+  }
+}
+
+NonEmptyString SegmentLog::Get(const KeyType& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(index_.find(key));
+  if (itr == index_.end())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+  return Read(itr->second);
+}
+
+std::uint64_t SegmentLog::Remove(const KeyType& key, NonEmptyString* value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(index_.find(key));
+  if (itr == index_.end())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+  Location location(itr->second);
+  if (value)
+    *value = Read(location);
+  index_.erase(itr);
+  Release(location);
+  return location.value_size;
+}
+
+std::size_t SegmentLog::SegmentCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return segments_.size();
+}
+
+void SegmentLog::WaitForCompaction() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_var_.wait(lock, [this] {
+    return (pending_compactions_.empty() && !compacting_) || !running_;
+  });
+}
+
+SegmentLog::Location SegmentLog::Append(const KeyType& key, const NonEmptyString& value) {
+  auto header(MakeRecordHeader(key, value.string().size()));
+  const std::uint64_t record_size(header.size() + value.string().size());
+  if (segments_.at(active_segment_id_)->size != 0 &&
+      segments_.at(active_segment_id_)->size + record_size > kMaxSegmentSize_) {
+    StartNewSegment();
+  }
+
+  Segment& segment(*segments_.at(active_segment_id_));
+  segment.file.seekp(segment.size);
+  segment.file.write(header.data(), header.size());
+  segment.file.write(reinterpret_cast<const char*>(value.string().data()),
+                     value.string().size());
+  segment.file.flush();
+  if (!segment.file) {
+    segment.file.clear();
+    LOG(kError) << "Failed to append to " << segment.path;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+
+  Location location{active_segment_id_, segment.size, static_cast<std::uint32_t>(header.size()),
+                    static_cast<std::uint32_t>(value.string().size())};
+  segment.size += record_size;
+  segment.live_size += record_size;
+  return location;
+}
+
+NonEmptyString SegmentLog::Read(const Location& location) {
+  Segment& segment(*segments_.at(location.segment_id));
+  std::vector<byte> value(location.value_size);
+  segment.file.seekg(location.offset + location.header_size);
+  segment.file.read(reinterpret_cast<char*>(value.data()), value.size());
+  if (!segment.file) {
+    segment.file.clear();
+    LOG(kError) << "Failed to read " << location.value_size << " bytes at offset "
+                << location.offset << " of " << segment.path;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  return NonEmptyString(std::move(value));
+}
+
+void SegmentLog::Release(const Location& location) {
+  segments_.at(location.segment_id)->live_size -= location.header_size + location.value_size;
+  ScheduleCompactionIfSparse(location.segment_id);
+}
+
+void SegmentLog::StartNewSegment() {
+  if (!segments_.empty()) {
+    segments_.at(active_segment_id_)->sealed = true;
+    ScheduleCompactionIfSparse(active_segment_id_);
+    ++active_segment_id_;
+  }
+  std::unique_ptr<Segment> segment(new Segment(SegmentPath(kDirectory_, active_segment_id_)));
+  if (!segment->file) {
+    LOG(kError) << "Failed to create " << segment->path;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  segments_.emplace(active_segment_id_, std::move(segment));
+}
+
+void SegmentLog::ScheduleCompactionIfSparse(std::uint32_t segment_id) {
+  auto itr(segments_.find(segment_id));
+  if (itr == segments_.end() || !itr->second->sealed)
+    return;
+  if (itr->second->live_size < kMinLiveRatio_ * itr->second->size &&
+      pending_compactions_.insert(segment_id).second) {
+    cond_var_.notify_all();
+  }
+}
+
+void SegmentLog::Compact() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    cond_var_.wait(lock, [this] { return !pending_compactions_.empty() || !running_; });
+    if (!running_)
+      return;
+
+    auto segment_id(*pending_compactions_.begin());
+    pending_compactions_.erase(pending_compactions_.begin());
+    if (segments_.count(segment_id) == 0)
+      continue;
+    compacting_ = true;
+    try {
+      CompactSegment(segment_id, lock);
+    } catch (const std::exception& e) {
+      if (!lock)
+        lock.lock();
+      LOG(kError) << "Failed to compact segment " << segment_id << ": "
+                  << boost::diagnostic_information(e);
+    }
+    compacting_ = false;
+    cond_var_.notify_all();
+  }
+}
+
+void SegmentLog::CompactSegment(std::uint32_t segment_id, std::unique_lock<std::mutex>& lock) {
+  const fs::path path(segments_.at(segment_id)->path);
+  if (segments_.at(segment_id)->live_size != 0) {
+    // Sealed segments are never written to, so can be read without holding the lock.  Each record
+    // is only copied if the index still refers to this instance of it.
+    lock.unlock();
+    std::ifstream file(path.string(), std::ios::binary);
+    std::uint64_t offset(0);
+    char fixed_header[kFixedHeaderSize];
+    while (running_ && file.read(fixed_header, kFixedHeaderSize)) {
+      const std::uint32_t value_size(ParseUint32(fixed_header));
+      KeyType key;
+      key.type_id = DataTypeId(ParseUint32(fixed_header + 4));
+      const std::uint32_t name_size(static_cast<unsigned char>(fixed_header[8]));
+      if (name_size != 0) {
+        std::string name(name_size, 0);
+        file.read(&name[0], name_size);
+        key.name = Identity(name);
+      }
+      std::vector<byte> value(value_size);
+      file.read(reinterpret_cast<char*>(value.data()), value_size);
+      if (!file) {
+        LOG(kError) << "Truncated record at offset " << offset << " of " << path;
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+      }
+
+      lock.lock();
+      auto itr(index_.find(key));
+      if (itr != index_.end() && itr->second.segment_id == segment_id &&
+          itr->second.offset == offset) {
+        Location old_location(itr->second);
+        itr->second = Append(key, NonEmptyString(std::move(value)));
+        segments_.at(segment_id)->live_size -= old_location.header_size + old_location.value_size;
+      }
+      lock.unlock();
+      offset += kFixedHeaderSize + name_size + value_size;
+    }
+    lock.lock();
+    if (!running_)
+      return;
+  }
+
+  if (segments_.at(segment_id)->live_size != 0) {
+    LOG(kError) << "Segment " << path << " still has live records after compaction.";
+    return;
+  }
+  segments_.erase(segment_id);
+  boost::system::error_code error_code;
+  if (!fs::remove(path, error_code) || error_code)
+    LOG(kWarning) << "Failed to remove " << path << ": " << error_code.message();
+}
+
+}  // namespace maidsafe
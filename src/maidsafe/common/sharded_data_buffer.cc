@@ -0,0 +1,272 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/sharded_data_buffer.h"
+
+#include <string>
+#include <utility>
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+ShardedDataBuffer::ShardedDataBuffer(MemoryUsage max_memory_usage, DiskUsage max_disk_usage,
+                                     PopFunctor pop_functor, std::size_t shard_count,
+                                     DiskBackend disk_backend, EvictionPolicy eviction_policy,
+                                     std::size_t expected_key_count)
+    : kHash_(),
+      kDiskBuffer_(),
+      kShouldRemoveRoot_(false),
+      kShardCount_(shard_count),
+      shards_(),
+      limits_mutex_(),
+      max_memory_usage_(max_memory_usage),
+      max_disk_usage_(max_disk_usage) {
+  if (shard_count == 0 || max_memory_usage > max_disk_usage) {
+    LOG(kError) << "Shard count must be > 0 and max memory usage must be <= max disk usage.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  shards_.reserve(kShardCount_);
+  for (std::size_t i(0); i != kShardCount_; ++i) {
+    shards_.emplace_back(std::unique_ptr<DataBuffer>(new DataBuffer(
+        ShareOf(max_memory_usage, i), ShareOf(max_disk_usage, i), pop_functor, disk_backend,
+        eviction_policy, KeyCountShare(expected_key_count))));
+  }
+}
+
+ShardedDataBuffer::ShardedDataBuffer(MemoryUsage max_memory_usage, DiskUsage max_disk_usage,
+                                     PopFunctor pop_functor, std::size_t shard_count,
+                                     const fs::path& disk_buffer, bool should_remove_root,
+                                     DiskBackend disk_backend, EvictionPolicy eviction_policy,
+                                     std::size_t expected_key_count)
+    : kHash_(),
+      kDiskBuffer_(disk_buffer),
+      kShouldRemoveRoot_(should_remove_root),
+      kShardCount_(shard_count),
+      shards_(),
+      limits_mutex_(),
+      max_memory_usage_(max_memory_usage),
+      max_disk_usage_(max_disk_usage) {
+  if (shard_count == 0 || max_memory_usage > max_disk_usage) {
+    LOG(kError) << "Shard count must be > 0 and max memory usage must be <= max disk usage.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  shards_.reserve(kShardCount_);
+  for (std::size_t i(0); i != kShardCount_; ++i) {
+    shards_.emplace_back(std::unique_ptr<DataBuffer>(new DataBuffer(
+        ShareOf(max_memory_usage, i), ShareOf(max_disk_usage, i), pop_functor,
+        kDiskBuffer_ / ("shard_" + std::to_string(i)), should_remove_root, disk_backend,
+        eviction_policy, DataBuffer::ExistingValues::kIgnore, KeyCountShare(expected_key_count))));
+  }
+}
+
+ShardedDataBuffer::~ShardedDataBuffer() {
+  shards_.clear();
+  if (kShouldRemoveRoot_) {
+    boost::system::error_code error_code;
+    fs::remove_all(kDiskBuffer_, error_code);
+    if (error_code)
+      LOG(kWarning) << "Failed to remove " << kDiskBuffer_ << ": " << error_code.message();
+  }
+}
+
+void ShardedDataBuffer::Store(const KeyType& key, const NonEmptyString& value) {
+  Shard(key).Store(key, value);
+}
+
+void ShardedDataBuffer::Store(const KeyType& key, SharedValue value) {
+  Shard(key).Store(key, std::move(value));
+}
+
+NonEmptyString ShardedDataBuffer::Get(const KeyType& key) { return Shard(key).Get(key); }
+
+ShardedDataBuffer::SharedValue ShardedDataBuffer::GetShared(const KeyType& key) {
+  return Shard(key).GetShared(key);
+}
+
+boost::optional<NonEmptyString> ShardedDataBuffer::TryGet(const KeyType& key) {
+  return Shard(key).TryGet(key);
+}
+
+bool ShardedDataBuffer::Has(const KeyType& key) { return Shard(key).Has(key); }
+
+void ShardedDataBuffer::Delete(const KeyType& key) { Shard(key).Delete(key); }
+
+void ShardedDataBuffer::StoreAsync(AsioService& asio_service, const KeyType& key,
+                                   const NonEmptyString& value, StoreHandler handler) {
+  Shard(key).StoreAsync(asio_service, key, value, std::move(handler));
+}
+
+std::future<void> ShardedDataBuffer::StoreAsync(AsioService& asio_service, const KeyType& key,
+                                                const NonEmptyString& value) {
+  return Shard(key).StoreAsync(asio_service, key, value);
+}
+
+void ShardedDataBuffer::GetAsync(AsioService& asio_service, const KeyType& key,
+                                 GetHandler handler) {
+  Shard(key).GetAsync(asio_service, key, std::move(handler));
+}
+
+std::future<NonEmptyString> ShardedDataBuffer::GetAsync(AsioService& asio_service,
+                                                        const KeyType& key) {
+  return Shard(key).GetAsync(asio_service, key);
+}
+
+void ShardedDataBuffer::DeleteAsync(AsioService& asio_service, const KeyType& key,
+                                    DeleteHandler handler) {
+  Shard(key).DeleteAsync(asio_service, key, std::move(handler));
+}
+
+std::future<void> ShardedDataBuffer::DeleteAsync(AsioService& asio_service, const KeyType& key) {
+  return Shard(key).DeleteAsync(asio_service, key);
+}
+
+void ShardedDataBuffer::StoreBatch(
+    const std::vector<std::pair<KeyType, NonEmptyString>>& key_values) {
+  StoreBatchInShards(key_values);
+}
+
+void ShardedDataBuffer::StoreBatch(const std::vector<std::pair<KeyType, SharedValue>>& key_values) {
+  StoreBatchInShards(key_values);
+}
+
+std::vector<ShardedDataBuffer::SharedValue> ShardedDataBuffer::GetBatch(
+    const std::vector<KeyType>& keys) {
+  // For each shard, the keys it owns and their positions in 'keys'.
+  std::vector<std::vector<KeyType>> batches(kShardCount_);
+  std::vector<std::vector<std::size_t>> positions(kShardCount_);
+  for (std::size_t i(0); i != keys.size(); ++i) {
+    const std::size_t shard_index(ShardIndex(keys[i]));
+    batches[shard_index].push_back(keys[i]);
+    positions[shard_index].push_back(i);
+  }
+  std::vector<SharedValue> values(keys.size());
+  for (std::size_t i(0); i != kShardCount_; ++i) {
+    if (batches[i].empty())
+      continue;
+    auto shard_values(shards_[i]->GetBatch(batches[i]));
+    for (std::size_t j(0); j != shard_values.size(); ++j)
+      values[positions[i][j]] = std::move(shard_values[j]);
+  }
+  return values;
+}
+
+void ShardedDataBuffer::DeleteBatch(const std::vector<KeyType>& keys) {
+  std::vector<std::vector<KeyType>> batches(kShardCount_);
+  for (const auto& key : keys)
+    batches[ShardIndex(key)].push_back(key);
+  for (std::size_t i(0); i != kShardCount_; ++i) {
+    if (!batches[i].empty())
+      shards_[i]->DeleteBatch(batches[i]);
+  }
+}
+
+void ShardedDataBuffer::Delete(std::function<bool(const KeyType&)> predicate) {
+  for (auto& shard : shards_)
+    shard->Delete(predicate);
+}
+
+ShardedDataBuffer::Statistics ShardedDataBuffer::Stats() {
+  Statistics total = Statistics();
+  auto add([](Statistics::Usage& sum, const Statistics::Usage& usage) {
+    sum.bytes += usage.bytes;
+    sum.entries += usage.entries;
+  });
+  for (auto& shard : shards_) {
+    const Statistics stats(shard->Stats());
+    add(total.memory, stats.memory);
+    add(total.disk, stats.disk);
+    add(total.copy_backlog, stats.copy_backlog);
+    total.stores += stats.stores;
+    total.memory_hits += stats.memory_hits;
+    total.disk_hits += stats.disk_hits;
+    total.misses += stats.misses;
+    total.deletes += stats.deletes;
+    total.spills += stats.spills;
+    total.spilled_bytes += stats.spilled_bytes;
+    total.pops += stats.pops;
+    total.popped_bytes += stats.popped_bytes;
+    total.memory_evictions += stats.memory_evictions;
+    total.promotions += stats.promotions;
+    total.memory_wait_time += stats.memory_wait_time;
+    total.disk_wait_time += stats.disk_wait_time;
+    total.store_latency.Merge(stats.store_latency);
+    total.get_latency.Merge(stats.get_latency);
+    total.spill_latency.Merge(stats.spill_latency);
+  }
+  return total;
+}
+
+void ShardedDataBuffer::SetMaxMemoryUsage(MemoryUsage max_memory_usage) {
+  std::lock_guard<std::mutex> lock(limits_mutex_);
+  if (max_memory_usage > max_disk_usage_) {
+    LOG(kError) << "Max memory usage must be <= max disk usage.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  for (std::size_t i(0); i != shards_.size(); ++i)
+    shards_[i]->SetMaxMemoryUsage(ShareOf(max_memory_usage, i));
+  max_memory_usage_ = max_memory_usage;
+}
+
+void ShardedDataBuffer::SetMaxDiskUsage(DiskUsage max_disk_usage) {
+  std::lock_guard<std::mutex> lock(limits_mutex_);
+  if (max_memory_usage_ > max_disk_usage) {
+    LOG(kError) << "Max memory usage must be <= max disk usage.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  for (std::size_t i(0); i != shards_.size(); ++i)
+    shards_[i]->SetMaxDiskUsage(ShareOf(max_disk_usage, i));
+  max_disk_usage_ = max_disk_usage;
+}
+
+template <typename ValueType>
+void ShardedDataBuffer::StoreBatchInShards(
+    const std::vector<std::pair<KeyType, ValueType>>& key_values) {
+  std::vector<std::vector<std::pair<KeyType, ValueType>>> batches(kShardCount_);
+  for (const auto& key_value : key_values)
+    batches[ShardIndex(key_value.first)].push_back(key_value);
+  for (std::size_t i(0); i != kShardCount_; ++i) {
+    if (!batches[i].empty())
+      shards_[i]->StoreBatch(batches[i]);
+  }
+}
+
+template <typename UsageType>
+UsageType ShardedDataBuffer::ShareOf(UsageType total, std::size_t shard_index) const {
+  // The remainder is spread over the lowest-indexed shards, so if total memory <= total disk, then
+  // each shard's memory share <= its disk share.
+  return UsageType(total.data / kShardCount_ + (shard_index < total.data % kShardCount_ ? 1 : 0));
+}
+
+std::size_t ShardedDataBuffer::KeyCountShare(std::size_t expected_key_count) const {
+  // Rounded up, so that a non-zero count still enables each shard's filter.
+  return (expected_key_count + kShardCount_ - 1) / kShardCount_;
+}
+
+std::size_t ShardedDataBuffer::ShardIndex(const KeyType& key) const {
+  return kHash_(key) % kShardCount_;
+}
+
+DataBuffer& ShardedDataBuffer::Shard(const KeyType& key) { return *shards_[ShardIndex(key)]; }
+
+}  // namespace maidsafe
@@ -33,15 +33,28 @@ namespace maidsafe {
 
 namespace tcp {
 
-Listener::Listener(asio::io_service::strand& strand, NewConnectionFunctor on_new_connection)
+Listener::Listener(asio::io_service::strand& strand, NewConnectionFunctor on_new_connection,
+                   ConnectionStrandFunctor connection_strand)
     : strand_(strand),
       stop_listening_flag_(),
       on_new_connection_(on_new_connection),
+      connection_strand_(connection_strand),
       acceptor_(strand.context()) {}
 
 ListenerPtr Listener::MakeShared(asio::io_service::strand& strand,
                                  NewConnectionFunctor on_new_connection, Port desired_port) {
-  ListenerPtr listener{new Listener{strand, on_new_connection}};
+  return MakeShared(strand, on_new_connection, desired_port,
+                    [&strand]() -> asio::io_service::strand& { return strand; });
+}
+
+ListenerPtr Listener::MakeShared(asio::io_service::strand& strand,
+                                 NewConnectionFunctor on_new_connection, Port desired_port,
+                                 ConnectionStrandFunctor connection_strand) {
+  if (!connection_strand) {
+    LOG(kError) << "Invalid connection_strand functor.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  ListenerPtr listener{new Listener{strand, on_new_connection, connection_strand}};
   listener->StartListening(desired_port);
   return listener;
 }
@@ -100,15 +113,7 @@ void Listener::DoStartListening(Port port) {
 #endif
   acceptor_.bind(endpoint);
   acceptor_.listen(asio::socket_base::max_connections);
-
-  // The connection object is kept alive in the acceptor handler until HandleAccept() is called.
-  ConnectionPtr connection{Connection::MakeShared(strand_)};
-  ListenerPtr this_ptr{shared_from_this()};
-  acceptor_.async_accept(connection->Socket(), strand_.wrap([this_ptr, connection](
-                                                   const std::error_code& error) {
-                                                 this_ptr->HandleAccept(connection, error);
-                                               }));
-
+  AsyncAccept();
   cleanup_on_error.Release();
 }
 
@@ -121,8 +126,13 @@ void Listener::HandleAccept(ConnectionPtr accepted_connection, const std::error_
   else
     on_new_connection_(accepted_connection);
 
+  AsyncAccept();
+}
+
+void Listener::AsyncAccept() {
   // The connection object is kept alive in the acceptor handler until HandleAccept() is called.
-  ConnectionPtr connection{ Connection::MakeShared(strand_) };
+  // Its socket may belong to a different io_service from the acceptor's.
+  ConnectionPtr connection{Connection::MakeShared(connection_strand_())};
   ListenerPtr this_ptr{shared_from_this()};
   acceptor_.async_accept(connection->Socket(), strand_.wrap([this_ptr, connection](
                                                    const std::error_code& error) {
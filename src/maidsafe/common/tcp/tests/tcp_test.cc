@@ -18,8 +18,10 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <future>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <utility>
@@ -417,6 +419,120 @@ TEST_F(TcpTest, BEH_MultipleConnectionsToServer) {
   server_connections.clear();
 }
 
+namespace {
+
+// Has each of 'client_count' clients send a message to an echo server and wait for the reply,
+// 'round_trips' times in turn.  Listening is done on 'listener_strand', and each client and server
+// connection uses the strand returned by 'connection_strand'.  Returns the total round trips per
+// millisecond, or 0 if they didn't all complete.
+double EchoRoundTripRate(asio::io_service::strand& listener_strand,
+                         Listener::ConnectionStrandFunctor connection_strand, int client_count,
+                         int round_trips) {
+  std::mutex mutex;
+  std::vector<ConnectionPtr> connections;
+  ListenerPtr listener{Listener::MakeShared(listener_strand, [&](ConnectionPtr connection) {
+    std::weak_ptr<Connection> weak_connection{connection};
+    connection->Start([weak_connection](Message message) {
+      if (ConnectionPtr server_connection = weak_connection.lock())
+        server_connection->Send(std::move(message));
+    }, [] {});
+    std::lock_guard<std::mutex> lock{mutex};
+    connections.push_back(std::move(connection));
+  }, Port{7777}, connection_strand)};
+
+  std::vector<ConnectionPtr> clients;
+  std::vector<std::future<void>> finished;
+  for (int i(0); i < client_count; ++i)
+    clients.push_back(Connection::MakeShared(connection_strand(), listener->ListeningPort()));
+  const Message message(64, 'm');
+  const auto start(std::chrono::steady_clock::now());
+  for (auto& client : clients) {
+    auto done(std::make_shared<std::promise<void>>());
+    finished.push_back(done->get_future());
+    auto remaining(std::make_shared<int>(round_trips));
+    std::weak_ptr<Connection> weak_client{client};
+    client->Start([weak_client, remaining, done](Message reply) {
+      ConnectionPtr client_connection{weak_client.lock()};
+      if (--*remaining == 0)
+        done->set_value();
+      else if (client_connection)
+        client_connection->Send(std::move(reply));
+    }, [] {});
+    client->Send(message);
+  }
+  bool completed(true);
+  for (auto& client_finished : finished) {
+    completed = completed && client_finished.wait_until(start + std::chrono::seconds(60)) ==
+                                 std::future_status::ready;
+  }
+  const std::chrono::duration<double, std::milli> elapsed(std::chrono::steady_clock::now() -
+                                                          start);
+
+  for (auto& client : clients)
+    client->Close();
+  listener->StopListening();
+  std::lock_guard<std::mutex> lock{mutex};
+  for (auto& connection : connections)
+    connection->Close();
+  return completed ? client_count * round_trips / elapsed.count() : 0.0;
+}
+
+// Returns a functor which hands out 'strands' in turn.
+Listener::ConnectionStrandFunctor RoundRobin(
+    std::vector<std::unique_ptr<asio::io_service::strand>>& strands) {
+  auto next(std::make_shared<std::atomic<size_t>>(0));
+  return [&strands, next]() -> asio::io_service::strand& {
+    return *strands[(*next)++ % strands.size()];
+  };
+}
+
+}  // unnamed namespace
+
+TEST_F(TcpTest, BEH_ConnectionsOnServicePool) {
+  AsioServicePool pool{3};
+  asio::io_service::strand listener_strand{pool.service(0)};
+  std::vector<std::unique_ptr<asio::io_service::strand>> strands;
+  for (size_t i(0); i < pool.ThreadCount(); ++i)
+    strands.emplace_back(new asio::io_service::strand{pool.NextService()});
+  EXPECT_LT(0.0, EchoRoundTripRate(listener_strand, RoundRobin(strands), 5, 20));
+  pool.Stop();
+}
+
+TEST_F(TcpTest, FUNC_SharedVersusPerThreadServices) {
+  const size_t thread_count(Concurrency());
+  const int client_count(32), round_trips(2000);
+  double shared_rate(0.0), pool_rate(0.0), pinned_rate(0.0);
+  {
+    // All threads run one io_service, and each connection has its own strand.
+    AsioService asio_service{thread_count};
+    asio::io_service::strand listener_strand{asio_service.service()};
+    std::vector<std::unique_ptr<asio::io_service::strand>> strands;
+    for (int i(0); i < 2 * client_count; ++i)
+      strands.emplace_back(new asio::io_service::strand{asio_service.service()});
+    shared_rate =
+        EchoRoundTripRate(listener_strand, RoundRobin(strands), client_count, round_trips);
+    asio_service.Stop();
+  }
+  for (const bool pin_threads : {false, true}) {
+    // Each thread runs its own io_service, and connections are shared out between them.
+    AsioServicePool pool{thread_count, pin_threads};
+    asio::io_service::strand listener_strand{pool.service(0)};
+    std::vector<std::unique_ptr<asio::io_service::strand>> strands;
+    for (size_t i(0); i < thread_count; ++i)
+      strands.emplace_back(new asio::io_service::strand{pool.NextService()});
+    (pin_threads ? pinned_rate : pool_rate) =
+        EchoRoundTripRate(listener_strand, RoundRobin(strands), client_count, round_trips);
+    pool.Stop();
+  }
+  EXPECT_LT(0.0, shared_rate);
+  EXPECT_LT(0.0, pool_rate);
+  EXPECT_LT(0.0, pinned_rate);
+  TLOG(kGreen) << client_count << " loopback clients, " << thread_count
+               << " threads, round trips per ms: shared io_service " << shared_rate
+               << ", io_service per thread " << pool_rate << ", pinned io_service per thread "
+               << pinned_rate << "\n";
+}
+
 }  // namespace test
 
 }  // namespace tcp
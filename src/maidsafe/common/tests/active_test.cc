@@ -0,0 +1,188 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/active.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(ActiveTest, BEH_RunsInOrder) {
+  const int producer_count(8), per_producer(10000);
+  std::vector<int> last_seen(producer_count, -1);
+  bool in_order(true);
+  {
+    Active active;
+    std::vector<std::thread> producers;
+    for (int p(0); p < producer_count; ++p) {
+      producers.emplace_back([&, p] {
+        for (int i(0); i < per_producer; ++i) {
+          // Only the background thread touches 'last_seen' and 'in_order'.
+          active.Send([&, p, i] {
+            in_order = in_order && last_seen[p] == i - 1;
+            last_seen[p] = i;
+          });
+        }
+      });
+    }
+    for (auto& producer : producers)
+      producer.join();
+    // The destructor runs everything already sent.
+  }
+  EXPECT_TRUE(in_order);
+  for (const auto last : last_seen)
+    EXPECT_EQ(per_producer - 1, last);
+}
+
+TEST(ActiveTest, BEH_WakesAfterIdle) {
+  Active active;
+  for (int i(0); i < 20; ++i) {
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool done(false);
+    active.Send([&] {
+      std::lock_guard<std::mutex> lock(mutex);
+      done = true;
+      condition.notify_one();
+    });
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(condition.wait_for(lock, std::chrono::seconds(5), [&] { return done; }));
+    // Give the background thread time to go to sleep again.
+    if (i % 2 == 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+}
+
+TEST(ActiveTest, BEH_ReleasesFunctors) {
+  // Functors (and hence their captures) are destroyed once they have been run.
+  auto resource(std::make_shared<int>(0));
+  {
+    Active active;
+    for (int i(0); i < 100; ++i)
+      active.Send([resource] { ++*resource; });
+  }
+  EXPECT_EQ(100, *resource);
+  EXPECT_TRUE(resource.unique());
+}
+
+namespace {
+
+// The previous design of Active, with a mutex-protected std::queue, for comparison.
+class LockingActive {
+ public:
+  LockingActive()
+      : running_(true),
+        functors_(),
+        flags_mutex_(),
+        mutex_(),
+        condition_(),
+        thread_([this] { Run(); }) {}
+  ~LockingActive() {
+    Send([this] {
+      std::lock_guard<std::mutex> flags_lock(flags_mutex_);
+      running_ = false;
+    });
+    thread_.join();
+  }
+  void Send(Active::Functor functor) {
+    std::lock_guard<std::mutex> flags_lock(flags_mutex_);
+    if (!running_)
+      return;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      functors_.push(std::move(functor));
+    }
+    condition_.notify_one();
+  }
+
+ private:
+  void Run() {
+    auto running = [this]() -> bool {
+      std::lock_guard<std::mutex> flags_lock(flags_mutex_);
+      return running_;
+    };
+    while (running()) {
+      Active::Functor functor;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this] { return !functors_.empty(); });
+        functor = std::move(functors_.front());
+        functors_.pop();
+      }
+      functor();
+    }
+  }
+
+  bool running_;
+  std::queue<Active::Functor> functors_;
+  std::mutex flags_mutex_, mutex_;
+  std::condition_variable condition_;
+  std::thread thread_;
+};
+
+// Returns the number of functors per microsecond which 'producer_count' threads can send to a
+// 'Queue', including the time taken for them all to run.
+template <typename Queue>
+double SendRate(int producer_count, int total) {
+  std::uint64_t count(0);
+  const auto start(std::chrono::steady_clock::now());
+  {
+    Queue queue;
+    std::vector<std::thread> producers;
+    for (int p(0); p < producer_count; ++p) {
+      producers.emplace_back([&] {
+        for (int i(0); i < total / producer_count; ++i)
+          queue.Send([&count] { ++count; });
+      });
+    }
+    for (auto& producer : producers)
+      producer.join();
+  }
+  const auto elapsed(std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start));
+  return static_cast<double>(count) / std::max<std::chrono::microseconds::rep>(elapsed.count(), 1);
+}
+
+}  // unnamed namespace
+
+TEST(ActiveTest, FUNC_ProducerScaling) {
+  const int total(1 << 20);
+  for (int producer_count(1); producer_count <= 16; producer_count *= 2) {
+    const double locking(SendRate<LockingActive>(producer_count, total));
+    const double lock_free(SendRate<Active>(producer_count, total));
+    TLOG(kGreen) << producer_count << " producers: mutex queue " << locking
+                 << " functors/us, lock-free queue " << lock_free << " functors/us\n";
+  }
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -21,6 +21,9 @@
 #include <chrono>
 #include <condition_variable>
 #include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
 
 #include "boost/date_time/posix_time/posix_time.hpp"
 
@@ -74,6 +77,45 @@ TYPED_TEST(AsioServiceTest, BEH_StartAndStop) {
   EXPECT_FALSE(done);
 }
 
+TYPED_TEST(AsioServiceTest, BEH_ServicePool) {
+  EXPECT_THROW(IoServicePool<TypeParam>(0), maidsafe_error);
+
+  for (const bool pin_threads : {false, true}) {
+    IoServicePool<TypeParam> pool(3, pin_threads);
+    EXPECT_EQ(3U, pool.ThreadCount());
+    for (size_t i(0); i < 7; ++i) {
+      EXPECT_EQ(&pool.service(i % 3), &pool.NextService());
+      EXPECT_EQ(&pool.service(i % 3), &pool.ServiceFor(i));
+    }
+
+    // Each service is run by a single thread of its own.
+    std::mutex mutex;
+    std::condition_variable cond_var;
+    std::vector<std::set<std::thread::id>> thread_ids(3);
+    size_t remaining(30);
+    for (size_t i(0); i < 30; ++i) {
+      pool.service(i % 3).post([&, i] {
+        std::lock_guard<std::mutex> lock(mutex);
+        thread_ids[i % 3].insert(std::this_thread::get_id());
+        if (--remaining == 0)
+          cond_var.notify_one();
+      });
+    }
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      ASSERT_TRUE(
+          cond_var.wait_for(lock, std::chrono::seconds(10), [&] { return remaining == 0; }));
+    }
+    std::set<std::thread::id> all_thread_ids;
+    for (const auto& ids : thread_ids) {
+      EXPECT_EQ(1U, ids.size());
+      all_thread_ids.insert(ids.begin(), ids.end());
+    }
+    EXPECT_EQ(3U, all_thread_ids.size());
+    EXPECT_NO_THROW(pool.Stop());
+  }
+}
+
 }  // namespace test
 
 }  // namespace maidsafe
@@ -0,0 +1,267 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/binary_log.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+namespace {
+
+using log::detail::BinaryLog;
+using log::detail::BinaryLogEntry;
+using log::detail::CallSiteFile;
+using log::detail::IsDeferrable;
+using log::detail::OstreamBinder;
+
+typedef OstreamBinder<void, void> Stream;
+
+// Collects the entries output by a BinaryLog.  Until Unblock is called, output waits.
+class Collector {
+ public:
+  Collector() : entries_(), mutex_(), unblock_(), unblocked_(unblock_.get_future().share()) {}
+
+  BinaryLog::Output Output() {
+    return [this](const BinaryLogEntry& entry) {
+      unblocked_.wait();
+      std::lock_guard<std::mutex> lock(mutex_);
+      entries_.push_back(entry);
+    };
+  }
+  void Unblock() { unblock_.set_value(); }
+  std::vector<BinaryLogEntry> Entries() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_;
+  }
+
+ private:
+  std::vector<BinaryLogEntry> entries_;
+  std::mutex mutex_;
+  std::promise<void> unblock_;
+  std::shared_future<void> unblocked_;
+};
+
+struct Streamable {};
+
+std::ostream& operator<<(std::ostream& stream, const Streamable&) { return stream << "Streamable"; }
+
+// Checks that a record is output as it would have been by the default backend.
+template <typename Binder>
+void ExpectSameOutput(BinaryLog& binary_log, Collector& collector, CallSiteFile& call_site_file,
+                      const Binder& binder) {
+  std::ostringstream expected;
+  expected << " " << call_site_file.Get(__FILE__).contract_file << binder << "\n";
+  binary_log.Write(log::kSuccess, call_site_file, __FILE__, binder);
+  binary_log.Flush();
+  const auto entries(collector.Entries());
+  ASSERT_FALSE(entries.empty());
+  EXPECT_EQ(expected.str(), entries.back().message);
+  EXPECT_EQ(log::kSuccess, entries.back().level);
+  EXPECT_EQ(std::this_thread::get_id(), entries.back().thread_id);
+  EXPECT_EQ("common", entries.back().project);
+}
+
+// Returns the number following 'prefix' in 'message'.
+int NumberAfter(const std::string& message, const std::string& prefix) {
+  const auto position(message.find(prefix));
+  return position == std::string::npos ? -1 : std::stoi(message.substr(position + prefix.size()));
+}
+
+}  // unnamed namespace
+
+TEST(BinaryLogTest, BEH_Formatting) {
+  static_assert(IsDeferrable<decltype(Stream() << 1 << "a" << std::hex << 2.0)>::value, "");
+  static_assert(!IsDeferrable<decltype(Stream() << 1 << Streamable() << 2)>::value, "");
+  static_assert(!IsDeferrable<decltype(Stream() << 1.0L)>::value, "");
+
+  CallSiteFile call_site_file;
+  Collector collector;
+  collector.Unblock();
+  BinaryLog binary_log(collector.Output(), 1024, BinaryLog::OverflowPolicy::kDrop);
+  const std::string text("std::string");
+  const char* const c_string("C string");
+  char buffer[] = "char array";
+  ExpectSameOutput(binary_log, collector, call_site_file,
+                   Stream() << true << 'c' << static_cast<signed char>('s')
+                            << static_cast<unsigned char>('u') << static_cast<std::int16_t>(-2)
+                            << -3 << 4U << -5L << 6ULL << 1.5F << 0.1 << -1e300 << "literal"
+                            << text << c_string << buffer
+                            << std::numeric_limits<std::int64_t>::min()
+                            << std::numeric_limits<std::uint64_t>::max());
+  // Manipulators apply to the values following them, and integers keep their width.
+  ExpectSameOutput(binary_log, collector, call_site_file,
+                   Stream() << std::hex << -1 << ' ' << static_cast<short>(-1) << ' ' << -1LL
+                            << std::dec << ' ' << 255 << std::boolalpha << ' ' << true
+                            << std::scientific << ' ' << 1.5);
+  // A message with a value of any other type is formatted as a whole before being written.
+  ExpectSameOutput(binary_log, collector, call_site_file,
+                   Stream() << Streamable() << ' ' << std::setw(5) << std::setfill('0') << 42
+                            << ' ' << 1.0L);
+  // Empty messages are fine, as are records larger than a quarter of the ring.
+  ExpectSameOutput(binary_log, collector, call_site_file, Stream());
+  ExpectSameOutput(binary_log, collector, call_site_file, Stream() << std::string(4096, 'a') << 1);
+  EXPECT_EQ(0U, binary_log.Dropped());
+}
+
+TEST(BinaryLogTest, BEH_LargeRecordsKeepOrder) {
+  CallSiteFile call_site_file;
+  Collector collector;
+  BinaryLog binary_log(collector.Output(), 1024, BinaryLog::OverflowPolicy::kBlock);
+  // Output is blocked, so the small records are still in the ring when the large ones are written.
+  const int count(9);
+  for (int i(0); i < count; ++i) {
+    binary_log.Write(log::kInfo, call_site_file, __FILE__,
+                     Stream() << (i % 3 == 1 ? std::string(1024, 'a') : std::string()) << "Message "
+                              << i);
+  }
+  collector.Unblock();
+  binary_log.Flush();
+  const auto entries(collector.Entries());
+  ASSERT_EQ(static_cast<std::size_t>(count), entries.size());
+  for (int i(0); i < count; ++i)
+    EXPECT_EQ(i, NumberAfter(entries[i].message, "Message "));
+}
+
+TEST(BinaryLogTest, BEH_WakesWhenIdle) {
+  CallSiteFile call_site_file;
+  Collector collector;
+  collector.Unblock();
+  BinaryLog binary_log(collector.Output(), 1024, BinaryLog::OverflowPolicy::kDrop);
+  // Each record is written once the background thread has gone back to sleep, so is only output
+  // if the writer wakes it.
+  for (int i(0); i < 5; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    binary_log.Write(log::kInfo, call_site_file, __FILE__, Stream() << "Message " << i);
+    const auto deadline(std::chrono::steady_clock::now() + std::chrono::seconds(10));
+    while (collector.Entries().size() != static_cast<std::size_t>(i + 1) &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(static_cast<std::size_t>(i + 1), collector.Entries().size());
+  }
+}
+
+TEST(BinaryLogTest, BEH_DropWhenFull) {
+  CallSiteFile call_site_file;
+  Collector collector;
+  BinaryLog binary_log(collector.Output(), 1024, BinaryLog::OverflowPolicy::kDrop);
+  // Output is blocked, so the ring fills up and further records are dropped without waiting.
+  const int count(100);
+  for (int i(0); i < count; ++i) {
+    binary_log.Write(log::kInfo, call_site_file, __FILE__, Stream() << "Message " << i);
+  }
+  const std::uint64_t dropped(binary_log.Dropped());
+  EXPECT_LT(0U, dropped);
+  EXPECT_GT(static_cast<std::uint64_t>(count), dropped);
+  collector.Unblock();
+  binary_log.Flush();
+
+  // The records which were written are output in order, followed by a warning about the rest.
+  const auto entries(collector.Entries());
+  ASSERT_EQ(count - dropped + 1, entries.size());
+  int previous(-1);
+  for (std::size_t i(0); i < entries.size() - 1; ++i) {
+    const int index(NumberAfter(entries[i].message, "Message "));
+    EXPECT_LT(previous, index);
+    previous = index;
+  }
+  EXPECT_EQ(log::kWarning, entries.back().level);
+  EXPECT_EQ(static_cast<int>(dropped), NumberAfter(entries.back().message, "Dropped "));
+}
+
+TEST(BinaryLogTest, BEH_BlockWhenFull) {
+  CallSiteFile call_site_file;
+  Collector collector;
+  BinaryLog binary_log(collector.Output(), 1024, BinaryLog::OverflowPolicy::kBlock);
+  const int count(100);
+  std::atomic<int> written(0);
+  std::thread writer([&] {
+    for (int i(0); i < count; ++i) {
+      binary_log.Write(log::kInfo, call_site_file, __FILE__, Stream() << "Message " << i);
+      ++written;
+    }
+  });
+  // Output is blocked, so the writer waits once the ring fills up.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_LT(written.load(), count);
+  collector.Unblock();
+  writer.join();
+  binary_log.Flush();
+
+  EXPECT_EQ(0U, binary_log.Dropped());
+  const auto entries(collector.Entries());
+  ASSERT_EQ(static_cast<std::size_t>(count), entries.size());
+  for (int i(0); i < count; ++i)
+    EXPECT_EQ(i, NumberAfter(entries[i].message, "Message "));
+}
+
+TEST(BinaryLogTest, BEH_ManyThreads) {
+  CallSiteFile call_site_file;
+  const int thread_count(4), count(1000);
+  // A thread's state must be recreated for a new BinaryLog, even if at the same address.
+  for (int run(0); run < 2; ++run) {
+    Collector collector;
+    collector.Unblock();
+    BinaryLog binary_log(collector.Output(), 1024, BinaryLog::OverflowPolicy::kBlock);
+    std::vector<std::thread> threads;
+    for (int i(0); i < thread_count; ++i) {
+      threads.emplace_back([&] {
+        for (int j(0); j < count; ++j)
+          binary_log.Write(log::kInfo, call_site_file, __FILE__, Stream() << "Message " << j);
+      });
+    }
+    binary_log.Write(log::kInfo, call_site_file, __FILE__, Stream() << "Main thread");
+    for (auto& thread : threads)
+      thread.join();
+    binary_log.Flush();
+
+    // Each thread's records are output in the order written.
+    const auto entries(collector.Entries());
+    ASSERT_EQ(static_cast<std::size_t>(thread_count * count + 1), entries.size());
+    std::map<std::thread::id, int> next_index;
+    for (const auto& entry : entries) {
+      if (entry.thread_id == std::this_thread::get_id()) {
+        EXPECT_NE(std::string::npos, entry.message.find("Main thread"));
+      } else {
+        EXPECT_EQ(next_index[entry.thread_id]++, NumberAfter(entry.message, "Message "));
+      }
+    }
+    EXPECT_EQ(static_cast<std::size_t>(thread_count), next_index.size());
+  }
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
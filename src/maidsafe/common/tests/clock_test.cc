@@ -17,6 +17,9 @@
     use of the MaidSafe Software.                                                                 */
 
 #include "maidsafe/common/clock.h"
+
+#include <thread>
+
 #include "maidsafe/common/test.h"
 
 namespace maidsafe {
@@ -33,5 +36,18 @@ TEST(ClockTest, BEH_TimePointConversion) {
   EXPECT_EQ(result, 43);
 }
 
+TEST(ClockTest, BEH_CoarseSteadyClock) {
+  // The coarse clock may lag the precise one by its resolution, but should never lead it.
+  const auto coarse_start(CoarseSteadyClock::now());
+  const auto start(std::chrono::steady_clock::now());
+  EXPECT_LE(coarse_start, start);
+  EXPECT_GT(coarse_start + std::chrono::milliseconds(50), start);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  const auto coarse_end(CoarseSteadyClock::now());
+  EXPECT_LE(coarse_start + std::chrono::milliseconds(50), coarse_end);
+  EXPECT_LE(coarse_end, std::chrono::steady_clock::now());
+}
+
 }  // namespace test
 }  // namespace maidsafe
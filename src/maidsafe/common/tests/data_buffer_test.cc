@@ -18,14 +18,23 @@
 
 #include "maidsafe/common/data_buffer.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <ctime>
+#include <future>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <system_error>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "boost/filesystem/operations.hpp"
 #include "boost/filesystem/path.hpp"
 
+#include "maidsafe/common/asio_service.h"
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/test.h"
 #include "maidsafe/common/utils.h"
@@ -129,6 +138,80 @@ class DataBufferTest : public testing::Test {
 
   std::string DebugKeyName(const KeyType& key) { return data_buffer_->DebugKeyName(key); }
 
+  bool IsInMemory(const KeyType& key) {
+    std::lock_guard<std::mutex> lock(data_buffer_->memory_store_.mutex);
+    return data_buffer_->Find(data_buffer_->memory_store_, key) !=
+           data_buffer_->memory_store_.index.end();
+  }
+
+  // Waits until every value in memory has been copied to disk.
+  bool WaitForCopiesToDisk() {
+    for (int i(0); i != 500; ++i) {
+      {
+        std::lock_guard<std::mutex> lock(data_buffer_->memory_store_.mutex);
+        auto& index(data_buffer_->memory_store_.index);
+        if (std::all_of(index.begin(), index.end(), [](const DataBuffer::MemoryElement& element) {
+              return element.also_on_disk == DataBuffer::StoringState::kCompleted;
+            })) {
+          return true;
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+  }
+
+  // Waits until the background worker has handled all queued promotions.
+  bool WaitForQueuedPromotions() {
+    for (int i(0); i != 500; ++i) {
+      {
+        std::lock_guard<std::mutex> lock(data_buffer_->memory_store_.mutex);
+        if (data_buffer_->queued_promotions_.empty())
+          return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+  }
+
+  // Directly populates then empties the disk index of a DataBuffer, timing the index operations
+  // used by Store, Get, Delete and pop.  Returns the average nanoseconds per operation of each.
+  std::vector<double> TimeDiskIndexOperations(std::size_t entry_count) {
+    using std::chrono::steady_clock;
+    DataBuffer data_buffer(MemoryUsage(0), DiskUsage(0), pop_functor_);
+    std::lock_guard<std::mutex> disk_store_lock(data_buffer.disk_store_.mutex);
+    auto& index(data_buffer.disk_store_.index);
+    const Identity name(MakeIdentity());
+    auto key([&name](std::size_t i) {
+      return KeyType(name, DataTypeId(static_cast<std::uint32_t>(i)));
+    });
+    auto average([entry_count](steady_clock::time_point start) {
+      return static_cast<double>(
+                 std::chrono::duration_cast<std::chrono::nanoseconds>(steady_clock::now() - start)
+                     .count()) /
+             entry_count;
+    });
+    std::vector<double> results;
+
+    auto start(steady_clock::now());
+    for (std::size_t i(0); i < entry_count; ++i)
+      (*index.emplace_back(key(i))).state = DataBuffer::StoringState::kCompleted;
+    results.push_back(average(start));
+
+    start = steady_clock::now();
+    for (std::size_t i(0); i < entry_count; ++i)
+      EXPECT_TRUE(data_buffer.Find(data_buffer.disk_store_, key(i)) != index.end());
+    results.push_back(average(start));
+
+    start = steady_clock::now();
+    for (std::size_t i(0); i < entry_count; i += 2)
+      index.erase(data_buffer.Find(data_buffer.disk_store_, key(i)));
+    while (!index.empty())
+      index.erase(data_buffer.FindOldestOnDisk());
+    results.push_back(average(start));
+    return results;
+  }
+
   MemoryUsage max_memory_usage_;
   DiskUsage max_disk_usage_;
   fs::path data_buffer_path_;
@@ -556,6 +639,698 @@ TEST_F(DataBufferTest, BEH_RandomAsync) {
   data_buffer_.reset();
 }
 
+TEST_F(DataBufferTest, FUNC_IndexScaling) {
+  // With a hashed index, the per-operation cost should remain roughly flat as the index grows.
+  for (std::size_t entry_count : {1000U, 10000U, 100000U, 1000000U}) {
+    auto results(TimeDiskIndexOperations(entry_count));
+    TLOG(kGreen) << entry_count << " entries - insert: " << results[0]
+                 << " ns, find: " << results[1] << " ns, delete / pop oldest: " << results[2]
+                 << " ns\n";
+  }
+}
+
+TEST_F(DataBufferTest, BEH_PromoteOnRead) {
+  for (auto eviction_policy : {DataBuffer::EvictionPolicy::kFifo,
+                               DataBuffer::EvictionPolicy::kLru}) {
+    data_buffer_.reset(new DataBuffer(MemoryUsage(2 * OneKB), DiskUsage(10 * OneKB), pop_functor_,
+                                      DataBuffer::DiskBackend::kFilePerValue, eviction_policy));
+    KeyValueVector key_value_pairs;
+    for (int i(0); i != 6; ++i) {
+      NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+      key_value_pairs.emplace_back(GenerateKeyFromValue(value), value);
+      ASSERT_NO_THROW(data_buffer_->Store(key_value_pairs.back().first, value));
+    }
+    ASSERT_TRUE(WaitForCopiesToDisk());
+    ASSERT_FALSE(IsInMemory(key_value_pairs[0].first));
+
+    EXPECT_EQ(key_value_pairs[0].second, data_buffer_->Get(key_value_pairs[0].first));
+    ASSERT_TRUE(WaitForQueuedPromotions());
+    if (eviction_policy == DataBuffer::EvictionPolicy::kFifo) {
+      EXPECT_FALSE(IsInMemory(key_value_pairs[0].first));
+    } else {
+      EXPECT_TRUE(IsInMemory(key_value_pairs[0].first));
+      // The least recently used of the remaining memory values should have made way for it.
+      EXPECT_FALSE(IsInMemory(key_value_pairs[4].first));
+      EXPECT_TRUE(IsInMemory(key_value_pairs[5].first));
+    }
+    for (const auto& key_value : key_value_pairs)
+      EXPECT_EQ(key_value.second, data_buffer_->Get(key_value.first));
+
+    // A deleted value mustn't be resurrected by a queued promotion.
+    EXPECT_NO_THROW(data_buffer_->Delete(key_value_pairs[1].first));
+    ASSERT_TRUE(WaitForQueuedPromotions());
+    EXPECT_THROW(data_buffer_->Get(key_value_pairs[1].first), common_error);
+  }
+}
+
+TEST_F(DataBufferTest, BEH_LruPopOnDiskBufferOverfill) {
+  for (auto eviction_policy : {DataBuffer::EvictionPolicy::kFifo,
+                               DataBuffer::EvictionPolicy::kLru}) {
+    std::vector<KeyType> popped_keys;
+    data_buffer_.reset(new DataBuffer(
+        MemoryUsage(0), DiskUsage(4 * OneKB),
+        [&](const KeyType& key, const NonEmptyString&) { popped_keys.push_back(key); },
+        DataBuffer::DiskBackend::kFilePerValue, eviction_policy));
+    KeyValueVector key_value_pairs;
+    for (int i(0); i != 5; ++i) {
+      NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+      key_value_pairs.emplace_back(GenerateKeyFromValue(value), value);
+      if (i == 4) {
+        EXPECT_EQ(key_value_pairs[0].second, data_buffer_->Get(key_value_pairs[0].first));
+      }
+      ASSERT_NO_THROW(data_buffer_->Store(key_value_pairs.back().first, value));
+    }
+    ASSERT_EQ(1U, popped_keys.size());
+    if (eviction_policy == DataBuffer::EvictionPolicy::kFifo)
+      EXPECT_EQ(key_value_pairs[0].first, popped_keys[0]);
+    else
+      EXPECT_EQ(key_value_pairs[1].first, popped_keys[0]);
+    data_buffer_.reset();
+  }
+}
+
+TEST_F(DataBufferTest, BEH_TinyLfuAdmission) {
+  data_buffer_.reset(new DataBuffer(MemoryUsage(2 * OneKB), DiskUsage(10 * OneKB), pop_functor_,
+                                    DataBuffer::DiskBackend::kFilePerValue,
+                                    DataBuffer::EvictionPolicy::kTinyLfu));
+  KeyValueVector key_value_pairs;
+  for (int i(0); i != 6; ++i) {
+    NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+    key_value_pairs.emplace_back(GenerateKeyFromValue(value), value);
+    ASSERT_NO_THROW(data_buffer_->Store(key_value_pairs.back().first, value));
+  }
+  ASSERT_TRUE(WaitForCopiesToDisk());
+  // Make the values in memory popular.
+  for (int i(0); i != 5; ++i) {
+    EXPECT_EQ(key_value_pairs[4].second, data_buffer_->Get(key_value_pairs[4].first));
+    EXPECT_EQ(key_value_pairs[5].second, data_buffer_->Get(key_value_pairs[5].first));
+  }
+
+  // A value read once from disk isn't popular enough to displace them.
+  EXPECT_EQ(key_value_pairs[0].second, data_buffer_->Get(key_value_pairs[0].first));
+  ASSERT_TRUE(WaitForQueuedPromotions());
+  EXPECT_FALSE(IsInMemory(key_value_pairs[0].first));
+  EXPECT_TRUE(IsInMemory(key_value_pairs[4].first));
+  EXPECT_TRUE(IsInMemory(key_value_pairs[5].first));
+
+  // Once it's read often enough, it is admitted.
+  for (int i(0); i != 10 && !IsInMemory(key_value_pairs[0].first); ++i) {
+    EXPECT_EQ(key_value_pairs[0].second, data_buffer_->Get(key_value_pairs[0].first));
+    ASSERT_TRUE(WaitForQueuedPromotions());
+  }
+  EXPECT_TRUE(IsInMemory(key_value_pairs[0].first));
+}
+
+TEST_F(DataBufferTest, FUNC_SkewedReads) {
+  // Reads are heavily skewed towards the lower-indexed values, which is where promotion and
+  // frequency-aware admission should pay off.
+  const std::size_t entry_count(1000), memory_entry_count(100), read_count(20000);
+  KeyValueVector key_value_pairs;
+  for (std::size_t i(0); i != entry_count; ++i) {
+    NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+    key_value_pairs.emplace_back(GenerateRandomKey(), value);
+  }
+  std::vector<std::size_t> reads;
+  for (std::size_t i(0); i != read_count; ++i) {
+    double uniform(static_cast<double>(RandomUint32()) / std::numeric_limits<std::uint32_t>::max());
+    reads.push_back(std::min(entry_count - 1, static_cast<std::size_t>(
+        entry_count * uniform * uniform * uniform * uniform)));
+  }
+
+  for (auto eviction_policy : {DataBuffer::EvictionPolicy::kFifo, DataBuffer::EvictionPolicy::kLru,
+                               DataBuffer::EvictionPolicy::kTinyLfu}) {
+    data_buffer_.reset(new DataBuffer(MemoryUsage(memory_entry_count * OneKB),
+                                      DiskUsage(entry_count * OneKB), pop_functor_,
+                                      DataBuffer::DiskBackend::kFilePerValue, eviction_policy));
+    for (const auto& key_value : key_value_pairs)
+      data_buffer_->Store(key_value.first, key_value.second);
+    ASSERT_TRUE(WaitForCopiesToDisk());
+
+    std::size_t memory_hits(0);
+    auto start(std::chrono::steady_clock::now());
+    for (auto index : reads) {
+      if (IsInMemory(key_value_pairs[index].first))
+        ++memory_hits;
+      ASSERT_EQ(key_value_pairs[index].second, data_buffer_->Get(key_value_pairs[index].first));
+    }
+    auto elapsed(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start));
+    const char* const kNames[] = {"FIFO", "LRU", "TinyLFU"};
+    TLOG(kGreen) << kNames[static_cast<int>(eviction_policy)] << ": " << memory_hits << " of "
+                 << read_count << " reads served from memory in " << elapsed.count() << " ms\n";
+  }
+}
+
+TEST_F(DataBufferTest, BEH_SegmentLogPopOnDiskBufferOverfill) {
+  std::mutex mutex;
+  std::vector<KeyType> popped_keys;
+  PopFunctor pop_functor([&](const KeyType& key, const NonEmptyString&) {
+    std::lock_guard<std::mutex> lock(mutex);
+    popped_keys.push_back(key);
+  });
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
+  data_buffer_.reset(new DataBuffer(MemoryUsage(0), DiskUsage(4 * OneKB), pop_functor,
+                                    *test_path / "data_buffer", true,
+                                    DataBuffer::DiskBackend::kSegmentLog));
+  KeyValueVector key_value_pairs;
+  for (int i(0); i != 20; ++i) {
+    NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+    key_value_pairs.emplace_back(GenerateKeyFromValue(value), value);
+    ASSERT_NO_THROW(data_buffer_->Store(key_value_pairs.back().first, value));
+  }
+
+  // Values should have been popped in the order they were stored.
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(16U, popped_keys.size());
+    for (std::size_t i(0); i != popped_keys.size(); ++i)
+      EXPECT_EQ(key_value_pairs[i].first, popped_keys[i]);
+  }
+  for (std::size_t i(0); i != key_value_pairs.size(); ++i) {
+    if (i < 16)
+      EXPECT_THROW(data_buffer_->Get(key_value_pairs[i].first), common_error);
+    else
+      EXPECT_EQ(key_value_pairs[i].second, data_buffer_->Get(key_value_pairs[i].first));
+  }
+  EXPECT_NO_THROW(data_buffer_->Delete(key_value_pairs[16].first));
+  EXPECT_THROW(data_buffer_->Get(key_value_pairs[16].first), common_error);
+  // All values are held in a single segment file.
+  EXPECT_EQ(1, std::distance(fs::directory_iterator(*test_path / "data_buffer"),
+                             fs::directory_iterator()));
+  data_buffer_.reset();
+}
+
+TEST_F(DataBufferTest, FUNC_DiskBackendSpillThroughput) {
+  // With no memory tier, every Store spills to disk and, once full, pops the oldest value.
+  const std::size_t entry_count(5000), disk_entry_count(500);
+  KeyValueVector key_value_pairs;
+  for (std::size_t i(0); i != entry_count; ++i) {
+    NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+    key_value_pairs.emplace_back(GenerateRandomKey(), value);
+  }
+  for (auto disk_backend :
+       {DataBuffer::DiskBackend::kFilePerValue, DataBuffer::DiskBackend::kSegmentLog}) {
+    DataBuffer data_buffer(MemoryUsage(0), DiskUsage(disk_entry_count * OneKB),
+                           [](const KeyType&, const NonEmptyString&) {}, disk_backend);
+    auto start(std::chrono::steady_clock::now());
+    for (const auto& key_value : key_value_pairs)
+      data_buffer.Store(key_value.first, key_value.second);
+    for (std::size_t i(entry_count - disk_entry_count); i != entry_count; ++i)
+      EXPECT_EQ(key_value_pairs[i].second, data_buffer.Get(key_value_pairs[i].first));
+    auto elapsed(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start));
+    TLOG(kGreen) << (disk_backend == DataBuffer::DiskBackend::kSegmentLog ? "Segment log"
+                                                                          : "File per value")
+                 << ": " << entry_count << " spills of " << OneKB << " bytes in "
+                 << elapsed.count() << " ms\n";
+  }
+}
+
+TEST_F(DataBufferTest, BEH_WarmRestart) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
+  const fs::path data_buffer_path(*test_path / "data_buffer");
+  KeyValueVector key_value_pairs;
+  {
+    DataBuffer data_buffer(MemoryUsage(0), DiskUsage(10 * OneKB), pop_functor_, data_buffer_path);
+    for (int i(0); i != 6; ++i) {
+      NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+      key_value_pairs.emplace_back(GenerateKeyFromValue(value), value);
+      ASSERT_NO_THROW(data_buffer.Store(key_value_pairs.back().first, value));
+    }
+  }
+  // Give the files distinct write times so that their age order is unambiguous, and add a file
+  // which doesn't represent a value.
+  const std::time_t now(std::time(nullptr));
+  for (std::size_t i(0); i != key_value_pairs.size(); ++i) {
+    fs::last_write_time(data_buffer_path / maidsafe::detail::GetFileName(key_value_pairs[i].first),
+                        now - 100 + static_cast<std::time_t>(i));
+  }
+  ASSERT_TRUE(WriteFile(data_buffer_path / "NotAValue", RandomBytes(10)));
+
+  // Without recovery, existing values are ignored.
+  {
+    DataBuffer data_buffer(MemoryUsage(0), DiskUsage(10 * OneKB), pop_functor_, data_buffer_path);
+    EXPECT_THROW(data_buffer.Get(key_value_pairs[0].first), common_error);
+  }
+  EXPECT_THROW(DataBuffer(MemoryUsage(0), DiskUsage(10 * OneKB), pop_functor_, data_buffer_path,
+                          false, DataBuffer::DiskBackend::kSegmentLog,
+                          DataBuffer::EvictionPolicy::kFifo, DataBuffer::ExistingValues::kRecover),
+               common_error);
+
+  // Recovering into a smaller buffer pops the oldest values.
+  std::vector<KeyType> popped_keys;
+  PopFunctor pop_functor([&](const KeyType& key, const NonEmptyString& value) {
+    popped_keys.push_back(key);
+    EXPECT_EQ(key_value_pairs[popped_keys.size() - 1].second, value);
+  });
+  DataBuffer data_buffer(MemoryUsage(0), DiskUsage(4 * OneKB), pop_functor, data_buffer_path, false,
+                         DataBuffer::DiskBackend::kFilePerValue, DataBuffer::EvictionPolicy::kFifo,
+                         DataBuffer::ExistingValues::kRecover);
+  ASSERT_EQ(2U, popped_keys.size());
+  EXPECT_EQ(key_value_pairs[0].first, popped_keys[0]);
+  EXPECT_EQ(key_value_pairs[1].first, popped_keys[1]);
+  EXPECT_THROW(data_buffer.Get(key_value_pairs[1].first), common_error);
+  for (std::size_t i(2); i != key_value_pairs.size(); ++i)
+    EXPECT_EQ(key_value_pairs[i].second, data_buffer.Get(key_value_pairs[i].first));
+  EXPECT_TRUE(fs::exists(data_buffer_path / "NotAValue"));
+
+  // Recovered values are accounted for, so the next Store pops the oldest of them.
+  NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+  ASSERT_NO_THROW(data_buffer.Store(GenerateKeyFromValue(value), value));
+  ASSERT_EQ(3U, popped_keys.size());
+  EXPECT_EQ(key_value_pairs[2].first, popped_keys[2]);
+}
+
+TEST_F(DataBufferTest, FUNC_WarmRestartScaling) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
+  const fs::path data_buffer_path(*test_path / "data_buffer");
+  const std::size_t entry_count(20000);
+  KeyValueVector key_value_pairs;
+  {
+    DataBuffer data_buffer(MemoryUsage(0), DiskUsage(entry_count * 100), pop_functor_,
+                           data_buffer_path);
+    for (std::size_t i(0); i != entry_count; ++i) {
+      key_value_pairs.emplace_back(GenerateRandomKey(), NonEmptyString(RandomBytes(100)));
+      data_buffer.Store(key_value_pairs.back().first, key_value_pairs.back().second);
+    }
+  }
+  auto start(std::chrono::steady_clock::now());
+  DataBuffer data_buffer(MemoryUsage(0), DiskUsage(entry_count * 100), pop_functor_,
+                         data_buffer_path, false, DataBuffer::DiskBackend::kFilePerValue,
+                         DataBuffer::EvictionPolicy::kFifo, DataBuffer::ExistingValues::kRecover);
+  auto elapsed(std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start));
+  TLOG(kGreen) << "Recovered " << entry_count << " values in " << elapsed.count() << " ms\n";
+  for (std::size_t i(0); i < entry_count; i += 100)
+    EXPECT_EQ(key_value_pairs[i].second, data_buffer.Get(key_value_pairs[i].first));
+}
+
+TEST_F(DataBufferTest, BEH_SharedValues) {
+  data_buffer_.reset(new DataBuffer(MemoryUsage(2 * OneKB), DiskUsage(10 * OneKB), pop_functor_));
+  EXPECT_THROW(data_buffer_->Store(GenerateRandomKey(), DataBuffer::SharedValue()), common_error);
+
+  auto value(std::make_shared<const NonEmptyString>(
+      RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB))));
+  auto key(GenerateKeyFromValue(*value));
+  ASSERT_NO_THROW(data_buffer_->Store(key, value));
+  // While in memory, the stored value itself is returned.
+  EXPECT_EQ(value, data_buffer_->GetShared(key));
+  EXPECT_EQ(*value, data_buffer_->Get(key));
+
+  // Once evicted from memory, an equal value is read from disk.
+  for (int i(0); i != 2; ++i) {
+    NonEmptyString other(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+    data_buffer_->Store(GenerateKeyFromValue(other), other);
+  }
+  ASSERT_TRUE(WaitForCopiesToDisk());
+  EXPECT_FALSE(IsInMemory(key));
+  auto recovered(data_buffer_->GetShared(key));
+  EXPECT_NE(value, recovered);
+  EXPECT_EQ(*value, *recovered);
+}
+
+TEST_F(DataBufferTest, FUNC_SharedValueMemoryHits) {
+  const std::uint32_t kValueSize(1024 * 1024);
+  const int kGetCount(1000);
+  data_buffer_.reset(new DataBuffer(MemoryUsage(2 * kValueSize), DiskUsage(4 * kValueSize),
+                                    pop_functor_));
+  auto value(std::make_shared<const NonEmptyString>(RandomBytes(kValueSize)));
+  auto key(GenerateKeyFromValue(*value));
+  data_buffer_->Store(key, value);
+
+  auto start(std::chrono::steady_clock::now());
+  for (int i(0); i != kGetCount; ++i)
+    ASSERT_EQ(kValueSize, data_buffer_->Get(key).string().size());
+  auto copying(std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start));
+  start = std::chrono::steady_clock::now();
+  for (int i(0); i != kGetCount; ++i)
+    ASSERT_EQ(kValueSize, data_buffer_->GetShared(key)->string().size());
+  auto sharing(std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start));
+  TLOG(kGreen) << kGetCount << " memory hits of " << kValueSize << " bytes: Get took "
+               << copying.count() << " us, GetShared took " << sharing.count() << " us\n";
+}
+
+TEST_F(DataBufferTest, BEH_AsyncStoreGetDelete) {
+  AsioService asio_service(2);
+  NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+  auto key(GenerateKeyFromValue(value));
+  data_buffer_.reset(new DataBuffer(MemoryUsage(OneKB), DiskUsage(4 * OneKB), pop_functor_));
+
+  EXPECT_NO_THROW(data_buffer_->StoreAsync(asio_service, key, value).get());
+  EXPECT_EQ(value, data_buffer_->GetAsync(asio_service, key).get());
+  EXPECT_NO_THROW(data_buffer_->DeleteAsync(asio_service, key).get());
+  EXPECT_THROW(data_buffer_->GetAsync(asio_service, key).get(), common_error);
+
+  // Handlers receive the error code rather than an exception.
+  std::promise<std::error_code> get_result;
+  data_buffer_->GetAsync(asio_service, key, [&](std::error_code error, NonEmptyString) {
+    get_result.set_value(error);
+  });
+  EXPECT_EQ(make_error_code(CommonErrors::no_such_element), get_result.get_future().get());
+  std::promise<std::error_code> store_result;
+  data_buffer_->StoreAsync(asio_service, key, value,
+                           [&](std::error_code error) { store_result.set_value(error); });
+  EXPECT_FALSE(store_result.get_future().get());
+  std::promise<NonEmptyString> got_value;
+  data_buffer_->GetAsync(asio_service, key, [&](std::error_code error, NonEmptyString recovered) {
+    EXPECT_FALSE(error);
+    got_value.set_value(recovered);
+  });
+  EXPECT_EQ(value, got_value.get_future().get());
+  data_buffer_.reset();
+}
+
+TEST_F(DataBufferTest, BEH_AsyncStoreUnderMemoryPressure) {
+  // Each Store has to wait for the previous value to be copied to disk before it fits in memory.
+  AsioService asio_service(2);
+  data_buffer_.reset(new DataBuffer(MemoryUsage(2 * OneKB), DiskUsage(200 * OneKB), pop_functor_));
+  KeyValueVector key_value_pairs;
+  std::vector<std::future<void>> stores;
+  for (int i(0); i != 100; ++i) {
+    NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+    key_value_pairs.emplace_back(GenerateKeyFromValue(value), value);
+    stores.emplace_back(
+        data_buffer_->StoreAsync(asio_service, key_value_pairs.back().first, value));
+  }
+  for (auto& store : stores)
+    EXPECT_NO_THROW(store.get());
+  for (const auto& key_value : key_value_pairs)
+    EXPECT_EQ(key_value.second, data_buffer_->GetAsync(asio_service, key_value.first).get());
+  data_buffer_.reset();
+}
+
+TEST_F(DataBufferTest, BEH_AsyncStoreDoesNotBlockWhenFull) {
+  // A single thread, so any blocking call would prevent the later operations from running.
+  AsioService asio_service(1);
+  data_buffer_.reset(new DataBuffer(MemoryUsage(0), DiskUsage(2 * OneKB), pop_functor_));
+  KeyValueVector key_value_pairs;
+  for (int i(0); i != 3; ++i) {
+    NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+    key_value_pairs.emplace_back(GenerateKeyFromValue(value), value);
+  }
+  data_buffer_->Store(key_value_pairs[0].first, key_value_pairs[0].second);
+  data_buffer_->Store(key_value_pairs[1].first, key_value_pairs[1].second);
+
+  // The disk is full and there's no pop functor, so this has to wait for a Delete.
+  auto stored(data_buffer_->StoreAsync(asio_service, key_value_pairs[2].first,
+                                       key_value_pairs[2].second));
+  EXPECT_EQ(std::future_status::timeout, stored.wait_for(std::chrono::milliseconds(100)));
+  EXPECT_EQ(key_value_pairs[1].second,
+            data_buffer_->GetAsync(asio_service, key_value_pairs[1].first).get());
+  EXPECT_EQ(std::future_status::timeout, stored.wait_for(std::chrono::milliseconds(0)));
+
+  EXPECT_NO_THROW(data_buffer_->DeleteAsync(asio_service, key_value_pairs[0].first).get());
+  ASSERT_EQ(std::future_status::ready, stored.wait_for(std::chrono::seconds(2)));
+  EXPECT_NO_THROW(stored.get());
+  EXPECT_EQ(key_value_pairs[2].second,
+            data_buffer_->GetAsync(asio_service, key_value_pairs[2].first).get());
+  data_buffer_.reset();
+}
+
+TEST_F(DataBufferTest, BEH_AsyncOperationsFailOnDestruction) {
+  AsioService asio_service(1);
+  data_buffer_.reset(new DataBuffer(MemoryUsage(0), DiskUsage(OneKB), pop_functor_));
+  NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+  data_buffer_->Store(GenerateKeyFromValue(value), value);
+
+  std::vector<std::future<void>> stores;
+  for (int i(0); i != 10; ++i) {
+    NonEmptyString waiting_value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+    stores.emplace_back(
+        data_buffer_->StoreAsync(asio_service, GenerateKeyFromValue(waiting_value), waiting_value));
+  }
+  EXPECT_EQ(std::future_status::timeout, stores.back().wait_for(std::chrono::milliseconds(100)));
+  data_buffer_.reset();
+  for (auto& store : stores) {
+    ASSERT_EQ(std::future_status::ready, store.wait_for(std::chrono::seconds(0)));
+    EXPECT_THROW(store.get(), common_error);
+  }
+}
+
+TEST_F(DataBufferTest, BEH_StoreGetDeleteBatch) {
+  data_buffer_.reset(new DataBuffer(MemoryUsage(4 * OneKB), DiskUsage(20 * OneKB), pop_functor_));
+  // Most values fit in memory; the last is too large for memory so goes straight to disk.
+  KeyValueVector key_value_pairs;
+  std::vector<KeyType> keys;
+  for (int i(0); i != 12; ++i) {
+    NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(i == 11 ? 5 * OneKB
+                                                                                    : OneKB)));
+    keys.push_back(GenerateKeyFromValue(value));
+    key_value_pairs.emplace_back(keys.back(), value);
+  }
+  EXPECT_NO_THROW(data_buffer_->StoreBatch(key_value_pairs));
+
+  std::vector<KeyType> requested_keys(keys);
+  requested_keys.push_back(GenerateRandomKey());
+  auto values(data_buffer_->GetBatch(requested_keys));
+  ASSERT_EQ(requested_keys.size(), values.size());
+  for (std::size_t i(0); i != key_value_pairs.size(); ++i) {
+    ASSERT_TRUE(values[i] != nullptr);
+    EXPECT_EQ(key_value_pairs[i].second, *values[i]);
+  }
+  EXPECT_TRUE(values.back() == nullptr);
+
+  // Storing again replaces the existing values.
+  key_value_pairs[0].second = NonEmptyString(RandomAlphaNumericBytes(10));
+  EXPECT_NO_THROW(data_buffer_->StoreBatch(KeyValueVector(1, key_value_pairs[0])));
+  EXPECT_EQ(key_value_pairs[0].second, data_buffer_->Get(keys[0]));
+  EXPECT_THROW(data_buffer_->StoreBatch(std::vector<std::pair<KeyType, DataBuffer::SharedValue>>(
+                   1, std::make_pair(keys[0], DataBuffer::SharedValue()))),
+               common_error);
+
+  // Keys which aren't held are ignored.
+  std::vector<KeyType> keys_to_delete(keys.begin(), keys.begin() + 6);
+  keys_to_delete.push_back(GenerateRandomKey());
+  keys_to_delete.push_back(keys.back());
+  EXPECT_NO_THROW(data_buffer_->DeleteBatch(keys_to_delete));
+  EXPECT_NO_THROW(data_buffer_->DeleteBatch(keys_to_delete));
+  values = data_buffer_->GetBatch(keys);
+  for (std::size_t i(0); i != keys.size(); ++i) {
+    if (i < 6 || i == keys.size() - 1) {
+      EXPECT_TRUE(values[i] == nullptr);
+      EXPECT_THROW(data_buffer_->Get(keys[i]), common_error);
+    } else {
+      ASSERT_TRUE(values[i] != nullptr);
+      EXPECT_EQ(key_value_pairs[i].second, *values[i]);
+    }
+  }
+}
+
+TEST_F(DataBufferTest, BEH_StoreBatchDuplicateKeys) {
+  data_buffer_.reset(new DataBuffer(MemoryUsage(4 * OneKB), DiskUsage(20 * OneKB), pop_functor_));
+  const KeyType key(GenerateRandomKey()), other_key(GenerateRandomKey());
+  const NonEmptyString first_value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB))),
+      last_value(RandomAlphaNumericBytes(10)), other_value(RandomAlphaNumericBytes(20));
+  KeyValueVector key_value_pairs{std::make_pair(key, first_value),
+                                 std::make_pair(other_key, other_value),
+                                 std::make_pair(key, last_value)};
+  // The last value given for a key wins, and only one entry is held for it.
+  EXPECT_NO_THROW(data_buffer_->StoreBatch(key_value_pairs));
+  EXPECT_EQ(last_value, data_buffer_->Get(key));
+  EXPECT_EQ(other_value, data_buffer_->Get(other_key));
+  auto stats(data_buffer_->Stats());
+  EXPECT_EQ(2U, stats.memory.entries);
+  EXPECT_EQ(last_value.string().size() + other_value.string().size(), stats.memory.bytes);
+
+  EXPECT_NO_THROW(data_buffer_->Delete(key));
+  EXPECT_FALSE(data_buffer_->Has(key));
+  EXPECT_THROW(data_buffer_->Get(key), common_error);
+  stats = data_buffer_->Stats();
+  EXPECT_EQ(1U, stats.memory.entries);
+  EXPECT_EQ(other_value.string().size(), stats.memory.bytes);
+}
+
+TEST_F(DataBufferTest, BEH_TryGetAndHas) {
+  // Run with and without the negative lookup filter.
+  for (std::size_t expected_key_count : {0, 100}) {
+    std::vector<KeyType> popped_keys;
+    data_buffer_.reset(new DataBuffer(
+        MemoryUsage(2 * OneKB), DiskUsage(6 * OneKB),
+        [&](const KeyType& key, const NonEmptyString&) { popped_keys.push_back(key); },
+        DataBuffer::DiskBackend::kFilePerValue, DataBuffer::EvictionPolicy::kFifo,
+        expected_key_count));
+    KeyValueVector key_value_pairs;
+    for (int i(0); i != 10; ++i) {
+      NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+      key_value_pairs.emplace_back(GenerateKeyFromValue(value), value);
+      data_buffer_->Store(key_value_pairs.back().first, value);
+    }
+    // Only 6 values fit on disk, so the oldest have been popped.
+    ASSERT_FALSE(popped_keys.empty());
+    for (const auto& key_value : key_value_pairs) {
+      bool popped(std::find(popped_keys.begin(), popped_keys.end(), key_value.first) !=
+                  popped_keys.end());
+      auto value(data_buffer_->TryGet(key_value.first));
+      EXPECT_EQ(!popped, data_buffer_->Has(key_value.first));
+      if (popped) {
+        EXPECT_FALSE(value);
+        EXPECT_THROW(data_buffer_->Get(key_value.first), common_error);
+      } else {
+        ASSERT_TRUE(value);
+        EXPECT_EQ(key_value.second, *value);
+      }
+    }
+
+    auto missing_key(GenerateRandomKey());
+    EXPECT_FALSE(data_buffer_->TryGet(missing_key));
+    EXPECT_FALSE(data_buffer_->Has(missing_key));
+    EXPECT_THROW(data_buffer_->Get(missing_key), common_error);
+    EXPECT_TRUE(data_buffer_->GetBatch(std::vector<KeyType>(1, missing_key))[0] == nullptr);
+
+    const auto& last(key_value_pairs.back());
+    data_buffer_->Delete(last.first);
+    EXPECT_FALSE(data_buffer_->TryGet(last.first));
+    EXPECT_FALSE(data_buffer_->Has(last.first));
+    data_buffer_->Store(last.first, last.second);
+    EXPECT_EQ(last.second, *data_buffer_->TryGet(last.first));
+    EXPECT_TRUE(data_buffer_->Has(last.first));
+  }
+}
+
+TEST_F(DataBufferTest, FUNC_NegativeLookups) {
+  const int kKeyCount(1000), kLookupCount(100000);
+  using std::chrono::steady_clock;
+  std::vector<KeyType> missing_keys;
+  for (int i(0); i != kLookupCount; ++i)
+    missing_keys.push_back(GenerateRandomKey());
+  for (std::size_t expected_key_count : {0, kKeyCount}) {
+    data_buffer_.reset(new DataBuffer(MemoryUsage(kKeyCount * OneKB / 2),
+                                      DiskUsage(2 * kKeyCount * OneKB), pop_functor_,
+                                      DataBuffer::DiskBackend::kFilePerValue,
+                                      DataBuffer::EvictionPolicy::kFifo, expected_key_count));
+    for (int i(0); i != kKeyCount; ++i)
+      data_buffer_->Store(GenerateRandomKey(), NonEmptyString(RandomBytes(OneKB)));
+
+    auto start(steady_clock::now());
+    int hits(0);
+    for (const auto& key : missing_keys) {
+      if (data_buffer_->TryGet(key))
+        ++hits;
+    }
+    auto elapsed(
+        std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() - start));
+    EXPECT_EQ(0, hits);
+    TLOG(kGreen) << kLookupCount << " TryGet misses "
+                 << (expected_key_count == 0 ? "without" : "with") << " filter took "
+                 << elapsed.count() << " us\n";
+  }
+}
+
+TEST_F(DataBufferTest, BEH_Stats) {
+  std::atomic<int> popped(0);
+  data_buffer_.reset(new DataBuffer(
+      MemoryUsage(2 * OneKB), DiskUsage(4 * OneKB),
+      [&](const KeyType&, const NonEmptyString&) { ++popped; }));
+  auto stats(data_buffer_->Stats());
+  EXPECT_EQ(0U, stats.memory.bytes + stats.memory.entries + stats.disk.bytes + stats.disk.entries);
+  EXPECT_EQ(0U, stats.stores + stats.memory_hits + stats.disk_hits + stats.misses);
+
+  KeyValueVector key_value_pairs;
+  for (int i(0); i != 8; ++i) {
+    NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+    key_value_pairs.emplace_back(GenerateKeyFromValue(value), value);
+    data_buffer_->Store(key_value_pairs.back().first, value);
+  }
+  // Wait for the worker to copy everything in memory to disk.
+  while (data_buffer_->Stats().copy_backlog.entries != 0)
+    Sleep(std::chrono::milliseconds(1));
+  EXPECT_EQ(key_value_pairs.back().second, data_buffer_->Get(key_value_pairs.back().first));
+  EXPECT_EQ(key_value_pairs[4].second, data_buffer_->Get(key_value_pairs[4].first));
+  EXPECT_FALSE(data_buffer_->TryGet(GenerateRandomKey()));
+  EXPECT_THROW(data_buffer_->Get(key_value_pairs[0].first), common_error);
+  data_buffer_->Delete(key_value_pairs.back().first);
+
+  stats = data_buffer_->Stats();
+  EXPECT_EQ(8U, stats.stores);
+  EXPECT_EQ(1U, stats.memory_hits);
+  EXPECT_EQ(1U, stats.disk_hits);
+  EXPECT_EQ(2U, stats.misses);
+  EXPECT_EQ(1U, stats.deletes);
+  // Only 4 values fit on disk, so the first 4 have been popped.
+  EXPECT_EQ(4, popped.load());
+  EXPECT_EQ(4U, stats.pops);
+  EXPECT_EQ(4 * OneKB, stats.popped_bytes);
+  EXPECT_EQ(8U, stats.spills);
+  EXPECT_EQ(8 * OneKB, stats.spilled_bytes);
+  EXPECT_EQ(6U, stats.memory_evictions);
+  EXPECT_EQ(1U, stats.memory.entries);
+  EXPECT_EQ(OneKB, stats.memory.bytes);
+  EXPECT_EQ(3U, stats.disk.entries);
+  EXPECT_EQ(3 * OneKB, stats.disk.bytes);
+  EXPECT_EQ(0U, stats.copy_backlog.bytes);
+  EXPECT_EQ(8U, stats.store_latency.count);
+  EXPECT_EQ(2U, stats.get_latency.count);
+  EXPECT_EQ(8U, stats.spill_latency.count);
+  EXPECT_LE(stats.store_latency.Percentile(50), stats.store_latency.max);
+  EXPECT_LT(std::chrono::nanoseconds(0), stats.disk_wait_time);
+}
+
+TEST_F(DataBufferTest, BEH_StatsReplacingIsNotDeleting) {
+  data_buffer_.reset(new DataBuffer(MemoryUsage(OneKB), DiskUsage(4 * OneKB), pop_functor_));
+  const KeyType key(GenerateRandomKey());
+  data_buffer_->Store(key, NonEmptyString(RandomAlphaNumericBytes(10)));
+  data_buffer_->Store(key, NonEmptyString(RandomAlphaNumericBytes(10)));
+  auto stats(data_buffer_->Stats());
+  EXPECT_EQ(2U, stats.stores);
+  EXPECT_EQ(0U, stats.deletes);
+  data_buffer_->Delete(key);
+  stats = data_buffer_->Stats();
+  EXPECT_EQ(1U, stats.deletes);
+}
+
+TEST_F(DataBufferTest, FUNC_BatchThroughput) {
+  const std::size_t kBatchSize(64);
+  using std::chrono::steady_clock;
+  auto elapsed_us([](steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() - start)
+        .count();
+  });
+  for (std::uint32_t value_size : {4 * 1024U, 64 * 1024U, 1024 * 1024U}) {
+    KeyValueVector key_value_pairs;
+    std::vector<KeyType> keys;
+    for (std::size_t i(0); i != kBatchSize; ++i) {
+      key_value_pairs.emplace_back(GenerateRandomKey(), NonEmptyString(RandomBytes(value_size)));
+      keys.push_back(key_value_pairs.back().first);
+    }
+    // Memory holds half the values so that the rest are spilled to disk by the worker.
+    const MemoryUsage memory_usage(kBatchSize * value_size / 2);
+    const DiskUsage disk_usage(2 * kBatchSize * value_size);
+
+    data_buffer_.reset(new DataBuffer(memory_usage, disk_usage, pop_functor_));
+    auto start(steady_clock::now());
+    for (const auto& key_value : key_value_pairs)
+      data_buffer_->Store(key_value.first, key_value.second);
+    auto per_key_store(elapsed_us(start));
+    start = steady_clock::now();
+    for (const auto& key : keys)
+      ASSERT_EQ(value_size, data_buffer_->Get(key).string().size());
+    auto per_key_get(elapsed_us(start));
+    start = steady_clock::now();
+    for (const auto& key : keys)
+      data_buffer_->Delete(key);
+    auto per_key_delete(elapsed_us(start));
+
+    data_buffer_.reset(new DataBuffer(memory_usage, disk_usage, pop_functor_));
+    start = steady_clock::now();
+    data_buffer_->StoreBatch(key_value_pairs);
+    auto batch_store(elapsed_us(start));
+    start = steady_clock::now();
+    auto values(data_buffer_->GetBatch(keys));
+    auto batch_get(elapsed_us(start));
+    for (const auto& value : values)
+      ASSERT_EQ(value_size, value->string().size());
+    start = steady_clock::now();
+    data_buffer_->DeleteBatch(keys);
+    auto batch_delete(elapsed_us(start));
+
+    TLOG(kGreen) << kBatchSize << " values of " << value_size << " bytes - per-key vs batch (us):"
+                 << "  Store " << per_key_store << " vs " << batch_store << ",  Get "
+                 << per_key_get << " vs " << batch_get << ",  Delete " << per_key_delete << " vs "
+                 << batch_delete << "\n";
+  }
+}
 
 namespace {
 
@@ -0,0 +1,179 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/executor_stats.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/active.h"
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(ExecutorStatsTest, BEH_Counts) {
+  ExecutorStats stats("Test");
+  const auto queued_time(stats.Queued());
+  stats.Queued();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  {
+    const maidsafe::detail::ExecutorRunScope run_scope(stats, queued_time);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  auto snapshot(stats.GetSnapshot());
+  EXPECT_EQ("Test", snapshot.name);
+  EXPECT_EQ(2U, snapshot.queued);
+  EXPECT_EQ(1U, snapshot.completed);
+  EXPECT_EQ(1U, snapshot.backlog);
+  EXPECT_EQ(2U, snapshot.max_backlog);
+  EXPECT_EQ(1U, snapshot.queue_wait.count);
+  EXPECT_LE(std::chrono::milliseconds(10), snapshot.queue_wait.max);
+  EXPECT_EQ(1U, snapshot.run_time.count);
+  EXPECT_LE(std::chrono::milliseconds(20), snapshot.run_time.max);
+
+  // The end of a run is recorded even if the handler throws.
+  auto throwing_handler(maidsafe::detail::InstrumentedHandler<std::function<void()>>(
+      stats, [] { throw std::runtime_error("Test"); }));
+  EXPECT_THROW(throwing_handler(), std::runtime_error);
+  snapshot = stats.GetSnapshot();
+  EXPECT_EQ(3U, snapshot.queued);
+  EXPECT_EQ(2U, snapshot.completed);
+
+  std::ostringstream summary;
+  summary << snapshot;
+  EXPECT_EQ(0U, summary.str().find("Test: 3 queued, 2 completed, backlog 1 (max 2)"))
+      << summary.str();
+}
+
+TEST(ExecutorStatsTest, BEH_BacklogNeverNegative) {
+  // Each thread queues and runs its own handlers, while snapshots are taken from another.
+  ExecutorStats stats("Concurrent");
+  const int thread_count(4), count(10000);
+  std::atomic<bool> done(false);
+  std::thread observer([&] {
+    while (!done) {
+      const auto snapshot(stats.GetSnapshot());
+      ASSERT_LE(snapshot.backlog, static_cast<std::uint64_t>(thread_count));
+      ASSERT_LE(snapshot.max_backlog, static_cast<std::uint64_t>(thread_count));
+    }
+  });
+  std::vector<std::thread> threads;
+  for (int i(0); i < thread_count; ++i) {
+    threads.emplace_back([&] {
+      for (int j(0); j < count; ++j)
+        const maidsafe::detail::ExecutorRunScope run_scope(stats, stats.Queued());
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  done = true;
+  observer.join();
+  const auto snapshot(stats.GetSnapshot());
+  EXPECT_EQ(static_cast<std::uint64_t>(thread_count * count), snapshot.completed);
+  EXPECT_EQ(0U, snapshot.backlog);
+  EXPECT_GE(static_cast<std::uint64_t>(thread_count), snapshot.max_backlog);
+}
+
+TEST(ExecutorStatsTest, BEH_AsioService) {
+  auto stats(std::make_shared<ExecutorStats>("AsioService"));
+  AsioService asio_service(1, stats);
+  EXPECT_EQ(stats, asio_service.Stats());
+  // Block the only thread so that the following handlers queue up behind it.
+  std::promise<void> unblock;
+  std::shared_future<void> unblocked(unblock.get_future().share());
+  asio_service.Post([unblocked] { unblocked.wait(); });
+  for (int i(0); i < 9; ++i)
+    asio_service.Post([] {});
+  EXPECT_EQ(10U, stats->GetSnapshot().backlog);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  unblock.set_value();
+  asio_service.Stop();
+
+  const auto snapshot(stats->GetSnapshot());
+  EXPECT_EQ(10U, snapshot.completed);
+  EXPECT_EQ(0U, snapshot.backlog);
+  EXPECT_EQ(10U, snapshot.max_backlog);
+  EXPECT_LE(std::chrono::milliseconds(20), snapshot.queue_wait.max);
+  EXPECT_LE(std::chrono::milliseconds(20), snapshot.run_time.max);
+
+  AsioService uninstrumented(1);
+  EXPECT_TRUE(uninstrumented.Stats() == nullptr);
+}
+
+TEST(ExecutorStatsTest, BEH_Active) {
+  auto stats(std::make_shared<ExecutorStats>("Active"));
+  {
+    Active active(stats);
+    for (int i(0); i < 100; ++i)
+      active.Send([] {});
+  }
+  // Includes the functor sent by the destructor.
+  const auto snapshot(stats->GetSnapshot());
+  EXPECT_EQ(101U, snapshot.queued);
+  EXPECT_EQ(101U, snapshot.completed);
+  EXPECT_EQ(101U, snapshot.run_time.count);
+}
+
+TEST(ExecutorStatsTest, BEH_Reporter) {
+  auto stats(std::make_shared<ExecutorStats>("Reporter"));
+  EXPECT_THROW(ExecutorStatsReporter({stats}, std::chrono::seconds(0)), maidsafe_error);
+  ExecutorStatsReporter reporter({stats}, std::chrono::milliseconds(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  reporter.Report();
+}
+
+namespace {
+
+// Returns the mean time in nanoseconds to post and run each of 'count' handlers.
+double PostTime(AsioService& asio_service, int count) {
+  std::promise<void> done;
+  const auto start(std::chrono::steady_clock::now());
+  for (int i(0); i < count - 1; ++i)
+    asio_service.Post([] {});
+  asio_service.Post([&done] { done.set_value(); });
+  done.get_future().wait();
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+             .count() / count;
+}
+
+}  // unnamed namespace
+
+TEST(ExecutorStatsTest, FUNC_Overhead) {
+  const int count(1 << 20);
+  AsioService plain(1);
+  AsioService instrumented(1, std::make_shared<ExecutorStats>("Instrumented"));
+  TLOG(kGreen) << "Post and run: " << PostTime(plain, count) << " ns uninstrumented, "
+               << PostTime(instrumented, count) << " ns instrumented\n";
+  TLOG(kGreen) << instrumented.Stats()->GetSnapshot() << '\n';
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
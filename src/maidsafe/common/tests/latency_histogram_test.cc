@@ -0,0 +1,113 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/latency_histogram.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+using Duration = LatencyHistogram::Duration;
+
+TEST(LatencyHistogramTest, BEH_Buckets) {
+  // Buckets are contiguous and cover the full range.
+  EXPECT_EQ(Duration(0), LatencyHistogram::BucketLowerBound(0));
+  for (std::size_t i(1); i != LatencyHistogram::kBucketCount; ++i) {
+    ASSERT_EQ(LatencyHistogram::BucketUpperBound(i - 1) + Duration(1),
+              LatencyHistogram::BucketLowerBound(i));
+    ASSERT_LE(LatencyHistogram::BucketLowerBound(i), LatencyHistogram::BucketUpperBound(i));
+    // The width of each bucket is at most 1/8 of its lower bound.
+    ASSERT_LE((LatencyHistogram::BucketUpperBound(i) - LatencyHistogram::BucketLowerBound(i)) * 8,
+              LatencyHistogram::BucketLowerBound(i));
+  }
+  EXPECT_EQ(Duration::max(),
+            LatencyHistogram::BucketUpperBound(LatencyHistogram::kBucketCount - 1));
+
+  for (std::size_t i(0); i != LatencyHistogram::kBucketCount; ++i) {
+    ASSERT_EQ(i, LatencyHistogram::BucketIndex(LatencyHistogram::BucketLowerBound(i)));
+    ASSERT_EQ(i, LatencyHistogram::BucketIndex(LatencyHistogram::BucketUpperBound(i)));
+  }
+  EXPECT_EQ(0U, LatencyHistogram::BucketIndex(Duration(-5)));
+}
+
+TEST(LatencyHistogramTest, BEH_RecordAndSnapshot) {
+  LatencyHistogram histogram;
+  auto empty(histogram.GetSnapshot());
+  EXPECT_EQ(0U, empty.count);
+  EXPECT_EQ(Duration(0), empty.Percentile(50));
+  EXPECT_EQ(Duration(0), empty.Mean());
+
+  // 1us to 1000us in steps of 1us.
+  for (int i(1); i <= 1000; ++i)
+    histogram.Record(std::chrono::microseconds(i));
+  auto snapshot(histogram.GetSnapshot());
+  EXPECT_EQ(1000U, snapshot.count);
+  EXPECT_EQ(std::chrono::microseconds(1000), snapshot.max);
+  EXPECT_EQ(std::chrono::nanoseconds(500500), snapshot.Mean());
+  for (double percentile : {1.0, 10.0, 50.0, 90.0, 99.0, 99.9}) {
+    const auto expected(std::chrono::duration_cast<Duration>(
+        std::chrono::duration<double, std::micro>(percentile * 10)));
+    EXPECT_LE(expected, snapshot.Percentile(percentile)) << percentile;
+    EXPECT_GE(expected + expected / 8, snapshot.Percentile(percentile)) << percentile;
+  }
+  EXPECT_EQ(snapshot.max, snapshot.Percentile(100));
+}
+
+TEST(LatencyHistogramTest, BEH_MergeSnapshots) {
+  LatencyHistogram low, high;
+  for (int i(1); i <= 500; ++i) {
+    low.Record(std::chrono::microseconds(i));
+    high.Record(std::chrono::microseconds(500 + i));
+  }
+  LatencyHistogram::Snapshot merged;
+  merged.Merge(low.GetSnapshot());
+  merged.Merge(high.GetSnapshot());
+  EXPECT_EQ(1000U, merged.count);
+  EXPECT_EQ(std::chrono::microseconds(1000), merged.max);
+  EXPECT_EQ(std::chrono::nanoseconds(500500), merged.Mean());
+  EXPECT_LE(std::chrono::microseconds(500), merged.Percentile(50));
+  EXPECT_GE(std::chrono::microseconds(500) + std::chrono::microseconds(500) / 8,
+            merged.Percentile(50));
+}
+
+TEST(LatencyHistogramTest, BEH_ConcurrentRecord) {
+  LatencyHistogram histogram;
+  const int kThreadCount(4), kRecordCount(10000);
+  std::vector<std::thread> threads;
+  for (int i(0); i != kThreadCount; ++i) {
+    threads.emplace_back([&, i] {
+      for (int j(0); j != kRecordCount; ++j)
+        histogram.Record(Duration(i * kRecordCount + j));
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  auto snapshot(histogram.GetSnapshot());
+  EXPECT_EQ(static_cast<std::uint64_t>(kThreadCount * kRecordCount), snapshot.count);
+  EXPECT_EQ(Duration(kThreadCount * kRecordCount - 1), snapshot.max);
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
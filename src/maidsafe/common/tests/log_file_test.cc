@@ -0,0 +1,159 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/log_file.h"
+
+#include <cstdint>
+#include <string>
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/active.h"
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace test {
+
+namespace {
+
+using log::detail::LogFile;
+
+// Ten bytes each.
+std::string Line(int index) { return "line " + std::to_string(1000 + index) + "\n"; }
+
+std::string Lines(int first, int last) {
+  std::string lines;
+  for (int i(first); i <= last; ++i)
+    lines += Line(i);
+  return lines;
+}
+
+std::string Contents(const fs::path& path) {
+  const auto contents(ReadFile(path));
+  return contents ? std::string(contents->begin(), contents->end()) : std::string();
+}
+
+}  // unnamed namespace
+
+TEST(LogFileTest, BEH_Buffering) {
+  TestPath test_path(CreateTestPath("MaidSafe_TestLogFile"));
+  const fs::path path(*test_path / "test.log");
+  LogFile::Options options;
+  options.buffer_size = 100;
+  LogFile log_file;
+  log_file.Open(path, options);
+  ASSERT_TRUE(fs::exists(path));
+
+  // Nothing is written until the buffer is full, unless a flush is asked for.
+  log_file.Write(Line(0), false);
+  EXPECT_EQ(0U, fs::file_size(path));
+  log_file.Write(Line(1), true);
+  EXPECT_EQ(Lines(0, 1), Contents(path));
+  for (int i(2); i < 12; ++i)
+    log_file.Write(Line(i), false);
+  EXPECT_EQ(Lines(0, 1), Contents(path));
+  log_file.Write(Line(12), false);
+  EXPECT_EQ(Lines(0, 12), Contents(path));
+  log_file.Write(Line(13), false);
+  EXPECT_EQ(Lines(0, 12), Contents(path));
+  log_file.Flush();
+  EXPECT_EQ(Lines(0, 13), Contents(path));
+
+  // Reopening truncates, and a zero buffer size writes each message out immediately.
+  log_file.Open(path, LogFile::Options());
+  EXPECT_EQ(0U, fs::file_size(path));
+  log_file.Write(Line(0), false);
+  EXPECT_EQ(Lines(0, 0), Contents(path));
+
+  // Anything still buffered is written out on destruction.
+  {
+    LogFile buffered_file;
+    buffered_file.Open(path, options);
+    buffered_file.Write(Line(0), false);
+    EXPECT_EQ(0U, fs::file_size(path));
+  }
+  EXPECT_EQ(Lines(0, 0), Contents(path));
+}
+
+TEST(LogFileTest, BEH_Rotation) {
+  TestPath test_path(CreateTestPath("MaidSafe_TestLogFile"));
+  const fs::path path(*test_path / "test.log");
+  LogFile::Options options;
+  options.buffer_size = 30;
+  options.max_file_size = 100;
+  options.max_rotated_files = 2;
+  {
+    LogFile log_file;
+    log_file.Open(path, options);
+    for (int i(0); i < 45; ++i)
+      log_file.Write(Line(i), false);
+  }
+
+  // Each file holds ten lines, and only the two most recently rotated are kept.
+  EXPECT_EQ(fs::path(*test_path / "test.3.log"), LogFile::RotatedPath(path, 3));
+  EXPECT_FALSE(fs::exists(LogFile::RotatedPath(path, 1)));
+  EXPECT_FALSE(fs::exists(LogFile::RotatedPath(path, 2)));
+  EXPECT_EQ(Lines(20, 29), Contents(LogFile::RotatedPath(path, 3)));
+  EXPECT_EQ(Lines(30, 39), Contents(LogFile::RotatedPath(path, 4)));
+  EXPECT_FALSE(fs::exists(LogFile::RotatedPath(path, 5)));
+  EXPECT_EQ(Lines(40, 44), Contents(path));
+}
+
+TEST(LogFileTest, BEH_CompressRotated) {
+  TestPath test_path(CreateTestPath("MaidSafe_TestLogFile"));
+  const fs::path path(*test_path / "test.log");
+  auto compressed_path = [&](int index) {
+    fs::path rotated_path(LogFile::RotatedPath(path, static_cast<unsigned>(index)));
+    rotated_path += ".gz";
+    return rotated_path;
+  };
+  {
+    // Destroying the compressor waits for it to finish.
+    Active compressor;
+    LogFile::Options options;
+    options.max_file_size = 100;
+    options.max_rotated_files = 2;
+    options.compressor = &compressor;
+    LogFile log_file;
+    log_file.Open(path, options);
+    for (int i(0); i < 35; ++i)
+      log_file.Write(Line(i), false);
+  }
+
+  EXPECT_FALSE(fs::exists(LogFile::RotatedPath(path, 1)));
+  EXPECT_FALSE(fs::exists(compressed_path(1)));
+  for (int index(2); index < 4; ++index) {
+    EXPECT_FALSE(fs::exists(LogFile::RotatedPath(path, static_cast<unsigned>(index))));
+    const auto compressed(ReadFile(compressed_path(index)));
+    ASSERT_TRUE(compressed);
+    const crypto::UncompressedText uncompressed(
+        crypto::Uncompress(crypto::CompressedText(NonEmptyString(*compressed))));
+    EXPECT_EQ(Lines((index - 1) * 10, index * 10 - 1),
+              std::string(uncompressed.string().begin(), uncompressed.string().end()));
+  }
+  EXPECT_EQ(Lines(30, 34), Contents(path));
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
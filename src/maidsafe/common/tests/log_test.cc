@@ -0,0 +1,207 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/log.h"
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/latency_histogram.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+class LogTest : public testing::Test {
+ protected:
+  LogTest()
+      : kOriginalFilter_(log::Logging::Instance().Filter()),
+        kOriginalNoLogToConsole_(log::Logging::Instance().no_log_to_console_),
+        kOriginalNoAsync_(log::Logging::Instance().no_async_),
+        kOriginallyHadBackground_(log::Logging::Instance().background_ != nullptr) {}
+  ~LogTest() {
+    log::Logging::Instance().StopBinaryLog();
+    if (!kOriginallyHadBackground_)
+      log::Logging::Instance().background_.reset();
+    log::Logging::Instance().no_async_ = kOriginalNoAsync_;
+    log::Logging::Instance().SetFilter(kOriginalFilter_);
+    log::Logging::Instance().no_log_to_console_ = kOriginalNoLogToConsole_;
+  }
+
+  // Files in this project which aren't under a "maidsafe" directory are logged as "common".
+  void SetCommonLevel(int level) { SetFilter({{"common", level}}); }
+  void SetFilter(log::FilterMap filter) { log::Logging::Instance().SetFilter(std::move(filter)); }
+  void DisableConsole() { log::Logging::Instance().no_log_to_console_ = true; }
+  // Switches to the default asynchronous backend, even if logging hasn't been initialised.
+  void UseAsync() {
+    log::Logging& logging(log::Logging::Instance());
+    logging.StopBinaryLog();
+    logging.no_async_ = false;
+    if (!logging.background_)
+      logging.StartBackground(0);
+  }
+  void UseBinary(log::detail::BinaryLog::OverflowPolicy overflow_policy) {
+    UseAsync();
+    log::Logging::Instance().StartBinaryLog(overflow_policy);
+  }
+  std::uint64_t BinaryDropped() const { return log::Logging::Instance().binary_log_->Dropped(); }
+  // Blocks until everything logged so far by this thread has been output.
+  void WaitForOutput() {
+    log::Logging::Instance().Flush();
+    std::promise<void> done;
+    log::Logging::Instance().Send([&done] { done.set_value(); });
+    done.get_future().wait();
+  }
+
+  const log::FilterMap kOriginalFilter_;
+  const bool kOriginalNoLogToConsole_, kOriginalNoAsync_, kOriginallyHadBackground_;
+};
+
+namespace {
+
+int Count(int& evaluations) { return ++evaluations; }
+
+// Each call uses the same LOG statement, and so the same cached decision.
+void LogVerbose(int& evaluations) { LOG(kVerbose) << "Evaluation " << Count(evaluations); }
+
+}  // unnamed namespace
+
+TEST_F(LogTest, BEH_FilterDecisionCached) {
+  DisableConsole();
+  int evaluations(0);
+  SetCommonLevel(log::kError);
+  for (int i(0); i < 3; ++i)
+    LogVerbose(evaluations);
+  // Values streamed into a filtered-out statement aren't evaluated.
+  EXPECT_EQ(0, evaluations);
+
+  // Changing the filter invalidates the cached decision.  If logging is compiled out, nothing is
+  // ever evaluated.
+  SetCommonLevel(log::kVerbose);
+  for (int i(0); i < 3; ++i)
+    LogVerbose(evaluations);
+#if USE_LOGGING
+  EXPECT_EQ(3, evaluations);
+#else
+  EXPECT_EQ(0, evaluations);
+#endif
+
+  SetFilter(log::FilterMap());
+  LogVerbose(evaluations);
+#if USE_LOGGING
+  EXPECT_EQ(3, evaluations);
+#else
+  EXPECT_EQ(0, evaluations);
+#endif
+}
+
+namespace {
+
+// The filter check as it was before decisions were cached per call site.
+bool UncachedShouldLog(const std::string& project, int level) {
+  const log::FilterMap filter(log::Logging::Instance().Filter());
+  const auto itr(filter.find(project));
+  return itr != filter.end() && itr->second <= level;
+}
+
+template <typename Functor>
+double NanosecondsPerCall(int count, Functor functor) {
+  const auto start(std::chrono::steady_clock::now());
+  for (int i(0); i < count; ++i)
+    functor(i);
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+             .count() / count;
+}
+
+}  // unnamed namespace
+
+TEST_F(LogTest, FUNC_FilteredAndUnfiltered) {
+  DisableConsole();
+  const int count(1000000);
+  SetCommonLevel(log::kInfo);
+  int sink(0);
+  const double uncached(NanosecondsPerCall(count, [&](int i) {
+    if (UncachedShouldLog(std::string("common"), log::kVerbose))
+      sink += i;
+  }));
+  const double filtered(
+      NanosecondsPerCall(count, [](int i) { LOG(kVerbose) << "Filtered " << i; }));
+  const double unfiltered(
+      NanosecondsPerCall(count / 10, [](int i) { LOG(kInfo) << "Unfiltered " << i; }));
+  TLOG(kGreen) << "Filtered-out LOG statement: " << filtered
+               << " ns (the filter check alone used to cost " << uncached
+               << " ns), LOG statement passing the filter: " << unfiltered << " ns\n";
+  EXPECT_EQ(0, sink);
+}
+
+namespace {
+
+// Logs 'count' messages from each of 'thread_count' threads, recording the time taken by each LOG
+// statement.
+void LogFromThreads(int thread_count, int count, LatencyHistogram& latency) {
+  std::vector<std::thread> threads;
+  for (int i(0); i < thread_count; ++i) {
+    threads.emplace_back([i, count, &latency] {
+      for (int j(0); j < count; ++j) {
+        const auto start(std::chrono::steady_clock::now());
+        LOG(kInfo) << "Message " << j << " of " << count << " from thread " << i << ": " << 0.5;
+        latency.Record(std::chrono::steady_clock::now() - start);
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+}
+
+}  // unnamed namespace
+
+TEST_F(LogTest, FUNC_BinaryVersusAsync) {
+  DisableConsole();
+  SetCommonLevel(log::kInfo);
+  const int thread_count(4), count(100000);
+  const auto measure([&](const std::string& backend) {
+    LatencyHistogram latency;
+    const auto start(std::chrono::steady_clock::now());
+    LogFromThreads(thread_count, count, latency);
+    WaitForOutput();
+    const double seconds(
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    const auto snapshot(latency.GetSnapshot());
+    TLOG(kGreen) << backend << ": " << static_cast<int>(thread_count * count / seconds)
+                 << " messages/s, LOG statement mean " << snapshot.Mean().count()
+                 << " ns, p99 " << snapshot.Percentile(99).count() << " ns, max "
+                 << snapshot.max.count() << " ns\n";
+  });
+  UseAsync();
+  measure("Asynchronous");
+  UseBinary(log::detail::BinaryLog::OverflowPolicy::kBlock);
+  measure("Binary, blocking when full");
+  UseBinary(log::detail::BinaryLog::OverflowPolicy::kDrop);
+  measure("Binary, dropping when full");
+  TLOG(kGreen) << BinaryDropped() << " of " << thread_count * count << " messages dropped\n";
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,54 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/periodic_thread.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(PeriodicThreadTest, BEH_CallsUntilDestroyed) {
+  std::atomic<int> count(0);
+  {
+    PeriodicThread periodic_thread([&] { ++count; }, std::chrono::milliseconds(5));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  const int final_count(count.load());
+  EXPECT_LT(0, final_count);
+  // Nothing is called once destroyed.
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(final_count, count.load());
+}
+
+TEST(PeriodicThreadTest, BEH_DestroyWithoutWaiting) {
+  const auto start(std::chrono::steady_clock::now());
+  {
+    PeriodicThread periodic_thread([] {}, std::chrono::hours(1));
+  }
+  EXPECT_GT(std::chrono::seconds(10), std::chrono::steady_clock::now() - start);
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
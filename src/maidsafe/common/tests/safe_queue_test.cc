@@ -0,0 +1,231 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/safe_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(SafeQueueTest, BEH_Unbounded) {
+  SafeQueue<int> queue;
+  EXPECT_TRUE(queue.Empty());
+  for (int i(0); i < 100; ++i)
+    EXPECT_TRUE(queue.TryPush(i));
+  queue.Push(100);
+  EXPECT_EQ(101U, queue.Size());
+  int element(-1);
+  for (int i(0); i <= 100; ++i) {
+    ASSERT_TRUE(queue.TryPop(element));
+    EXPECT_EQ(i, element);
+  }
+  EXPECT_FALSE(queue.TryPop(element));
+}
+
+TEST(SafeQueueTest, BEH_Bounded) {
+  SafeQueue<std::unique_ptr<int>> queue(2);
+  EXPECT_EQ(2U, queue.Capacity());
+  queue.Push(std::unique_ptr<int>(new int(0)));
+  EXPECT_TRUE(queue.TryPush(std::unique_ptr<int>(new int(1))));
+  // A failed push leaves the element with the caller.
+  std::unique_ptr<int> rejected(new int(2));
+  EXPECT_FALSE(queue.TryPush(std::move(rejected)));
+  ASSERT_TRUE(rejected != nullptr);
+  const auto start(std::chrono::steady_clock::now());
+  EXPECT_FALSE(queue.PushFor(std::move(rejected), std::chrono::milliseconds(50)));
+  EXPECT_LE(std::chrono::milliseconds(50), std::chrono::steady_clock::now() - start);
+  ASSERT_TRUE(rejected != nullptr);
+
+  // Push blocks until the consumer makes room.
+  std::thread consumer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::unique_ptr<int> element;
+    queue.WaitAndPop(element);
+    EXPECT_EQ(0, *element);
+  });
+  queue.Push(std::move(rejected));
+  consumer.join();
+  EXPECT_EQ(2U, queue.Size());
+
+  std::thread slow_consumer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::vector<std::unique_ptr<int>> elements;
+    EXPECT_EQ(2U, queue.PopAll(elements));
+  });
+  EXPECT_TRUE(queue.PushFor(std::unique_ptr<int>(new int(3)), std::chrono::seconds(10)));
+  slow_consumer.join();
+  EXPECT_EQ(1U, queue.Size());
+}
+
+TEST(SafeQueueTest, BEH_WaitAndPopFor) {
+  SafeQueue<std::string> queue;
+  std::string element;
+  const auto start(std::chrono::steady_clock::now());
+  EXPECT_FALSE(queue.WaitAndPopFor(element, std::chrono::milliseconds(50)));
+  EXPECT_LE(std::chrono::milliseconds(50), std::chrono::steady_clock::now() - start);
+
+  std::thread producer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.Push("element");
+  });
+  EXPECT_TRUE(queue.WaitAndPopFor(element, std::chrono::seconds(10)));
+  EXPECT_EQ("element", element);
+  producer.join();
+}
+
+TEST(SafeQueueTest, BEH_Batch) {
+  SafeQueue<int> queue;
+  for (int i(0); i < 10; ++i)
+    queue.Push(i);
+  std::vector<int> elements(1, -1);
+  EXPECT_EQ(4U, queue.PopUpTo(elements, 4));
+  EXPECT_EQ(6U, queue.PopAll(elements));
+  EXPECT_EQ(0U, queue.PopAll(elements));
+  ASSERT_EQ(11U, elements.size());
+  for (int i(0); i < 10; ++i)
+    EXPECT_EQ(i, elements[i + 1]);
+}
+
+TEST(SafeQueueTest, BEH_SpscQueue) {
+  SpscQueue<int> queue(5);
+  EXPECT_EQ(8U, queue.Capacity());
+  int element(-1);
+  EXPECT_FALSE(queue.TryPop(element));
+  // Wraps around the ring several times.
+  for (int round(0); round < 3; ++round) {
+    for (int i(0); i < 8; ++i)
+      EXPECT_TRUE(queue.TryPush(round * 8 + i));
+    EXPECT_FALSE(queue.TryPush(-1));
+    EXPECT_EQ(8U, queue.Size());
+    ASSERT_TRUE(queue.TryPop(element));
+    EXPECT_EQ(round * 8, element);
+    std::vector<int> elements;
+    EXPECT_EQ(3U, queue.PopUpTo(elements, 3));
+    EXPECT_EQ(4U, queue.PopAll(elements));
+    for (int i(0); i < 7; ++i)
+      EXPECT_EQ(round * 8 + i + 1, elements[i]);
+  }
+
+  // One producer and one consumer thread.
+  const int count(100000);
+  SpscQueue<int> shared_queue(64);
+  std::thread producer([&] {
+    for (int i(0); i < count; ++i) {
+      while (!shared_queue.TryPush(i))
+        std::this_thread::yield();
+    }
+  });
+  // Size may be called from any thread, and is never more than the capacity.
+  std::atomic<bool> done(false);
+  std::atomic<int> bad_sizes(0);
+  std::thread observer([&] {
+    while (!done) {
+      if (shared_queue.Size() > shared_queue.Capacity())
+        ++bad_sizes;
+    }
+  });
+  std::vector<int> received;
+  while (received.size() < static_cast<size_t>(count)) {
+    if (shared_queue.PopAll(received) == 0)
+      std::this_thread::yield();
+  }
+  producer.join();
+  done = true;
+  observer.join();
+  EXPECT_EQ(0, bad_sizes);
+  for (int i(0); i < count; ++i)
+    ASSERT_EQ(i, received[i]);
+}
+
+namespace {
+
+// Passes 'count' elements from a producer thread to a consumer thread, and returns the elements
+// per microsecond.
+template <typename Push, typename Consume>
+double Transfer(int count, Push push, Consume consume) {
+  const auto start(std::chrono::steady_clock::now());
+  std::thread producer([&] {
+    for (int i(0); i < count; ++i)
+      push(i);
+  });
+  int received(0);
+  while (received < count)
+    received += consume();
+  producer.join();
+  const auto elapsed(std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start));
+  return static_cast<double>(count) / std::max<std::chrono::microseconds::rep>(elapsed.count(), 1);
+}
+
+}  // unnamed namespace
+
+TEST(SafeQueueTest, FUNC_Throughput) {
+  const int count(1 << 21);
+  const size_t capacity(1024);
+  {
+    SafeQueue<int> queue(capacity);
+    const double rate(Transfer(count, [&](int i) { queue.Push(i); }, [&] {
+      int element;
+      queue.WaitAndPop(element);
+      return 1;
+    }));
+    TLOG(kGreen) << "SafeQueue, one element per pop: " << rate << " elements/us\n";
+  }
+  {
+    SafeQueue<int> queue(capacity);
+    std::vector<int> elements;
+    const double rate(Transfer(count, [&](int i) { queue.Push(i); }, [&] {
+      elements.clear();
+      int element;
+      if (!queue.WaitAndPopFor(element, std::chrono::milliseconds(100)))
+        return 0;
+      return 1 + static_cast<int>(queue.PopAll(elements));
+    }));
+    TLOG(kGreen) << "SafeQueue, batched pops: " << rate << " elements/us\n";
+  }
+  {
+    SpscQueue<int> queue(capacity);
+    std::vector<int> elements;
+    const double rate(Transfer(count, [&](int i) {
+      while (!queue.TryPush(i))
+        std::this_thread::yield();
+    }, [&] {
+      elements.clear();
+      const size_t popped(queue.PopAll(elements));
+      if (popped == 0)
+        std::this_thread::yield();
+      return static_cast<int>(popped);
+    }));
+    TLOG(kGreen) << "SpscQueue, batched pops: " << rate << " elements/us\n";
+  }
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,163 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/segment_log.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace test {
+
+namespace {
+
+using KeyType = SegmentLog::KeyType;
+using KeyValueVector = std::vector<std::pair<KeyType, NonEmptyString>>;
+
+KeyValueVector GenerateKeyValuePairs(std::size_t count, std::uint32_t value_size) {
+  KeyValueVector key_value_pairs;
+  for (std::size_t i(0); i != count; ++i) {
+    key_value_pairs.emplace_back(KeyType(MakeIdentity(), DataTypeId(RandomUint32())),
+                                 NonEmptyString(RandomBytes(value_size)));
+  }
+  return key_value_pairs;
+}
+
+std::size_t FileCount(const fs::path& directory) {
+  std::size_t count(0);
+  for (fs::directory_iterator itr(directory), end; itr != end; ++itr)
+    ++count;
+  return count;
+}
+
+}  // unnamed namespace
+
+class SegmentLogTest : public testing::Test {
+ protected:
+  SegmentLogTest() : test_path_(CreateTestPath("MaidSafe_Test_SegmentLog")) {}
+
+  TestPath test_path_;
+};
+
+TEST_F(SegmentLogTest, BEH_Constructor) {
+  EXPECT_THROW(SegmentLog(*test_path_ / "missing"), common_error);
+
+  // Segment files left by a previous instance are discarded.
+  {
+    SegmentLog segment_log(*test_path_);
+    auto key_value_pairs(GenerateKeyValuePairs(1, 100));
+    segment_log.Put(key_value_pairs[0].first, key_value_pairs[0].second);
+  }
+  EXPECT_EQ(1U, FileCount(*test_path_));
+  SegmentLog segment_log(*test_path_);
+  EXPECT_EQ(1U, segment_log.SegmentCount());
+  EXPECT_EQ(1U, FileCount(*test_path_));
+  EXPECT_EQ(0U, fs::file_size(*test_path_ / "segment_0"));
+}
+
+TEST_F(SegmentLogTest, BEH_PutGetRemove) {
+  SegmentLog segment_log(*test_path_);
+  auto key_value_pairs(GenerateKeyValuePairs(100, 1000));
+  for (const auto& key_value : key_value_pairs)
+    EXPECT_NO_THROW(segment_log.Put(key_value.first, key_value.second));
+  for (const auto& key_value : key_value_pairs)
+    EXPECT_EQ(key_value.second, segment_log.Get(key_value.first));
+  // All values should have been appended to a single file.
+  EXPECT_EQ(1U, FileCount(*test_path_));
+
+  NonEmptyString removed;
+  EXPECT_EQ(1000U, segment_log.Remove(key_value_pairs[0].first, &removed));
+  EXPECT_EQ(key_value_pairs[0].second, removed);
+  EXPECT_EQ(1000U, segment_log.Remove(key_value_pairs[1].first, nullptr));
+  EXPECT_THROW(segment_log.Get(key_value_pairs[0].first), common_error);
+  EXPECT_THROW(segment_log.Remove(key_value_pairs[1].first, nullptr), common_error);
+  for (std::size_t i(2); i != key_value_pairs.size(); ++i)
+    EXPECT_EQ(key_value_pairs[i].second, segment_log.Get(key_value_pairs[i].first));
+
+  // Replacing a value.
+  NonEmptyString new_value(RandomBytes(10));
+  EXPECT_NO_THROW(segment_log.Put(key_value_pairs[2].first, new_value));
+  EXPECT_EQ(new_value, segment_log.Get(key_value_pairs[2].first));
+  EXPECT_EQ(10U, segment_log.Remove(key_value_pairs[2].first, nullptr));
+  EXPECT_THROW(segment_log.Get(key_value_pairs[2].first), common_error);
+}
+
+TEST_F(SegmentLogTest, BEH_RolloverAndCompaction) {
+  // Each record is 1000 bytes plus a header of 73 bytes, so each segment holds 4 records.
+  SegmentLog segment_log(*test_path_, 4500, 0.5);
+  auto key_value_pairs(GenerateKeyValuePairs(40, 1000));
+  for (const auto& key_value : key_value_pairs)
+    segment_log.Put(key_value.first, key_value.second);
+  EXPECT_EQ(10U, segment_log.SegmentCount());
+  EXPECT_EQ(10U, FileCount(*test_path_));
+
+  // Removing 3 of every 4 values leaves each sealed segment sparse enough to be compacted.
+  for (std::size_t i(0); i != key_value_pairs.size(); ++i) {
+    if (i % 4 != 0)
+      segment_log.Remove(key_value_pairs[i].first, nullptr);
+  }
+  segment_log.WaitForCompaction();
+  EXPECT_GT(6U, segment_log.SegmentCount());
+  EXPECT_EQ(segment_log.SegmentCount(), FileCount(*test_path_));
+  for (std::size_t i(0); i != key_value_pairs.size(); ++i) {
+    if (i % 4 == 0)
+      EXPECT_EQ(key_value_pairs[i].second, segment_log.Get(key_value_pairs[i].first));
+    else
+      EXPECT_THROW(segment_log.Get(key_value_pairs[i].first), common_error);
+  }
+
+  // Removing everything leaves only the active segment.
+  for (std::size_t i(0); i < key_value_pairs.size(); i += 4)
+    segment_log.Remove(key_value_pairs[i].first, nullptr);
+  segment_log.WaitForCompaction();
+  EXPECT_EQ(1U, segment_log.SegmentCount());
+}
+
+TEST_F(SegmentLogTest, BEH_ChurnUnderConcurrentCompaction) {
+  SegmentLog segment_log(*test_path_, 8 * 1024, 0.5);
+  auto key_value_pairs(GenerateKeyValuePairs(1000, 500));
+  // Keep a sliding window of 50 live values.
+  for (std::size_t i(0); i != key_value_pairs.size(); ++i) {
+    segment_log.Put(key_value_pairs[i].first, key_value_pairs[i].second);
+    if (i >= 50) {
+      ASSERT_EQ(key_value_pairs[i - 50].second,
+                segment_log.Get(key_value_pairs[i - 50].first));
+      segment_log.Remove(key_value_pairs[i - 50].first, nullptr);
+    }
+  }
+  segment_log.WaitForCompaction();
+  for (std::size_t i(key_value_pairs.size() - 50); i != key_value_pairs.size(); ++i)
+    EXPECT_EQ(key_value_pairs[i].second, segment_log.Get(key_value_pairs[i].first));
+  // 50 live values of ~500 bytes need 4 segments; allow for sparse segments not yet compacted.
+  EXPECT_GE(10U, segment_log.SegmentCount());
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
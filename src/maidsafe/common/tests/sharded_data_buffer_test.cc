@@ -0,0 +1,314 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/sharded_data_buffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/data_types/data.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace test {
+
+namespace {
+
+const std::uint32_t OneKB(1024);
+
+using KeyType = ShardedDataBuffer::KeyType;
+using KeyValueVector = std::vector<std::pair<KeyType, NonEmptyString>>;
+
+KeyValueVector GenerateKeyValuePairs(std::size_t count, std::uint32_t value_size) {
+  KeyValueVector key_value_pairs;
+  key_value_pairs.reserve(count);
+  for (std::size_t i(0); i != count; ++i) {
+    key_value_pairs.emplace_back(KeyType(MakeIdentity(), DataTypeId(RandomUint32())),
+                                 NonEmptyString(RandomAlphaNumericBytes(value_size)));
+  }
+  return key_value_pairs;
+}
+
+// Returns the number of operations per second achieved by 'thread_count' threads, each storing,
+// getting and deleting its own slice of 'key_value_pairs'.
+double MeasureThroughput(ShardedDataBuffer& data_buffer, const KeyValueVector& key_value_pairs,
+                         std::size_t thread_count) {
+  std::atomic<bool> failed(false);
+  std::vector<std::thread> threads;
+  auto start(std::chrono::steady_clock::now());
+  for (std::size_t i(0); i != thread_count; ++i) {
+    threads.emplace_back([&, i] {
+      try {
+        for (std::size_t j(i); j < key_value_pairs.size(); j += thread_count)
+          data_buffer.Store(key_value_pairs[j].first, key_value_pairs[j].second);
+        for (std::size_t j(i); j < key_value_pairs.size(); j += thread_count) {
+          if (data_buffer.Get(key_value_pairs[j].first) != key_value_pairs[j].second)
+            failed = true;
+        }
+        for (std::size_t j(i); j < key_value_pairs.size(); j += thread_count)
+          data_buffer.Delete(key_value_pairs[j].first);
+      } catch (const std::exception& e) {
+        LOG(kError) << e.what();
+        failed = true;
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  auto elapsed(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  EXPECT_FALSE(failed);
+  return (3.0 * key_value_pairs.size()) / elapsed;
+}
+
+}  // unnamed namespace
+
+TEST(ShardedDataBufferTest, BEH_Constructor) {
+  EXPECT_NO_THROW(ShardedDataBuffer(MemoryUsage(0), DiskUsage(0), nullptr, 1));
+  EXPECT_NO_THROW(ShardedDataBuffer(MemoryUsage(1), DiskUsage(1), nullptr, 4));
+  EXPECT_THROW(ShardedDataBuffer(MemoryUsage(1), DiskUsage(1), nullptr, 0), common_error);
+  EXPECT_THROW(ShardedDataBuffer(MemoryUsage(2), DiskUsage(1), nullptr, 4), common_error);
+
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
+  fs::path sharded_path(*test_path / "sharded");
+  {
+    ShardedDataBuffer data_buffer(MemoryUsage(OneKB), DiskUsage(4 * OneKB), nullptr, 3,
+                                  sharded_path, true);
+    EXPECT_EQ(3U, data_buffer.ShardCount());
+    for (int i(0); i != 3; ++i)
+      EXPECT_TRUE(fs::exists(sharded_path / ("shard_" + std::to_string(i))));
+  }
+  EXPECT_FALSE(fs::exists(sharded_path));
+}
+
+TEST(ShardedDataBufferTest, BEH_StoreGetDelete) {
+  ShardedDataBuffer data_buffer(MemoryUsage(16 * OneKB), DiskUsage(64 * OneKB), nullptr, 4);
+  auto key_value_pairs(GenerateKeyValuePairs(20, OneKB));
+  for (const auto& key_value : key_value_pairs)
+    EXPECT_NO_THROW(data_buffer.Store(key_value.first, key_value.second));
+  for (const auto& key_value : key_value_pairs)
+    EXPECT_EQ(key_value.second, data_buffer.Get(key_value.first));
+
+  for (std::size_t i(0); i != key_value_pairs.size(); i += 2)
+    EXPECT_NO_THROW(data_buffer.Delete(key_value_pairs[i].first));
+  for (std::size_t i(0); i != key_value_pairs.size(); ++i) {
+    if (i % 2 == 0)
+      EXPECT_THROW(data_buffer.Get(key_value_pairs[i].first), common_error);
+    else
+      EXPECT_EQ(key_value_pairs[i].second, data_buffer.Get(key_value_pairs[i].first));
+  }
+
+  auto shared_value(std::make_shared<const NonEmptyString>(RandomAlphaNumericBytes(OneKB)));
+  KeyType shared_key(MakeIdentity(), DataTypeId(RandomUint32()));
+  EXPECT_NO_THROW(data_buffer.Store(shared_key, shared_value));
+  EXPECT_EQ(shared_value, data_buffer.GetShared(shared_key));
+
+  // Batches are split between the shards and results are returned in the order requested.
+  auto batch(GenerateKeyValuePairs(20, OneKB / 4));
+  EXPECT_NO_THROW(data_buffer.StoreBatch(batch));
+  std::vector<KeyType> batch_keys;
+  for (const auto& key_value : batch)
+    batch_keys.push_back(key_value.first);
+  auto batch_values(data_buffer.GetBatch(batch_keys));
+  ASSERT_EQ(batch.size(), batch_values.size());
+  for (std::size_t i(0); i != batch.size(); ++i) {
+    ASSERT_TRUE(batch_values[i] != nullptr);
+    EXPECT_EQ(batch[i].second, *batch_values[i]);
+  }
+  EXPECT_NO_THROW(data_buffer.DeleteBatch(batch_keys));
+  for (const auto& value : data_buffer.GetBatch(batch_keys))
+    EXPECT_TRUE(value == nullptr);
+
+  std::vector<std::pair<KeyType, ShardedDataBuffer::SharedValue>> shared_batch;
+  for (const auto& key_value : batch) {
+    shared_batch.emplace_back(key_value.first,
+                              std::make_shared<const NonEmptyString>(key_value.second));
+  }
+  EXPECT_NO_THROW(data_buffer.StoreBatch(shared_batch));
+  batch_values = data_buffer.GetBatch(batch_keys);
+  ASSERT_EQ(shared_batch.size(), batch_values.size());
+  for (std::size_t i(0); i != shared_batch.size(); ++i) {
+    ASSERT_TRUE(batch_values[i] != nullptr);
+    EXPECT_EQ(*shared_batch[i].second, *batch_values[i]);
+  }
+
+  // Values too large for a single shard's share of the disk limit should be rejected.
+  EXPECT_THROW(data_buffer.Store(KeyType(MakeIdentity(), DataTypeId(RandomUint32())),
+                                 NonEmptyString(RandomAlphaNumericBytes(17 * OneKB))),
+               common_error);
+}
+
+TEST(ShardedDataBufferTest, BEH_TryGetAndHas) {
+  // Run with and without the shards' negative lookup filters.
+  for (std::size_t expected_key_count : {0, 100}) {
+    ShardedDataBuffer data_buffer(MemoryUsage(4 * OneKB), DiskUsage(16 * OneKB), nullptr, 4,
+                                  ShardedDataBuffer::DiskBackend::kFilePerValue,
+                                  ShardedDataBuffer::EvictionPolicy::kFifo, expected_key_count);
+    auto key_value_pairs(GenerateKeyValuePairs(8, OneKB));
+    for (const auto& key_value : key_value_pairs)
+      data_buffer.Store(key_value.first, key_value.second);
+    for (const auto& key_value : key_value_pairs) {
+      EXPECT_TRUE(data_buffer.Has(key_value.first));
+      auto value(data_buffer.TryGet(key_value.first));
+      ASSERT_TRUE(value);
+      EXPECT_EQ(key_value.second, *value);
+    }
+    const KeyType missing_key(MakeIdentity(), DataTypeId(RandomUint32()));
+    EXPECT_FALSE(data_buffer.Has(missing_key));
+    EXPECT_FALSE(data_buffer.TryGet(missing_key));
+    data_buffer.Delete(key_value_pairs[0].first);
+    EXPECT_FALSE(data_buffer.Has(key_value_pairs[0].first));
+    EXPECT_FALSE(data_buffer.TryGet(key_value_pairs[0].first));
+  }
+}
+
+TEST(ShardedDataBufferTest, BEH_Stats) {
+  ShardedDataBuffer data_buffer(MemoryUsage(16 * OneKB), DiskUsage(64 * OneKB), nullptr, 4);
+  auto key_value_pairs(GenerateKeyValuePairs(20, OneKB));
+  for (const auto& key_value : key_value_pairs)
+    data_buffer.Store(key_value.first, key_value.second);
+  for (const auto& key_value : key_value_pairs)
+    data_buffer.Get(key_value.first);
+  EXPECT_FALSE(data_buffer.TryGet(KeyType(MakeIdentity(), DataTypeId(RandomUint32()))));
+  data_buffer.Delete(key_value_pairs[0].first);
+
+  // Every shard's activity is included in the totals.
+  const auto stats(data_buffer.Stats());
+  EXPECT_EQ(20U, stats.stores);
+  EXPECT_EQ(20U, stats.memory_hits + stats.disk_hits);
+  EXPECT_EQ(1U, stats.misses);
+  EXPECT_EQ(1U, stats.deletes);
+  EXPECT_EQ(20U, stats.store_latency.count);
+  EXPECT_EQ(20U, stats.get_latency.count);
+  EXPECT_EQ(stats.memory.entries * OneKB, stats.memory.bytes);
+  EXPECT_GE(16U * OneKB, stats.memory.bytes);
+  EXPECT_GE(19U, stats.disk.entries);
+}
+
+TEST(ShardedDataBufferTest, BEH_AsyncStoreGetDelete) {
+  AsioService asio_service(2);
+  ShardedDataBuffer data_buffer(MemoryUsage(4 * OneKB), DiskUsage(16 * OneKB), nullptr, 4);
+  auto key_value_pairs(GenerateKeyValuePairs(8, OneKB));
+  std::vector<std::future<void>> stores;
+  for (const auto& key_value : key_value_pairs)
+    stores.push_back(data_buffer.StoreAsync(asio_service, key_value.first, key_value.second));
+  for (auto& store : stores)
+    EXPECT_NO_THROW(store.get());
+  for (const auto& key_value : key_value_pairs)
+    EXPECT_EQ(key_value.second, data_buffer.GetAsync(asio_service, key_value.first).get());
+
+  const KeyType key(key_value_pairs[0].first);
+  EXPECT_NO_THROW(data_buffer.DeleteAsync(asio_service, key).get());
+  std::promise<std::error_code> get_result;
+  data_buffer.GetAsync(asio_service, key, [&](std::error_code error, NonEmptyString) {
+    get_result.set_value(error);
+  });
+  EXPECT_EQ(make_error_code(CommonErrors::no_such_element), get_result.get_future().get());
+  std::promise<std::error_code> store_result;
+  data_buffer.StoreAsync(asio_service, key, key_value_pairs[0].second,
+                         [&](std::error_code error) { store_result.set_value(error); });
+  EXPECT_FALSE(store_result.get_future().get());
+  std::promise<std::error_code> delete_result;
+  data_buffer.DeleteAsync(asio_service, key,
+                          [&](std::error_code error) { delete_result.set_value(error); });
+  EXPECT_FALSE(delete_result.get_future().get());
+  EXPECT_THROW(data_buffer.Get(key), common_error);
+}
+
+TEST(ShardedDataBufferTest, BEH_DeleteWithPredicate) {
+  ShardedDataBuffer data_buffer(MemoryUsage(16 * OneKB), DiskUsage(64 * OneKB), nullptr, 4);
+  auto key_value_pairs(GenerateKeyValuePairs(20, OneKB));
+  for (const auto& key_value : key_value_pairs)
+    data_buffer.Store(key_value.first, key_value.second);
+
+  data_buffer.Delete([](const KeyType& key) { return key.type_id.data % 2 == 0; });
+  for (const auto& key_value : key_value_pairs) {
+    if (key_value.first.type_id.data % 2 == 0)
+      EXPECT_THROW(data_buffer.Get(key_value.first), common_error);
+    else
+      EXPECT_EQ(key_value.second, data_buffer.Get(key_value.first));
+  }
+}
+
+TEST(ShardedDataBufferTest, BEH_PopOnDiskBufferOverfill) {
+  std::mutex mutex;
+  std::vector<KeyType> popped_keys;
+  ShardedDataBuffer data_buffer(MemoryUsage(0), DiskUsage(8 * OneKB),
+                                [&](const KeyType& key, const NonEmptyString&) {
+                                  std::lock_guard<std::mutex> lock(mutex);
+                                  popped_keys.push_back(key);
+                                },
+                                2);
+  auto key_value_pairs(GenerateKeyValuePairs(20, OneKB));
+  for (const auto& key_value : key_value_pairs)
+    EXPECT_NO_THROW(data_buffer.Store(key_value.first, key_value.second));
+
+  // Each shard holds at most 4 values, so at least 12 must have been popped.
+  std::lock_guard<std::mutex> lock(mutex);
+  EXPECT_LE(12U, popped_keys.size());
+  for (const auto& key : popped_keys)
+    EXPECT_THROW(data_buffer.Get(key), common_error);
+}
+
+TEST(ShardedDataBufferTest, BEH_SetMaxUsage) {
+  ShardedDataBuffer data_buffer(MemoryUsage(4 * OneKB), DiskUsage(8 * OneKB), nullptr, 3);
+  EXPECT_THROW(data_buffer.SetMaxMemoryUsage(MemoryUsage(8 * OneKB + 1)), common_error);
+  EXPECT_NO_THROW(data_buffer.SetMaxMemoryUsage(MemoryUsage(8 * OneKB)));
+  EXPECT_THROW(data_buffer.SetMaxDiskUsage(DiskUsage(8 * OneKB - 1)), common_error);
+  EXPECT_NO_THROW(data_buffer.SetMaxDiskUsage(DiskUsage(16 * OneKB)));
+  // Uneven totals must still leave every shard's memory share within its disk share.
+  EXPECT_NO_THROW(data_buffer.SetMaxMemoryUsage(MemoryUsage(16 * OneKB)));
+  EXPECT_NO_THROW(data_buffer.SetMaxDiskUsage(DiskUsage(16 * OneKB + 1)));
+  EXPECT_NO_THROW(data_buffer.SetMaxMemoryUsage(MemoryUsage(16 * OneKB + 1)));
+}
+
+TEST(ShardedDataBufferTest, FUNC_MultipleThreadsThroughput) {
+  const std::size_t thread_count(std::max(4U, Concurrency()));
+  const std::size_t entry_count(4000);
+  auto key_value_pairs(GenerateKeyValuePairs(entry_count, OneKB));
+  // Half of the values fit in memory, all of them fit on disk.
+  const MemoryUsage max_memory_usage(entry_count * OneKB / 2);
+  const DiskUsage max_disk_usage(2 * entry_count * OneKB);
+  for (std::size_t shard_count : {std::size_t(1), thread_count}) {
+    ShardedDataBuffer data_buffer(max_memory_usage, max_disk_usage, nullptr, shard_count);
+    auto ops_per_second(MeasureThroughput(data_buffer, key_value_pairs, thread_count));
+    TLOG(kGreen) << thread_count << " threads, " << shard_count << " shard(s): "
+                 << static_cast<std::uint64_t>(ops_per_second) << " ops/s\n";
+  }
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,219 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(ThreadPoolTest, BEH_PostAndSubmit) {
+  std::atomic<int> count(0);
+  {
+    ThreadPool pool(4);
+    EXPECT_EQ(4U, pool.ThreadCount());
+    for (int i(0); i < 1000; ++i)
+      pool.Post([&count] { ++count; });
+    // A throwing task doesn't stop the worker.
+    pool.Post([] { throw std::runtime_error("Test"); });
+
+    auto result(pool.Submit([] { return std::string("result"); }));
+    EXPECT_EQ("result", result.get());
+    auto failure(pool.Submit([]() -> int { throw std::runtime_error("Test"); }));
+    EXPECT_THROW(failure.get(), std::runtime_error);
+  }
+  // The destructor runs all posted tasks.
+  EXPECT_EQ(1000, count);
+  ThreadPool default_pool;
+  EXPECT_EQ(Concurrency(), default_pool.ThreadCount());
+}
+
+TEST(ThreadPoolTest, BEH_NestedTasks) {
+  // Tasks posting tasks (and waiting for them via ParallelFor) must not deadlock, even with a
+  // single worker.
+  for (unsigned int thread_count(1); thread_count <= 4; thread_count *= 2) {
+    ThreadPool pool(thread_count);
+    std::atomic<int> count(0);
+    std::vector<std::future<void>> futures;
+    for (int i(0); i < 8; ++i) {
+      futures.push_back(pool.Submit([&] {
+        pool.ParallelFor(0, 100, [&](int) { ++count; });
+        pool.Post([&count] { ++count; });
+      }));
+    }
+    for (auto& future : futures)
+      future.get();
+    EXPECT_LE(800, count);
+  }
+}
+
+TEST(ThreadPoolTest, BEH_PostBetweenPools) {
+  // A worker of one pool is an outside thread to another, whatever its index.
+  ThreadPool pool(4), other_pool(1);
+  std::atomic<int> count(0);
+  std::vector<std::future<void>> futures;
+  for (int i(0); i < 100; ++i) {
+    futures.push_back(pool.Submit([&] {
+      other_pool.Submit([&count] { ++count; }).get();
+      pool.Post([&count] { ++count; });
+    }));
+  }
+  for (auto& future : futures)
+    future.get();
+  EXPECT_LE(100, count);
+}
+
+TEST(ThreadPoolTest, BEH_ParallelFor) {
+  ThreadPool pool(4);
+  for (const int size : {0, 1, 3, 17, 1000}) {
+    std::vector<int> hits(size, 0);
+    pool.ParallelFor(0, size, [&](int i) { ++hits[i]; });
+    for (const auto hit : hits)
+      ASSERT_EQ(1, hit) << size;
+  }
+  // An empty or reversed range does nothing.
+  pool.ParallelFor(10, 5, [](int) { FAIL(); });
+
+  std::atomic<int> count(0);
+  EXPECT_THROW(pool.ParallelFor(std::size_t(0), std::size_t(100), [&](std::size_t i) {
+    ++count;
+    if (i == 50)
+      throw std::runtime_error("Test");
+  }), std::runtime_error);
+  // Chunks other than the one which threw still run to completion.
+  EXPECT_LT(90, count);
+}
+
+TEST(ThreadPoolTest, BEH_ParallelMap) {
+  ThreadPool pool(3);
+  std::vector<int> inputs;
+  for (int i(0); i < 500; ++i)
+    inputs.push_back(i);
+  const auto outputs(pool.ParallelMap(inputs, [](int input) { return std::to_string(input); }));
+  ASSERT_EQ(inputs.size(), outputs.size());
+  for (std::size_t i(0); i != inputs.size(); ++i)
+    EXPECT_EQ(std::to_string(inputs[i]), outputs[i]);
+}
+
+TEST(ThreadPoolTest, BEH_ParallelMapBools) {
+  // Bool results are packed into a std::vector<bool>, but must not be written to it concurrently.
+  ThreadPool pool(4);
+  std::vector<int> inputs;
+  for (int i(0); i < 10000; ++i)
+    inputs.push_back(i);
+  const std::vector<bool> outputs(
+      pool.ParallelMap(inputs, [](int input) { return input % 3 == 0; }));
+  ASSERT_EQ(inputs.size(), outputs.size());
+  for (std::size_t i(0); i != inputs.size(); ++i)
+    EXPECT_EQ(inputs[i] % 3 == 0, outputs[i]) << i;
+}
+
+namespace {
+
+// A few microseconds of CPU-bound work.
+std::uint64_t Work(std::uint64_t seed) {
+  for (int i(0); i < 2000; ++i)
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return seed;
+}
+
+template <typename Post>
+double TimeTasks(int task_count, Post post) {
+  std::atomic<std::uint64_t> result(0);
+  std::atomic<int> remaining(task_count);
+  std::promise<void> done;
+  const auto start(std::chrono::steady_clock::now());
+  for (int i(0); i < task_count; ++i) {
+    post([&, i] {
+      result += Work(i);
+      if (--remaining == 0)
+        done.set_value();
+    });
+  }
+  done.get_future().wait();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // unnamed namespace
+
+TEST(ThreadPoolTest, FUNC_CompareWithAsioService) {
+  const int task_count(200000);
+  const unsigned int thread_count(Concurrency());
+  AsioService asio_service(thread_count);
+  ThreadPool pool(thread_count);
+
+  const double asio_time(TimeTasks(task_count, [&](std::function<void()> task) {
+    asio_service.service().post(std::move(task));
+  }));
+  const double pool_time(TimeTasks(task_count, [&](ThreadPool::Task task) {
+    pool.Post(std::move(task));
+  }));
+  TLOG(kGreen) << task_count << " tasks posted from one thread on " << thread_count
+               << " threads: AsioService " << asio_time << " ms, ThreadPool " << pool_time
+               << " ms\n";
+
+  // Each task spawns subtasks, and the last subtask to finish completes the task.  Subtasks
+  // posted to the ThreadPool stay on the spawning worker unless stolen.
+  const int fan_out(100);
+  const auto spawn([&](std::function<void(std::function<void()>)> post_subtask,
+                       std::function<void()> task) {
+    auto remaining(std::make_shared<std::atomic<int>>(fan_out));
+    for (int i(0); i < fan_out; ++i) {
+      post_subtask([remaining, task, i] {
+        Work(i);
+        if (--*remaining == 0)
+          task();
+      });
+    }
+  });
+  const double asio_nested_time(TimeTasks(task_count / fan_out, [&](std::function<void()> task) {
+    asio_service.service().post([&, task] {
+      spawn([&](std::function<void()> subtask) {
+        asio_service.service().post(std::move(subtask));
+      }, task);
+    });
+  }));
+  const double pool_nested_time(TimeTasks(task_count / fan_out, [&](ThreadPool::Task task) {
+    pool.Post([&, task] {
+      spawn([&](std::function<void()> subtask) { pool.Post(std::move(subtask)); }, task);
+    });
+  }));
+  TLOG(kGreen) << task_count / fan_out << " tasks each spawning " << fan_out
+               << " subtasks: AsioService " << asio_nested_time << " ms, ThreadPool "
+               << pool_nested_time << " ms\n";
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
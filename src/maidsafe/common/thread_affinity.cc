@@ -0,0 +1,63 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/thread_affinity.h"
+
+#include <algorithm>
+#include <thread>
+
+#ifdef _MSC_VER
+#include "windows.h"  // NOLINT
+#endif
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+bool PinCurrentThreadToCpu(unsigned int cpu) {
+  const unsigned int cpu_count(std::max(std::thread::hardware_concurrency(), 1U));
+  cpu %= cpu_count;
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+  const int result(pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set));
+  if (result != 0) {
+    LOG(kWarning) << "Failed to pin thread to CPU " << cpu << ": error " << result;
+    return false;
+  }
+  return true;
+#elif defined(_MSC_VER)
+  if (cpu >= sizeof(DWORD_PTR) * 8 ||
+      SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) == 0) {
+    LOG(kWarning) << "Failed to pin thread to CPU " << cpu;
+    return false;
+  }
+  return true;
+#else
+  LOG(kWarning) << "Pinning threads to CPUs isn't supported on this platform.";
+  return false;
+#endif
+}
+
+}  // namespace maidsafe
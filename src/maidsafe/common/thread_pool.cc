@@ -0,0 +1,167 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/thread_pool.h"
+
+#include "boost/exception/diagnostic_information.hpp"
+
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+ParallelForState::ParallelForState(std::size_t chunk_count,
+                                   std::function<void(std::size_t)> run_chunk)
+    : chunk_count_(chunk_count),
+      run_chunk_(std::move(run_chunk)),
+      next_chunk_(0),
+      completed_(0),
+      exception_(),
+      mutex_(),
+      condition_() {}
+
+void ParallelForState::Work() {
+  std::size_t chunk(next_chunk_++);
+  while (chunk < chunk_count_) {
+    std::exception_ptr exception;
+    try {
+      run_chunk_(chunk);
+    } catch (...) {
+      exception = std::current_exception();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (exception && !exception_)
+        exception_ = exception;
+      if (++completed_ == chunk_count_)
+        condition_.notify_all();
+    }
+    chunk = next_chunk_++;
+  }
+}
+
+void ParallelForState::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  condition_.wait(lock, [this] { return completed_ == chunk_count_; });
+  if (exception_)
+    std::rethrow_exception(exception_);
+}
+
+}  // namespace detail
+
+ThreadPool::ThreadPool(unsigned int thread_count)
+    : workers_(),
+      queued_(0),
+      sleeping_(0),
+      next_worker_(0),
+      stopping_(false),
+      mutex_(),
+      condition_(),
+      worker_index_() {
+  if (thread_count == 0)
+    thread_count = Concurrency();
+  // All workers must exist before any starts trying to steal from the others.
+  for (unsigned int i(0); i != thread_count; ++i)
+    workers_.emplace_back(new Worker);
+  for (std::size_t i(0); i != workers_.size(); ++i)
+    workers_[i]->thread = std::thread([this, i] { Run(i); });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  condition_.notify_all();
+  for (auto& worker : workers_)
+    worker->thread.join();
+}
+
+void ThreadPool::Post(Task task) {
+  const std::size_t current(CurrentWorker());
+  if (current != workers_.size()) {
+    Worker& worker(*workers_[current]);
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tasks.push_back(std::move(task));
+  } else {
+    Worker& worker(*workers_[next_worker_++ % workers_.size()]);
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tasks.push_front(std::move(task));
+  }
+  // This increment and the check of 'sleeping_' pair with the reverse in Run, so either a
+  // sleeping worker is woken here, or it sees the new task before going to sleep.
+  ++queued_;
+  if (sleeping_ != 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    condition_.notify_one();
+  }
+}
+
+void ThreadPool::Run(std::size_t index) {
+  worker_index_.reset(new std::size_t(index));
+  for (;;) {
+    Task task;
+    if (TryPop(index, task)) {
+      try {
+        task();
+      } catch (...) {
+        LOG(kError) << boost::current_exception_diagnostic_information();
+      }
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++sleeping_;
+    condition_.wait(lock, [this] { return queued_ != 0 || stopping_; });
+    --sleeping_;
+    if (stopping_ && queued_ == 0)
+      return;
+  }
+}
+
+bool ThreadPool::TryPop(std::size_t index, Task& task) {
+  {
+    Worker& own(*workers_[index]);
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      --queued_;
+      return true;
+    }
+  }
+  for (std::size_t i(1); i != workers_.size(); ++i) {
+    Worker& victim(*workers_[(index + i) % workers_.size()]);
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      --queued_;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::size_t ThreadPool::CurrentWorker() const {
+  const std::size_t* const index(worker_index_.get());
+  return index ? *index : workers_.size();
+}
+
+}  // namespace maidsafe
@@ -0,0 +1,143 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+// Replays recorded key traces through LruCache with each eviction policy and reports the hit
+// ratios, to help choose a policy for a given cache.
+//
+// A trace is a text file with one access per line; the first whitespace-separated token of each
+// line is the key, and empty lines or lines starting with '#' are ignored.  Each access is a Get,
+// followed by an Add if the Get missed.
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/variables_map.hpp"
+
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/containers/eviction_policies.h"
+#include "maidsafe/common/containers/lru_cache.h"
+
+namespace po = boost::program_options;
+
+namespace maidsafe {
+
+namespace tools {
+
+namespace {
+
+using Trace = std::vector<std::uint64_t>;
+
+Trace ReadTrace(const std::string& path) {
+  std::ifstream file(path);
+  if (!file)
+    throw std::runtime_error("Failed to open " + path);
+  Trace trace;
+  std::hash<std::string> hash;
+  std::string line, key;
+  while (std::getline(file, line)) {
+    std::istringstream stream(line);
+    if (stream >> key && key[0] != '#')
+      trace.push_back(hash(key));
+  }
+  return trace;
+}
+
+template <typename Policy>
+double HitRatio(const Trace& trace, std::size_t capacity) {
+  LruCache<std::uint64_t, char, std::hash<std::uint64_t>, std::equal_to<std::uint64_t>, Policy>
+      cache(capacity);
+  std::uint64_t hits(0);
+  for (const auto key : trace) {
+    if (cache.Get(key).valid())
+      ++hits;
+    else
+      cache.Add(key, 0);
+  }
+  return trace.empty() ? 0.0 : 100.0 * hits / trace.size();
+}
+
+void Replay(const std::string& path, const std::vector<std::size_t>& capacities) {
+  const Trace trace(ReadTrace(path));
+  TLOG(kGreen) << path << ": " << trace.size() << " accesses\n";
+  TLOG(kDefaultColour) << std::setw(12) << "capacity" << std::setw(10) << "LRU" << std::setw(10)
+                       << "2Q" << std::setw(10) << "ARC" << std::setw(10) << "W-TinyLFU" << '\n';
+  for (const auto capacity : capacities) {
+    TLOG(kDefaultColour) << std::setw(12) << capacity << std::fixed << std::setprecision(2)
+                         << std::setw(9) << HitRatio<LruPolicy>(trace, capacity) << '%'
+                         << std::setw(9) << HitRatio<TwoQueuePolicy>(trace, capacity) << '%'
+                         << std::setw(9) << HitRatio<ArcPolicy>(trace, capacity) << '%'
+                         << std::setw(9) << HitRatio<TinyLfuPolicy>(trace, capacity) << "%\n";
+  }
+}
+
+}  // unnamed namespace
+
+}  // namespace tools
+
+}  // namespace maidsafe
+
+int main(int argc, char* argv[]) {
+  auto unuseds(maidsafe::log::Logging::Instance().Initialise(argc, argv));
+  std::vector<std::string> unused_options;
+  for (const auto& unused : unuseds)
+    unused_options.emplace_back(&unused[0]);
+  // skip the first arg which is the path to this tool
+  unused_options.erase(std::begin(unused_options));
+
+  po::options_description options("Cache trace tool options");
+  options.add_options()("help,h", "Show help message.")(
+      "trace,t", po::value<std::vector<std::string>>(), "Path to a trace file (may be repeated).")(
+      "capacity,c", po::value<std::vector<std::size_t>>(),
+      "Cache capacity in entries (may be repeated).  Defaults to 1000, 10000 and 100000.");
+  po::positional_options_description positional;
+  positional.add("trace", -1);
+
+  try {
+    po::variables_map variables_map;
+    po::store(po::command_line_parser(unused_options)
+                  .options(options)
+                  .positional(positional)
+                  .run(),
+              variables_map);
+    po::notify(variables_map);
+    if (variables_map.count("help") || !variables_map.count("trace")) {
+      TLOG(kYellow) << "Replays key traces through LruCache with each eviction policy and reports "
+                       "the hit ratios.\nEach line of a trace file holds one key.\n\n" << options
+                    << '\n';
+      return variables_map.count("help") ? 0 : -1;
+    }
+
+    std::vector<std::size_t> capacities{1000, 10000, 100000};
+    if (variables_map.count("capacity"))
+      capacities = variables_map["capacity"].as<std::vector<std::size_t>>();
+    for (const auto& path : variables_map["trace"].as<std::vector<std::string>>())
+      maidsafe::tools::Replay(path, capacities);
+  } catch (const std::exception& e) {
+    TLOG(kRed) << "Failed: " << e.what() << '\n';
+    return -2;
+  }
+  return 0;
+}